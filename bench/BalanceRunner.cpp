@@ -0,0 +1,249 @@
+// Пакетный прогон для балансировки: тысячи полных партий бота (AutoPlayer) параллельно на всех ядрах.
+// Каждая партия — своя GameState со своим сидом, идёт через step до экрана смерти. Партии, где бот застрял
+// (STUCK_TURNS ходов подряд без цели: лестница за стенами, до которой не дойти), и слишком длинные
+// (MAX_TURNS) останавливаются и помечаются в отчёте.
+// Статистика экрана смерти (убийства killsRat..killsCrab, предметы itemsMedkit..itemsQuest, этаж, перки)
+// пишется по партии в отчёт CSV или JSON, сводка — в консоль. Главная цифра — партий в секунду на ядро.
+// Партия i играется с сидом seed + i, поэтому отчёт не зависит от числа потоков: тот же запуск
+// на другой машине даёт те же строки (меняется только время).
+//
+// Запуск: ASC11_balance [games] [threads] [report] [perk] [seed]
+//   games   — сколько партий сыграть (по умолчанию 2000)
+//   threads — сколько потоков (0 или без аргумента — по числу ядер)
+//   report  — файл отчёта: *.json — JSON, иначе CSV (по умолчанию asc11_balance.csv)
+//   perk    — 1, 2, 3: бот всегда берёт этот перк, 0 — случайный на каждом этаже (по умолчанию 0)
+//   seed    — сид первой партии (по умолчанию 1)
+
+#include "AutoPlayer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+
+// Потолок длины партии и сколько ходов подряд бот может бродить без цели (AutoPlayer::aimlessTurns).
+const int MAX_TURNS = 20000;
+const int STUCK_TURNS = 200;
+
+enum class Outcome { Died, Stuck, TurnLimit };
+const char* const OUTCOME_NAMES[3] = {"died", "stuck", "turn_limit"};
+
+const char* const KILL_NAMES[ENEMY_TYPE_COUNT] = {"rat", "bear", "snake", "ghost", "crab"};
+const int ITEM_KINDS = 5;
+const char* const ITEM_NAMES[ITEM_KINDS] = {"medkit", "maxhp", "shield", "trap", "quest"};
+
+struct GameResult {
+    uint64_t seed = 0;
+    Outcome outcome = Outcome::Died;
+    int turns = 0;
+    int level = 0;
+    int kills[ENEMY_TYPE_COUNT] = {};
+    int items[ITEM_KINDS] = {};
+    std::vector<std::string> perks;
+    double seconds = 0.0;
+};
+
+GameResult playGame(uint64_t seed, int perk)
+{
+    GameResult result;
+    result.seed = seed;
+    const BenchClock::time_point start = BenchClock::now();
+    GameState game(seed);
+    AutoPlayer bot(seed, perk);
+    while (!game.isDeathScreenActive && result.turns < MAX_TURNS && bot.aimlessTurns() < STUCK_TURNS) {
+        if (step(game, bot.next(game))) {
+            ++result.turns;
+        }
+    }
+    result.outcome = game.isDeathScreenActive          ? Outcome::Died
+                     : bot.aimlessTurns() >= STUCK_TURNS ? Outcome::Stuck
+                                                         : Outcome::TurnLimit;
+    result.level = game.level;
+    const int kills[ENEMY_TYPE_COUNT] = {game.killsRat, game.killsBear, game.killsSnake, game.killsGhost, game.killsCrab};
+    const int items[ITEM_KINDS] = {game.itemsMedkit, game.itemsMaxHP, game.itemsShield, game.itemsTrap, game.itemsQuest};
+    std::copy(kills, kills + ENEMY_TYPE_COUNT, result.kills);
+    std::copy(items, items + ITEM_KINDS, result.items);
+    for (PerkEffect perk : game.collectedPerks) {
+        result.perks.push_back(perkEffectName(perk));
+    }
+    result.seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+    return result;
+}
+
+std::string joinPerks(const std::vector<std::string>& perks)
+{
+    std::string joined;
+    for (const std::string& perk : perks) {
+        if (!joined.empty()) {
+            joined += "|";
+        }
+        joined += perk;
+    }
+    return joined;
+}
+
+bool endsWith(const std::string& text, const std::string& suffix)
+{
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Названия перков — строки из applyLevelChoice без кавычек и запятых, поэтому экранировать нечего.
+bool writeCsv(const char* path, const std::vector<GameResult>& results)
+{
+    std::FILE* file = std::fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    std::fprintf(file, "seed,outcome,turns,level");
+    for (const char* name : KILL_NAMES) {
+        std::fprintf(file, ",kills_%s", name);
+    }
+    for (const char* name : ITEM_NAMES) {
+        std::fprintf(file, ",items_%s", name);
+    }
+    std::fprintf(file, ",perks\n");
+    for (const GameResult& result : results) {
+        std::fprintf(file, "%llu,%s,%d,%d", static_cast<unsigned long long>(result.seed),
+                     OUTCOME_NAMES[static_cast<int>(result.outcome)], result.turns, result.level);
+        for (int kills : result.kills) {
+            std::fprintf(file, ",%d", kills);
+        }
+        for (int items : result.items) {
+            std::fprintf(file, ",%d", items);
+        }
+        std::fprintf(file, ",\"%s\"\n", joinPerks(result.perks).c_str());
+    }
+    return std::fclose(file) == 0;
+}
+
+bool writeJson(const char* path, const std::vector<GameResult>& results, int perk, int threads, double seconds)
+{
+    std::FILE* file = std::fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    std::fprintf(file, "{\"games\":%zu,\"threads\":%d,\"perk\":%d,\"maxTurns\":%d,\"seconds\":%.3f,\"results\":[\n",
+                 results.size(), threads, perk, MAX_TURNS, seconds);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const GameResult& result = results[i];
+        std::fprintf(file, "{\"seed\":%llu,\"outcome\":\"%s\",\"turns\":%d,\"level\":%d,\"kills\":{",
+                     static_cast<unsigned long long>(result.seed), OUTCOME_NAMES[static_cast<int>(result.outcome)], result.turns,
+                     result.level);
+        for (int k = 0; k < ENEMY_TYPE_COUNT; ++k) {
+            std::fprintf(file, "%s\"%s\":%d", k > 0 ? "," : "", KILL_NAMES[k], result.kills[k]);
+        }
+        std::fprintf(file, "},\"items\":{");
+        for (int k = 0; k < ITEM_KINDS; ++k) {
+            std::fprintf(file, "%s\"%s\":%d", k > 0 ? "," : "", ITEM_NAMES[k], result.items[k]);
+        }
+        std::fprintf(file, "},\"perks\":[");
+        for (size_t p = 0; p < result.perks.size(); ++p) {
+            std::fprintf(file, "%s\"%s\"", p > 0 ? "," : "", result.perks[p].c_str());
+        }
+        std::fprintf(file, "]}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "]}\n");
+    return std::fclose(file) == 0;
+}
+
+double percentileOf(std::vector<int> values, double p)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const size_t index = static_cast<size_t>(p / 100.0 * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int games = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+    const int requestedThreads = argc > 2 ? std::atoi(argv[2]) : 0;
+    const std::string reportPath = argc > 3 ? argv[3] : "asc11_balance.csv";
+    const int perk = argc > 4 ? std::atoi(argv[4]) : AutoPlayer::PERK_RANDOM;
+    const uint64_t seed = argc > 5 ? static_cast<uint64_t>(std::atoll(argv[5])) : 1;
+    const int threads = std::min(games, requestedThreads > 0 ? requestedThreads
+                                                             : std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+
+    // Потоки разбирают партии по одной: длина партии сильно разная, поровну поделить заранее нельзя
+    std::vector<GameResult> results(static_cast<size_t>(games));
+    std::atomic<int> nextGame{0};
+    const BenchClock::time_point start = BenchClock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (int i = nextGame.fetch_add(1); i < games; i = nextGame.fetch_add(1)) {
+                results[static_cast<size_t>(i)] = playGame(seed + static_cast<uint64_t>(i), perk);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+    // --- Сводка ---
+    double gameSeconds = 0.0;
+    long long turns = 0;
+    int outcomes[3] = {};
+    std::vector<int> levels;
+    double kills[ENEMY_TYPE_COUNT] = {};
+    double items[ITEM_KINDS] = {};
+    for (const GameResult& result : results) {
+        gameSeconds += result.seconds;
+        turns += result.turns;
+        ++outcomes[static_cast<int>(result.outcome)];
+        levels.push_back(result.level);
+        for (int k = 0; k < ENEMY_TYPE_COUNT; ++k) {
+            kills[k] += result.kills[k];
+        }
+        for (int k = 0; k < ITEM_KINDS; ++k) {
+            items[k] += result.items[k];
+        }
+    }
+    double levelSum = 0.0;
+    for (int level : levels) {
+        levelSum += level;
+    }
+
+    std::printf("ASC11 balance run: %d games on %d threads, perk %s, seeds %llu..%llu\n\n", games, threads,
+                perk >= 1 && perk <= 3 ? std::to_string(perk).c_str() : "random", static_cast<unsigned long long>(seed),
+                static_cast<unsigned long long>(seed) + static_cast<unsigned long long>(games) - 1);
+    // На ядро — по времени самих партий: не зависит от того, насколько ровно потоки поделили работу
+    // (но если потоков больше, чем ядер, партии делят ядро и цифра занижена)
+    std::printf("  %12.1f games/sec/core\n", games / std::max(gameSeconds, 1e-9));
+    std::printf("  %12.1f games/sec (wall %.2f s)\n", games / std::max(seconds, 1e-9), seconds);
+    std::printf("  %12.0f turns/sec\n", turns / std::max(seconds, 1e-9));
+    std::printf("\n  died %d, stuck %d, stopped at %d turns %d\n", outcomes[0], outcomes[1], MAX_TURNS, outcomes[2]);
+    std::printf("  final floor: mean %.2f  p50 %.0f  p90 %.0f  max %.0f\n", levelSum / games,
+                percentileOf(levels, 50), percentileOf(levels, 90), percentileOf(levels, 100));
+    std::printf("  turns per game: %.0f\n", static_cast<double>(turns) / games);
+    std::printf("  kills per game: ");
+    for (int k = 0; k < ENEMY_TYPE_COUNT; ++k) {
+        std::printf(" %s %.2f", KILL_NAMES[k], kills[k] / games);
+    }
+    std::printf("\n  items per game: ");
+    for (int k = 0; k < ITEM_KINDS; ++k) {
+        std::printf(" %s %.2f", ITEM_NAMES[k], items[k] / games);
+    }
+    std::printf("\n");
+
+    const bool written = endsWith(reportPath, ".json")
+                             ? writeJson(reportPath.c_str(), results, perk, threads, seconds)
+                             : writeCsv(reportPath.c_str(), results);
+    if (!written) {
+        std::printf("\ncannot write report %s\n", reportPath.c_str());
+        return 1;
+    }
+    std::printf("\n  report: %s\n", reportPath.c_str());
+    return 0;
+}
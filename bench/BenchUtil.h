@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Game.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Общее для бенчмарков: замер времени, перцентили и подготовленные этажи.
+
+using BenchClock = std::chrono::steady_clock;
+
+// Среднее время одной из count операций с момента start.
+inline double elapsedNanos(BenchClock::time_point start, long long count)
+{
+    return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count() / static_cast<double>(count);
+}
+
+inline double elapsedMicros(BenchClock::time_point start, long long count)
+{
+    return elapsedNanos(start, count) / 1000.0;
+}
+
+// Значение перцентиля p (0..100) по отсортированной выборке.
+inline double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Этаж 10 с крысами и без других мобов (чтобы сравнивать одно и то же поведение).
+inline std::unique_ptr<GameState> makeRatFloor(uint64_t seed, int width, int height)
+{
+    auto game = std::make_unique<GameState>(seed, width, height);
+    game->unlockedBear = game->unlockedSnake = game->unlockedGhost = game->unlockedCrab = false;
+    game->unlockedRat = true;
+    game->level = 10;
+    game->generateNewLevel();
+    return game;
+}
+
+// Ровно count мобов на этаже (если хватит свободных клеток): недостающие встают на свободные клетки,
+// i-й по счёту — типа i % typeCount (1 — одни крысы), лишние с конца убираются. Сетка мобов пересобирается.
+inline void fillEnemies(GameState& game, int count, int typeCount = 1, int health = 3)
+{
+    static const RgbColor colors[ENEMY_TYPE_COUNT] = {
+        {255, 50, 50}, {139, 69, 19}, {60, 130, 60}, {170, 170, 170}, {255, 140, 0}};
+    while (static_cast<int>(game.enemies.size()) < count) {
+        Position cell;
+        if (!game.freeCells.take(game.rngSpawn, cell)) {
+            break;
+        }
+        const int type = static_cast<int>(game.enemies.size()) % typeCount;
+        game.enemies.add(static_cast<EnemyType>(type), cell.x, cell.y, health, 1, colors[type]);
+    }
+    for (size_t i = static_cast<size_t>(count); i < game.enemies.size(); ++i) {
+        game.enemies.health[i] = 0;
+    }
+    game.enemies.removeDead([](size_t, EnemyType) {}, [](size_t, size_t) {});
+    game.rebuildEnemyGrid();
+}
@@ -0,0 +1,147 @@
+// Бенчмарк смешивания цветов карты (последний шаг drawMap): уровни света уже посчитаны,
+// осталось для каждой видимой клетки получить lerp(тёмный цвет, светлый цвет, уровень).
+// Худший случай — вся карта видима (зелье видения, revealAll): смешивается каждая клетка окна.
+// Сравниваются TCODColor::lerp по клетке (как было в drawMap) и ядра blendRow над плоскостями
+// r/g/b строки: scalar, sse2, avx2 (те, что поддерживает процессор). Результаты всех ядер
+// сверяются с TCODColor::lerp побайтно.
+//
+// Запуск: ASC11_bench_blend [frames] [seed] [fireflies]
+//   frames    — сколько кадров на каждое ядро (по умолчанию 20000)
+//   seed      — сид карты (по умолчанию 1)
+//   fireflies — сколько светлячков на случайных клетках пола (по умолчанию 10)
+
+#include "Lighting.h"
+#include "Map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+
+// Одна строка окна карты в том виде, в каком её получает blendRow
+struct BlendRowData {
+    ColorPlanes base;
+    ColorPlanes light;
+    std::vector<float> levels;
+};
+
+// Контрольная сумма, чтобы компилятор не выбросил работу
+unsigned long long checksum(const ColorPlanes& colors)
+{
+    unsigned long long sum = 0;
+    for (size_t i = 0; i < colors.r.size(); ++i) {
+        sum = sum * 31 + colors.r[i] + colors.g[i] * 7u + colors.b[i] * 13u;
+    }
+    return sum;
+}
+
+bool samePlanes(const ColorPlanes& a, const ColorPlanes& b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20000;
+    const uint64_t seed = argc > 2 ? static_cast<uint64_t>(std::atoll(argv[2])) : 1;
+    const int fireflyCount = argc > 3 ? std::max(0, std::atoi(argv[3])) : 10;
+    const int torchRadius = 8;
+
+    const tcod::ColorRGB darkWall{0, 0, 100};
+    const tcod::ColorRGB lightWall{130, 110, 50};
+    const tcod::ColorRGB darkGround{50, 50, 150};
+    const tcod::ColorRGB lightGround{200, 180, 50};
+
+    auto map = std::make_unique<Map>();
+    Rng mapRng(seed, 1);
+    map->generate(5, mapRng);
+    map->revealAll();
+    std::vector<Position> floorCells;
+    map->collectFloorCells(floorCells);
+    const Position player = floorCells[floorCells.size() / 2];
+    const int width = map->getWidth();
+    const int height = map->getHeight();
+
+    // Свет одного кадра: факел и светлячки
+    FrameLighting lighting;
+    lighting.begin(0, 0, width, height);
+    lighting.addLight(player.x, player.y, torchRadius, 0.95f);
+    Rng placeRng(seed, 3);
+    for (int i = 0; i < fireflyCount; ++i) {
+        const Position& cell = floorCells[static_cast<size_t>(placeRng.below(static_cast<int>(floorCells.size())))];
+        lighting.addLight(cell.x, cell.y, 2, 0.9f);
+    }
+
+    std::vector<BlendRowData> rows(static_cast<size_t>(height));
+    for (int y = 0; y < height; ++y) {
+        BlendRowData& row = rows[static_cast<size_t>(y)];
+        row.base.resize(static_cast<size_t>(width));
+        row.light.resize(static_cast<size_t>(width));
+        row.levels.resize(static_cast<size_t>(width));
+        for (int x = 0; x < width; ++x) {
+            const bool isWall = map->isWall(x, y);
+            row.base.set(static_cast<size_t>(x), isWall ? darkWall : darkGround);
+            row.light.set(static_cast<size_t>(x), isWall ? lightWall : lightGround);
+        }
+        lighting.levelRow(y, 0, width, row.levels.data());
+    }
+
+    std::printf("ASC11 color blend benchmark: %d frames, view %dx%d fully visible, torch radius %d, %d fireflies\n",
+                frames, width, height, torchRadius, fireflyCount);
+    std::printf("CPU supports: %s\n\n", blendKernelName(detectBlendKernel()));
+
+    std::vector<ColorPlanes> reference(rows.size());
+    std::vector<ColorPlanes> output(rows.size());
+    for (size_t y = 0; y < rows.size(); ++y) {
+        reference[y].resize(static_cast<size_t>(width));
+        output[y].resize(static_cast<size_t>(width));
+    }
+    unsigned long long sink = 0;
+
+    // Было: TCODColor::lerp на каждую клетку
+    BenchClock::time_point start = BenchClock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        for (size_t y = 0; y < rows.size(); ++y) {
+            const BlendRowData& row = rows[y];
+            for (size_t x = 0; x < row.levels.size(); ++x) {
+                reference[y].set(x, tcod::ColorRGB{TCODColor::lerp(row.base.get(x), row.light.get(x), row.levels[x])});
+            }
+        }
+        sink += checksum(reference[static_cast<size_t>(frame) % reference.size()]);
+    }
+    const double lerpMicros = std::chrono::duration<double, std::micro>(BenchClock::now() - start).count() / frames;
+    std::printf("  %-22s %9.3f us/frame\n", "TCODColor::lerp", lerpMicros);
+
+    const BlendKernel supported = detectBlendKernel();
+    for (BlendKernel kernel : {BlendKernel::Scalar, BlendKernel::Sse2, BlendKernel::Avx2}) {
+        if (static_cast<int>(kernel) > static_cast<int>(supported)) {
+            std::printf("  %-22s (not supported by this CPU)\n", blendKernelName(kernel));
+            continue;
+        }
+        start = BenchClock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            for (size_t y = 0; y < rows.size(); ++y) {
+                const BlendRowData& row = rows[y];
+                blendRow(kernel, row.base, row.light, row.levels.data(), output[y], width);
+            }
+            sink += checksum(output[static_cast<size_t>(frame) % output.size()]);
+        }
+        const double micros = std::chrono::duration<double, std::micro>(BenchClock::now() - start).count() / frames;
+
+        bool matches = true;
+        for (size_t y = 0; y < rows.size(); ++y) {
+            matches = matches && samePlanes(output[y], reference[y]);
+        }
+        std::printf("  blendRow %-13s %9.3f us/frame   speedup %.1fx   %s\n", blendKernelName(kernel), micros,
+                    micros > 0.0 ? lerpMicros / micros : 0.0, matches ? "matches lerp" : "MISMATCH");
+    }
+
+    std::printf("\n(checksum %llu)\n", sink);
+    return 0;
+}
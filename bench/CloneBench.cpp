@@ -0,0 +1,154 @@
+// Бенчмарк копирования состояния игры для поиска ходов (SearchPlayer): сколько копий GameState в секунду
+// тремя способами:
+//   snapshot — writeSnapshot + readSnapshot в готовую GameState (так перематывает Replay);
+//   construct — конструктор копии (новая GameState на каждую копию);
+//   assign — присваивание в одну и ту же рабочую GameState (так делает SearchPlayer: память не выделяется,
+//            клетки карты общие с оригиналом до первой записи).
+// Состояние — середина партии бота AutoPlayer на мире по умолчанию и на 500x500, с живыми мобами на этаже.
+// Проверка: копия после тех же ходов, что и оригинал, должна дать тот же отпечаток (stateHash) —
+// если нет, копия что-то потеряла, код выхода 1. Оригинал для сверки ни разу не копировался: это та же
+// партия, сыгранная заново с начала (иначе копия сверялась бы с копией и теряла бы поля вместе с ней).
+// В конце — откатов в секунду (копия + 20 ходов бота).
+//
+// Запуск: ASC11_bench_clone [clones] [seed]
+//   clones — сколько копий на способ (по умолчанию 2000)
+//   seed   — сид партии (по умолчанию 1)
+
+#include "AutoPlayer.h"
+#include "ByteStream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+
+const int WARMUP_TURNS = 300;  // Ходов бота до замера: этаж частично исследован, мобы разбрелись
+const int MIN_ENEMIES = 3;     // После разминки бот играет дальше, пока живых мобов на этаже меньше
+const int MIN_FLOOR_STEPS = 50; // ...и пока он только что пришёл на этаж (шагов на этаже меньше)
+const int MAX_WARMUP_TURNS = 20000;
+const int CHECK_TURNS = 200;   // Ходов после копии при сверке отпечатков
+const int ROLLOUT_TURNS = 20;
+
+double secondsSince(BenchClock::time_point start)
+{
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+int aliveEnemies(const GameState& game)
+{
+    int alive = 0;
+    for (size_t i = 0; i < game.enemies.size(); ++i) {
+        alive += game.enemies.isAlive(i) ? 1 : 0;
+    }
+    return alive;
+}
+
+// Партия бота до середины: не меньше WARMUP_TURNS ходов, MIN_ENEMIES живых мобов и MIN_FLOOR_STEPS шагов
+// на этаже, не на экране перка или смерти (после смерти бот начинает новую игру).
+// Одинаковые аргументы — одинаковое состояние.
+std::unique_ptr<GameState> midGame(uint64_t seed, int width, int height)
+{
+    auto game = std::make_unique<GameState>(seed, width, height);
+    AutoPlayer bot(seed);
+    for (int turns = 0; turns < MAX_WARMUP_TURNS;) {
+        if (turns >= WARMUP_TURNS && !game->isDeathScreenActive && !game->isPerkChoiceActive &&
+            aliveEnemies(*game) >= MIN_ENEMIES && game->stepsOnCurrentLevel >= MIN_FLOOR_STEPS) {
+            break;
+        }
+        if (step(*game, bot.next(*game))) {
+            ++turns;
+        }
+    }
+    return game;
+}
+
+// Довести два состояния одними и теми же действиями (бот с одним сидом) и сравнить отпечатки.
+bool sameFuture(GameState& original, GameState& copy, uint64_t seed)
+{
+    AutoPlayer botA(seed + 1);
+    AutoPlayer botB(seed + 1);
+    for (int i = 0; i < CHECK_TURNS; ++i) {
+        step(original, botA.next(original));
+        step(copy, botB.next(copy));
+    }
+    return original.stateHash() == copy.stateHash();
+}
+
+// Копия способом mode ("snapshot", "construct", "assign") в target (для construct — новая).
+void cloneInto(const std::string& mode, const GameState& source, std::unique_ptr<GameState>& target,
+               std::vector<uint8_t>& buffer)
+{
+    if (mode == "snapshot") {
+        buffer.clear();
+        ByteWriter out(buffer);
+        source.writeSnapshot(out);
+        ByteReader in(buffer);
+        target->readSnapshot(in);
+    } else if (mode == "construct") {
+        target = std::make_unique<GameState>(source);
+    } else {
+        *target = source;
+    }
+}
+
+// Возвращает false, если копия разошлась с оригиналом.
+bool runWorld(const char* label, uint64_t seed, int width, int height, int clones)
+{
+    const std::unique_ptr<GameState> source = midGame(seed, width, height);
+    std::printf("%s %dx%d: floor %d, step %d on floor, %d enemies alive\n", label, width, height, source->level,
+                source->stepsOnCurrentLevel, aliveEnemies(*source));
+
+    bool ok = true;
+    const char* const modes[3] = {"snapshot", "construct", "assign"};
+    for (const char* mode : modes) {
+        std::unique_ptr<GameState> target = std::make_unique<GameState>(*source);
+        std::vector<uint8_t> buffer;
+        const BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < clones; ++i) {
+            cloneInto(mode, *source, target, buffer);
+        }
+        const double seconds = secondsSince(start);
+
+        // Сверка: свежая копия против той же партии, сыгранной заново (её никто не копировал)
+        const std::unique_ptr<GameState> original = midGame(seed, width, height);
+        cloneInto(mode, *source, target, buffer);
+        const bool same = original->stateHash() == source->stateHash() && sameFuture(*original, *target, seed);
+        ok = ok && same;
+        std::printf("  %-10s %12.0f clones/sec  %8.2f us/clone  %s\n", mode, clones / std::max(seconds, 1e-9),
+                    seconds * 1e6 / clones, same ? "hash match" : "HASH MISMATCH");
+    }
+
+    // Откат, как в SearchPlayer: присваивание в рабочую копию и ROLLOUT_TURNS ходов бота
+    GameState scratch(*source);
+    AutoPlayer bot(seed + 2);
+    const BenchClock::time_point start = BenchClock::now();
+    for (int i = 0; i < clones; ++i) {
+        scratch = *source;
+        for (int turn = 0; turn < ROLLOUT_TURNS && !scratch.isDeathScreenActive && !scratch.isPerkChoiceActive; ++turn) {
+            step(scratch, bot.next(scratch));
+        }
+    }
+    const double seconds = secondsSince(start);
+    std::printf("  %-10s %12.0f rollouts/sec (%d turns each)\n\n", "rollout", clones / std::max(seconds, 1e-9),
+                ROLLOUT_TURNS);
+    return ok;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int clones = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+    const uint64_t seed = argc > 2 ? static_cast<uint64_t>(std::atoll(argv[2])) : 1;
+
+    std::printf("ASC11 GameState clone benchmark: %d clones per mode, seed %llu\n\n", clones,
+                static_cast<unsigned long long>(seed));
+    bool ok = runWorld("default world", seed, Map::DEFAULT_WIDTH, Map::DEFAULT_HEIGHT, clones);
+    ok = runWorld("large world", seed, 500, 500, std::max(1, clones / 10)) && ok;
+    return ok ? 0 : 1;
+}
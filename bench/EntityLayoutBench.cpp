@@ -0,0 +1,193 @@
+// Бенчмарк раскладки мобов: старый вектор Entity (AoS) против колонок EnemyStore (SoA) с группами по типам.
+//  * Старый ход — один цикл по всем мобам с ветвлением по symbol, каждый моб — целая структура Entity
+//    (позиция, символ, цвет, здоровье, урон, поля краба) даже там, где нужны только x, y и health.
+//  * Новый ход — GameState::updateEnemies: у каждого типа свой цикл по своему отрезку колонок.
+// Оба хода ведут мобов по одним и тем же полям расстояний и тратят rngAi в одном порядке,
+// поэтому после прогона позиции обязаны совпасть — бенчмарк это проверяет.
+//
+// Запуск: ASC11_bench_entities [enemies] [turns] [seed]
+//   enemies — сколько мобов на этаже мира 500x500 (по умолчанию 10000, поровну всех пяти типов)
+//   turns   — сколько ходов сделать (по умолчанию 200)
+//   seed    — сид игры (по умолчанию 1)
+
+#include "BenchUtil.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+// Моб в старой раскладке: всё одной структурой, тип — по символу.
+struct OldEnemy {
+    Position pos;
+    int symbol;
+    RgbColor color;
+    int health;
+    int maxHealth;
+    int damage;
+    bool crabAttachedToPlayer;
+    int crabAttachmentCooldown;
+};
+
+int signOf(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+// Старые мобы со своими полями, rng и сеткой (копии того, что в GameState).
+struct OldWorld {
+    std::vector<OldEnemy> enemies;
+    FlowField groundFlow;
+    FlowField snakeFlow;
+    OccupancyGrid grid;
+    Rng rngAi;
+};
+
+void oldStep(const GameState& game, OldWorld& world, size_t i, int dx, int dy, bool throughWalls)
+{
+    OldEnemy& enemy = world.enemies[i];
+    if (dx == 0 && dy == 0) {
+        return;
+    }
+    const int newX = enemy.pos.x + dx;
+    const int newY = enemy.pos.y + dy;
+    if (!game.map.inBounds(newX, newY) || (newX == game.player.pos.x && newY == game.player.pos.y)) {
+        return;
+    }
+    if (!throughWalls && !game.map.isWalkable(newX, newY)) {
+        return;
+    }
+    enemy.pos = Position(newX, newY);
+    world.grid.place(static_cast<int32_t>(i), newX, newY);
+}
+
+// updateEnemies в старом виде: общий цикл, поведение выбирается по symbol.
+void oldUpdateEnemies(const GameState& game, OldWorld& world)
+{
+    const int playerX = game.player.pos.x;
+    const int playerY = game.player.pos.y;
+    world.groundFlow.build(game.map, playerX, playerY, GameState::FLOW_RADIUS, FlowMoves::Orthogonal);
+    world.snakeFlow.build(game.map, playerX, playerY, GameState::FLOW_RADIUS, FlowMoves::Diagonal);
+
+    for (size_t i = 0; i < world.enemies.size(); ++i) {
+        OldEnemy& enemy = world.enemies[i];
+        if (enemy.health <= 0) {
+            continue;
+        }
+        int dx = 0;
+        int dy = 0;
+        bool throughWalls = false;
+        if (enemy.symbol == SYM_GHOST) {
+            dx = signOf(playerX - enemy.pos.x);
+            dy = signOf(playerY - enemy.pos.y);
+            throughWalls = true;
+        } else if (enemy.symbol == SYM_SNAKE) {
+            if (world.snakeFlow.distance(enemy.pos.x, enemy.pos.y) != FlowField::UNREACHED) {
+                world.snakeFlow.step(enemy.pos.x, enemy.pos.y, world.rngAi, dx, dy);
+            } else {
+                dx = signOf(playerX - enemy.pos.x);
+                dy = signOf(playerY - enemy.pos.y);
+                if (dx == 0 || dy == 0) {
+                    dx = 0;
+                    dy = 0;
+                }
+            }
+        } else if (enemy.symbol == SYM_CRAB) {
+            if (enemy.crabAttachedToPlayer) {
+                continue;
+            }
+            if (enemy.crabAttachmentCooldown == 0 &&
+                world.groundFlow.distance(enemy.pos.x, enemy.pos.y) != FlowField::UNREACHED) {
+                world.groundFlow.step(enemy.pos.x, enemy.pos.y, world.rngAi, dx, dy);
+            } else {
+                dx = signOf(playerX - enemy.pos.x);
+                dy = signOf(playerY - enemy.pos.y);
+                if (enemy.crabAttachmentCooldown > 0) {
+                    dx = -dx;
+                    dy = -dy;
+                    if (--enemy.crabAttachmentCooldown <= 0) {
+                        enemy.crabAttachmentCooldown = 0;
+                        enemy.color = RgbColor{255, 140, 0};
+                    }
+                }
+                if (world.rngAi.below(2) == 0) {
+                    dy = 0;
+                } else {
+                    dx = 0;
+                }
+            }
+        } else if (world.groundFlow.distance(enemy.pos.x, enemy.pos.y) != FlowField::UNREACHED) {
+            world.groundFlow.step(enemy.pos.x, enemy.pos.y, world.rngAi, dx, dy);
+        } else {
+            dx = signOf(playerX - enemy.pos.x);
+            dy = signOf(playerY - enemy.pos.y);
+            if (world.rngAi.below(2) == 0) {
+                dy = 0;
+            } else {
+                dx = 0;
+            }
+        }
+        oldStep(game, world, i, dx, dy, throughWalls);
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int enemyCount = argc > 1 ? std::max(ENEMY_TYPE_COUNT, std::atoi(argv[1])) : 10000;
+    const int turns = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+    const uint64_t seed = argc > 3 ? static_cast<uint64_t>(std::atoll(argv[3])) : 1;
+
+    // Этаж без своих мобов, затем поровну всех пяти типов на свободные клетки
+    auto game = std::make_unique<GameState>(seed, 500, 500);
+    game->unlockedRat = game->unlockedBear = game->unlockedSnake = game->unlockedGhost = game->unlockedCrab = false;
+    game->level = 10;
+    game->generateNewLevel();
+    fillEnemies(*game, enemyCount, ENEMY_TYPE_COUNT, 5);
+
+    // Те же мобы в старой раскладке, в том же порядке
+    const EnemyStore& enemies = game->enemies;
+    OldWorld world;
+    world.rngAi = game->rngAi;
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        world.enemies.push_back(OldEnemy{Position(enemies.x[i], enemies.y[i]), enemies.symbol(i), enemies.color[i],
+                                         enemies.health[i], enemies.maxHealth[i], enemies.damage[i], false, 0});
+    }
+    world.grid.rebuild(game->map.getWidth(), game->map.getHeight(), enemies.x, enemies.y);
+    const Position playerStart = game->player.pos;
+
+    std::printf("ASC11 entity layout benchmark: %zu enemies (5 types), %d turns, world 500x500, seed %llu\n\n",
+                enemies.size(), turns, static_cast<unsigned long long>(seed));
+
+    // Игрок "шагает" туда-обратно, чтобы поля строились каждый ход в обоих прогонах
+    BenchClock::time_point start = BenchClock::now();
+    for (int turn = 0; turn < turns; ++turn) {
+        game->player.pos.x = playerStart.x + (turn & 1);
+        oldUpdateEnemies(*game, world);
+    }
+    const double oldMicros = elapsedMicros(start, turns);
+
+    start = BenchClock::now();
+    for (int turn = 0; turn < turns; ++turn) {
+        game->player.pos.x = playerStart.x + (turn & 1);
+        game->updateEnemies();
+    }
+    const double newMicros = elapsedMicros(start, turns);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        if (world.enemies[i].pos.x != enemies.x[i] || world.enemies[i].pos.y != enemies.y[i]) {
+            ++mismatches;
+        }
+    }
+
+    std::printf("  %-28s %12s %14s\n", "layout", "us per turn", "ns per enemy");
+    std::printf("  %-28s %12.1f %14.1f\n", "AoS vector<Entity>, branchy", oldMicros, 1000.0 * oldMicros / enemies.size());
+    std::printf("  %-28s %12.1f %14.1f\n", "SoA EnemyStore, per type", newMicros, 1000.0 * newMicros / enemies.size());
+    std::printf("\n  speedup %.2fx, positions %s (%zu mismatches)\n", oldMicros / std::max(newMicros, 1e-9),
+                mismatches == 0 ? "identical" : "DIFFER", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
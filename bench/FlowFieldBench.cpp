@@ -0,0 +1,110 @@
+// Бенчмарк движения мобов по полю расстояний (FlowField) против старого жадного шага по осям.
+//  * Сколько крыс дошло до игрока: игрок стоит на месте, мобы делают turns ходов.
+//    Жадный шаг застревает за преградами в комнатах, поле их обходит.
+//  * Цена: построение поля и весь updateEnemies при 10..10000 мобах на мире 500x500.
+//    Поле строится раз за ход по окну вокруг игрока, поэтому от числа мобов не зависит.
+//
+// Запуск: ASC11_bench_flowfield [seeds] [turns]
+//   seeds — сколько этажей проверить на "дошли до игрока" (по умолчанию 50)
+//   turns — сколько ходов даётся мобам (по умолчанию 60)
+
+#include "BenchUtil.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+bool nextToPlayer(const GameState& game, const Position& pos)
+{
+    return std::abs(pos.x - game.player.pos.x) + std::abs(pos.y - game.player.pos.y) == 1;
+}
+
+// Старый ход крысы: к игроку по одной случайной оси, в стену не идёт.
+void greedyStep(const GameState& game, Rng& rng, Position& pos)
+{
+    int dx = (pos.x < game.player.pos.x) ? 1 : (pos.x > game.player.pos.x) ? -1 : 0;
+    int dy = (pos.y < game.player.pos.y) ? 1 : (pos.y > game.player.pos.y) ? -1 : 0;
+    if (rng.below(2) == 0) {
+        dy = 0;
+    } else {
+        dx = 0;
+    }
+    const int newX = pos.x + dx;
+    const int newY = pos.y + dy;
+    if (game.map.inBounds(newX, newY) && !(newX == game.player.pos.x && newY == game.player.pos.y) &&
+        game.map.isWalkable(newX, newY)) {
+        pos = Position(newX, newY);
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int seeds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+    const int turns = argc > 2 ? std::max(1, std::atoi(argv[2])) : 60;
+
+    std::printf("ASC11 flow field benchmark: %d floors, %d turns, level 10\n\n", seeds, turns);
+
+    // --- Дошли ли крысы до игрока ---
+    long long rats = 0;
+    long long greedyReached = 0;
+    long long flowReached = 0;
+    for (int s = 1; s <= seeds; ++s) {
+        auto game = makeRatFloor(static_cast<uint64_t>(s), Map::DEFAULT_WIDTH, Map::DEFAULT_HEIGHT);
+        std::vector<Position> greedy;
+        for (size_t i = 0; i < game->enemies.size(); ++i) {
+            greedy.emplace_back(game->enemies.x[i], game->enemies.y[i]);
+        }
+        Rng rng(static_cast<uint64_t>(s), 5);
+        for (int turn = 0; turn < turns; ++turn) {
+            for (Position& pos : greedy) {
+                greedyStep(*game, rng, pos);
+            }
+            game->updateEnemies();
+        }
+        rats += static_cast<long long>(greedy.size());
+        for (size_t i = 0; i < greedy.size(); ++i) {
+            greedyReached += nextToPlayer(*game, greedy[i]) ? 1 : 0;
+            flowReached += nextToPlayer(*game, Position(game->enemies.x[i], game->enemies.y[i])) ? 1 : 0;
+        }
+    }
+    std::printf("  rats next to the player after %d turns (of %lld):\n", turns, rats);
+    std::printf("    greedy axis step  %6lld (%5.1f%%)\n", greedyReached, 100.0 * greedyReached / std::max(1LL, rats));
+    std::printf("    flow field        %6lld (%5.1f%%)\n\n", flowReached, 100.0 * flowReached / std::max(1LL, rats));
+
+    // --- Цена поля и хода мобов ---
+    auto world = makeRatFloor(1, 500, 500);
+    FlowField field;
+    const int builds = 2000;
+    BenchClock::time_point start = BenchClock::now();
+    for (int i = 0; i < builds; ++i) {
+        // Цель сдвигается каждый раз, чтобы поле действительно пересчитывалось
+        field.build(world->map, world->player.pos.x + (i & 1), world->player.pos.y, GameState::FLOW_RADIUS,
+                    FlowMoves::Orthogonal);
+    }
+    std::printf("  FlowField::build, window %dx%d: %.1f us\n\n",
+                2 * GameState::FLOW_RADIUS + 1, 2 * GameState::FLOW_RADIUS + 1, elapsedMicros(start, builds));
+
+    std::printf("  %8s %16s %14s\n", "enemies", "updateEnemies us", "us per enemy");
+    const int enemyCounts[] = {10, 100, 1000, 10000};
+    for (int enemyCount : enemyCounts) {
+        auto game = makeRatFloor(1, 500, 500);
+        fillEnemies(*game, enemyCount);
+
+        const int rounds = 200;
+        start = BenchClock::now();
+        for (int i = 0; i < rounds; ++i) {
+            // Игрок "шагает" туда-обратно, чтобы поле строилось каждый ход
+            game->player.pos.x += (i & 1) ? -1 : 1;
+            game->updateEnemies();
+        }
+        const double micros = elapsedMicros(start, rounds);
+        std::printf("  %8zu %16.1f %14.3f\n", game->enemies.size(), micros, micros / game->enemies.size());
+    }
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+// Бенчмарк поля зрения: свой shadowcasting (Map::computeFOV) против TCODMap (FOV_RESTRICTIVE)
+// в окне вокруг источника на радиусах 1, 3, 8 и 20. Оба считают FOV из одних и тех же
+// клеток пола одних и тех же карт. Путь через libtcod живёт только здесь: в симуляции его нет. Кроме времени печатает, сколько клеток в среднем видно
+// и в какой доле клеток алгоритмы расходятся (у них разные правила видимости).
+//
+// Запуск: ASC11_bench_fov [seeds] [width] [height]
+//   seeds  — сколько карт сгенерировать (по умолчанию 20)
+//   width  — ширина мира (по умолчанию 160, чтобы радиус 20 не упирался в край)
+//   height — высота мира (по умолчанию 120)
+
+#include "Map.h"
+
+#ifndef TCOD_NO_CONSOLE
+#define TCOD_NO_CONSOLE 1
+#endif
+#include <libtcod.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+
+struct FovResult {
+    double micros = 0.0;
+    long long calls = 0;
+    long long visibleCells = 0;
+};
+
+// Все видимые клетки в квадрате радиуса вокруг источника (вне его FOV ничего не ставит).
+void collectVisible(const Map& map, const Position& source, int radius, std::vector<Position>& out)
+{
+    out.clear();
+    for (int y = source.y - radius; y <= source.y + radius; ++y) {
+        for (int x = source.x - radius; x <= source.x + radius; ++x) {
+            if (map.isVisible(x, y)) {
+                out.push_back(Position(x, y));
+            }
+        }
+    }
+}
+
+// FOV через libtcod, как раньше было в Map: стены копируются в окно TCODMap (2r+1)x(2r+1)
+// вокруг источника, дальше радиуса FOV всё равно не заглядывает. Окно только растёт.
+class LibtcodFov {
+public:
+    void compute(const Map& map, const Position& source, int radius)
+    {
+        const int size = 2 * radius + 1;
+        if (!window || windowSize < size) {
+            window = std::make_unique<TCODMap>(size, size);
+            windowSize = size;
+        }
+        center = windowSize / 2;
+        originX = source.x - center;
+        originY = source.y - center;
+        for (int y = source.y - radius; y <= source.y + radius; ++y) {
+            for (int x = source.x - radius; x <= source.x + radius; ++x) {
+                const bool open = !map.isWall(x, y); // За краем карты — стена
+                window->setProperties(x - originX, y - originY, open, open);
+            }
+        }
+        window->computeFov(center, center, radius, true, FOV_RESTRICTIVE);
+    }
+
+    // Видимые клетки карты в квадрате радиуса, в том же порядке, что collectVisible.
+    void collect(const Map& map, const Position& source, int radius, std::vector<Position>& out) const
+    {
+        out.clear();
+        for (int y = source.y - radius; y <= source.y + radius; ++y) {
+            for (int x = source.x - radius; x <= source.x + radius; ++x) {
+                if (map.inBounds(x, y) && window->isInFov(x - originX, y - originY)) {
+                    out.push_back(Position(x, y));
+                }
+            }
+        }
+    }
+
+private:
+    std::unique_ptr<TCODMap> window;
+    int windowSize = 0;
+    int center = 0;
+    int originX = 0;
+    int originY = 0;
+};
+
+void runShadowcast(Map& map, const std::vector<Position>& sources, int radius, FovResult& result)
+{
+    const BenchClock::time_point start = BenchClock::now();
+    for (const Position& source : sources) {
+        map.computeFOV(source.x, source.y, radius, true);
+    }
+    result.micros += std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+    result.calls += static_cast<long long>(sources.size());
+}
+
+void runLibtcod(const Map& map, LibtcodFov& fov, const std::vector<Position>& sources, int radius, FovResult& result)
+{
+    const BenchClock::time_point start = BenchClock::now();
+    for (const Position& source : sources) {
+        fov.compute(map, source, radius);
+    }
+    result.micros += std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+    result.calls += static_cast<long long>(sources.size());
+}
+
+void printResult(const char* name, const FovResult& result)
+{
+    std::printf("    %-12s %9.3f us/call   %7.1f visible cells\n", name,
+                result.calls > 0 ? result.micros / result.calls : 0.0,
+                result.calls > 0 ? static_cast<double>(result.visibleCells) / result.calls : 0.0);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int seeds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+    const int width = argc > 2 ? std::atoi(argv[2]) : 160;
+    const int height = argc > 3 ? std::atoi(argv[3]) : 120;
+    const int radii[] = {1, 3, 8, 20};
+
+    auto map = std::make_unique<Map>(width, height);
+    LibtcodFov libtcodFov;
+    std::printf("ASC11 FOV benchmark: %d maps %dx%d\n\n", seeds, map->getWidth(), map->getHeight());
+
+    std::vector<Position> floorCells;
+    std::vector<Position> sources;
+    std::vector<Position> visibleA;
+    std::vector<Position> visibleB;
+    for (int radius : radii) {
+        FovResult shadowcast;
+        FovResult libtcod;
+        long long differentCells = 0;
+        long long unionCells = 0;
+        for (int seed = 0; seed < seeds; ++seed) {
+            Rng mapRng(static_cast<uint64_t>(seed), 1);
+            map->generate(5, mapRng);
+            map->collectFloorCells(floorCells);
+            // Каждая 7-я клетка пола — источник
+            sources.clear();
+            for (size_t i = 0; i < floorCells.size(); i += 7) {
+                sources.push_back(floorCells[i]);
+            }
+
+            // Время: все источники подряд одним алгоритмом
+            runShadowcast(*map, sources, radius, shadowcast);
+            runLibtcod(*map, libtcodFov, sources, radius, libtcod);
+
+            // Сравнение результатов (вне замера)
+            for (const Position& source : sources) {
+                map->computeFOV(source.x, source.y, radius, true);
+                collectVisible(*map, source, radius, visibleA);
+                libtcodFov.compute(*map, source, radius);
+                libtcodFov.collect(*map, source, radius, visibleB);
+                shadowcast.visibleCells += static_cast<long long>(visibleA.size());
+                libtcod.visibleCells += static_cast<long long>(visibleB.size());
+
+                // Обе выборки идут в одном порядке (строка за строкой), сливаем как отсортированные
+                size_t a = 0;
+                size_t b = 0;
+                while (a < visibleA.size() || b < visibleB.size()) {
+                    ++unionCells;
+                    if (b == visibleB.size() ||
+                        (a < visibleA.size() && (visibleA[a].y < visibleB[b].y ||
+                                                 (visibleA[a].y == visibleB[b].y && visibleA[a].x < visibleB[b].x)))) {
+                        ++differentCells;
+                        ++a;
+                    } else if (a == visibleA.size() || visibleA[a].y != visibleB[b].y || visibleA[a].x != visibleB[b].x) {
+                        ++differentCells;
+                        ++b;
+                    } else {
+                        ++a;
+                        ++b;
+                    }
+                }
+            }
+        }
+
+        std::printf("Radius %d (%lld calls)\n", radius, shadowcast.calls);
+        printResult("shadowcast", shadowcast);
+        printResult("libtcod", libtcod);
+        std::printf("    speedup %.2fx, cells that differ: %.2f%%\n\n",
+                    shadowcast.micros > 0.0 ? libtcod.micros / shadowcast.micros : 0.0,
+                    unionCells > 0 ? differentCells * 100.0 / static_cast<double>(unionCells) : 0.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Бенчмарк кеша FOV в игровом цикле без окна.
+// Повторяет то, что делает main.cpp каждый кадр (FOV игрока + светлячков), при этом клавиша
+// нажимается только раз в несколько кадров. Печатает счётчики Map::fovStats:
+// на кадрах без ввода FOV не должен пересчитываться ни разу.
+//
+// Запуск: ASC11_bench_fovcache [frames] [framesPerKey] [fireflies]
+//   frames       — сколько кадров прогнать (по умолчанию 60000)
+//   framesPerKey — раз во сколько кадров нажимается клавиша (по умолчанию 15)
+//   fireflies    — сколько светлячков добавить (по умолчанию 10)
+
+#include "Game.h"
+#include "Map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+
+struct LoopResult {
+    double fovMicros = 0.0;   // Суммарное время FOV за все кадры
+    int turns = 0;
+    long long idleComputes = 0; // Пересчёты FOV на кадрах без нажатия (с кешем должно быть 0)
+};
+
+// Кадр за кадром: иногда ход игрока, каждый кадр — FOV как в main.cpp.
+// cached == false — старый путь: computeFOV + addFOV на каждый кадр.
+LoopResult runLoop(GameState& game, int frames, int framesPerKey, bool cached)
+{
+    Rng input(7, 99);
+    LoopResult result;
+    for (int frame = 0; frame < frames; ++frame) {
+        // Как в игре: выбор перка, рестарт и ход случаются только по нажатию клавиши.
+        const bool keyPressed = frame % framesPerKey == 0;
+        if (keyPressed) {
+            if (game.isPerkChoiceActive) {
+                game.applyLevelChoice(3);
+            } else if (game.isDeathScreenActive) {
+                game.restartGame();
+            } else {
+                step(game, MOVE_ACTIONS[input.below(8)]);
+            }
+            ++result.turns;
+        }
+        const uint64_t computesBefore = game.map.fovStats.computes;
+
+        const BenchClock::time_point start = BenchClock::now();
+        if (cached) {
+            game.updateFOV();
+        } else {
+            const int fovRadius = std::max(1, static_cast<int>(game.torchRadius * 0.7f));
+            game.map.computeFOV(game.player.pos.x, game.player.pos.y, fovRadius, true);
+            for (const auto& firefly : game.fireflies) {
+                game.map.addFOV(firefly.x, firefly.y, 1, true);
+            }
+        }
+        result.fovMicros += std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+        if (!keyPressed) {
+            result.idleComputes += static_cast<long long>(game.map.fovStats.computes - computesBefore);
+        }
+    }
+    return result;
+}
+
+std::unique_ptr<GameState> makeGame(int fireflies)
+{
+    auto game = std::make_unique<GameState>(5);
+    game->perkFireflyEnabled = fireflies > 0;
+    for (int i = 0; i < fireflies; ++i) {
+        game->fireflies.insert(GameState::Firefly(game->player.pos.x, game->player.pos.y));
+    }
+    return game;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 60000;
+    const int framesPerKey = argc > 2 ? std::max(1, std::atoi(argv[2])) : 15;
+    const int fireflies = argc > 3 ? std::max(0, std::atoi(argv[3])) : 10;
+
+    std::printf("ASC11 FOV cache benchmark: %d frames, key every %d frames, %d fireflies\n\n",
+                frames, framesPerKey, fireflies);
+
+    {
+        auto game = makeGame(fireflies);
+        const LoopResult r = runLoop(*game, frames, framesPerKey, false);
+        std::printf("No cache (computeFOV + addFOV every frame)\n");
+        std::printf("  FOV time: %.3f us/frame\n", r.fovMicros / frames);
+    }
+
+    std::printf("\n");
+
+    {
+        auto game = makeGame(fireflies);
+        game->map.fovStats = FovStats{};
+        const LoopResult r = runLoop(*game, frames, framesPerKey, true);
+        const FovStats& stats = game->map.fovStats;
+        std::printf("GameState::updateFOV (cached)\n");
+        std::printf("  FOV time: %.3f us/frame\n", r.fovMicros / frames);
+        std::printf("  turns: %d  idle frames: %d\n", r.turns, frames - r.turns);
+        std::printf("  fov computes: %llu  cache hits: %llu  computes on idle frames: %lld\n",
+                    static_cast<unsigned long long>(stats.computes),
+                    static_cast<unsigned long long>(stats.cacheHits), r.idleComputes);
+    }
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Игровой цикл целиком (runFrame из GameLoop) без окна: HeadlessBackend рисует в консоль в памяти,
+// клавиши идут из сценария, время — 16 мс на кадр. Прогоняется дважды — с полной перерисовкой
+// экрана и с перерисовкой только изменившихся клеток — и кадры обоих прогонов сверяются по хешу.
+// Печатает время кадра и сколько клеток консоли переписано за кадр.
+//
+// Запуск: ASC11_bench_headless [frames] [seed] [dumpPath]
+//   frames   — сколько кадров прогнать (по умолчанию 20000)
+//   seed     — сид игры и сценария (по умолчанию 1)
+//   dumpPath — если задан, каждый 100-й кадр второго прогона пишется текстом в этот файл
+
+#include "GameLoop.h"
+#include "RenderBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+
+struct RunResult {
+    double frameMicros = 0.0;
+    double cellsPerFrame = 0.0;
+    int framesRun = 0;
+    std::vector<uint64_t> hashes; // Хеш каждого кадра
+};
+
+RunResult runHeadless(uint64_t seed, int frames, bool dirty, const std::string& dumpPath)
+{
+    GameState game(seed);
+    auto backend = std::make_unique<HeadlessBackend>(16);
+    HeadlessBackend& headless = *backend;
+    auto graphics = makeGameGraphics(std::move(backend));
+    graphics->setDirtyRendering(dirty);
+    if (!dumpPath.empty() && !headless.dumpFrames(dumpPath, 100)) {
+        std::printf("cannot open %s\n", dumpPath.c_str());
+    }
+
+    // Сценарий: ходы, перки и рестарт, клавиша раз в 4 кадра (ESC нет — игра не закрывается)
+    const char keys[] = "wasdqezcwasdwasd123f";
+    Rng script(seed, 11);
+    for (int i = 0; i < frames / 4 + 1; ++i) {
+        headless.pushKey(keys[script.below(20)], 3);
+    }
+
+    beginGame(game);
+    RunResult result;
+    long long cells = 0;
+    double micros = 0.0;
+    for (int frame = 0; frame < frames && game.isRunning; ++frame) {
+        if (frame % 5 == 0) {
+            // Мышь ездит по экрану: подписи при наведении тоже рисуются
+            headless.setMouseTile(script.below(ScreenLayout::screenWidth), script.below(ScreenLayout::screenHeight));
+        }
+        const BenchClock::time_point start = BenchClock::now();
+        runFrame(game, *graphics);
+        micros += std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+        cells += graphics->renderStats.total();
+        result.hashes.push_back(headless.frameHash());
+        ++result.framesRun;
+    }
+    if (result.framesRun > 0) {
+        result.frameMicros = micros / result.framesRun;
+        result.cellsPerFrame = static_cast<double>(cells) / result.framesRun;
+    }
+    return result;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20000;
+    const uint64_t seed = argc > 2 ? static_cast<uint64_t>(std::atoll(argv[2])) : 1;
+    const std::string dumpPath = argc > 3 ? argv[3] : "";
+
+    std::printf("ASC11 headless game loop benchmark: %d frames, seed %llu, screen %dx%d\n\n",
+                frames, static_cast<unsigned long long>(seed), ScreenLayout::screenWidth, ScreenLayout::screenHeight);
+
+    const RunResult full = runHeadless(seed, frames, false, "");
+    const RunResult dirty = runHeadless(seed, frames, true, dumpPath);
+
+    std::printf("  %-20s %9.2f us/frame   %8.1f cells/frame\n", "full redraw", full.frameMicros, full.cellsPerFrame);
+    std::printf("  %-20s %9.2f us/frame   %8.1f cells/frame\n", "dirty cells only", dirty.frameMicros, dirty.cellsPerFrame);
+
+    int firstMismatch = -1;
+    const size_t common = std::min(full.hashes.size(), dirty.hashes.size());
+    for (size_t i = 0; i < common && firstMismatch < 0; ++i) {
+        if (full.hashes[i] != dirty.hashes[i]) {
+            firstMismatch = static_cast<int>(i);
+        }
+    }
+    if (firstMismatch < 0 && full.hashes.size() == dirty.hashes.size()) {
+        std::printf("\n  frames identical in both modes (%d frames)\n", full.framesRun);
+    } else {
+        std::printf("\n  FRAMES DIFFER starting at frame %d\n", firstMismatch);
+    }
+    if (!dumpPath.empty()) {
+        std::printf("  every 100th frame written to %s\n", dumpPath.c_str());
+    }
+    return 0;
+}
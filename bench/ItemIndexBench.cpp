@@ -0,0 +1,87 @@
+// Бенчмарк вопроса "какой предмет на клетке (x, y)?" (подбор под игроком, подсказка под мышью)
+// при росте числа предметов на этаже: перебор map.items против индекса клеток Map::getItemAt.
+// Перки копят аптечки, щиты и MaxHP на каждом этаже, так что предметов со временем всё больше.
+//
+// Запуск: ASC11_bench_items [queries] [seed]
+//   queries — сколько клеток проверить на каждом размере (по умолчанию 200000)
+//   seed    — сид генерации (по умолчанию 1)
+
+#include "BenchUtil.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+// Как раньше: перебор всех предметов.
+const Item* linearItemAt(const Map& map, int x, int y)
+{
+    for (const Item& item : map.items) {
+        if (item.pos.x == x && item.pos.y == y) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int queries = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200000;
+    const uint64_t seed = argc > 2 ? static_cast<uint64_t>(std::atoll(argv[2])) : 1;
+    const int itemCounts[] = {10, 100, 1000, 10000};
+
+    std::printf("ASC11 item index benchmark: %d queries, world 500x500, seed %llu\n\n",
+                queries, static_cast<unsigned long long>(seed));
+    std::printf("  %8s %14s %15s %9s\n", "items", "scan ns/query", "index ns/query", "speedup");
+
+    for (int itemCount : itemCounts) {
+        Map map(500, 500);
+        Rng rng(seed, 1);
+        map.generate(1, rng); // На первом уровне предмет один — остальные досыпаем сами
+
+        // Досыпаем аптечки на клетки пола до нужного числа
+        std::vector<Position> floor;
+        map.collectFloorCells(floor);
+        for (size_t i = 0; static_cast<int>(map.items.size()) < itemCount && i < floor.size(); ++i) {
+            const Position& cell = floor[static_cast<size_t>(rng.below(static_cast<int>(floor.size())))];
+            if (map.getCell(cell.x, cell.y) == SYM_FLOOR) {
+                map.addHealItem(cell.x, cell.y, 5);
+            }
+        }
+
+        // Клетки запросов: половина — под предметами, половина — случайные
+        std::vector<Position> cells(static_cast<size_t>(queries));
+        for (int i = 0; i < queries; ++i) {
+            if (i % 2 == 0 && !map.items.empty()) {
+                cells[static_cast<size_t>(i)] = map.items[static_cast<size_t>(rng.below(static_cast<int>(map.items.size())))].pos;
+            } else {
+                cells[static_cast<size_t>(i)] = Position(rng.below(map.getWidth()), rng.below(map.getHeight()));
+            }
+        }
+
+        int scanHits = 0;
+        BenchClock::time_point start = BenchClock::now();
+        for (const Position& cell : cells) {
+            scanHits += linearItemAt(map, cell.x, cell.y) != nullptr ? 1 : 0;
+        }
+        const double scanNanos = elapsedNanos(start, queries);
+
+        int indexHits = 0;
+        start = BenchClock::now();
+        for (const Position& cell : cells) {
+            indexHits += map.getItemAt(cell.x, cell.y).valid() ? 1 : 0;
+        }
+        const double indexNanos = elapsedNanos(start, queries);
+
+        if (scanHits != indexHits) {
+            std::printf("hit mismatch: scan %d, index %d\n", scanHits, indexHits);
+            return 1;
+        }
+        std::printf("  %8zu %14.1f %15.1f %8.1fx\n", map.items.size(), scanNanos, indexNanos,
+                    scanNanos / std::max(indexNanos, 1e-9));
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+// Бенчмарк генерации уровней без окна и SDL.
+// Гоняет Map::generate(level) и GameState::generateNewLevel() на фиксированных сидах
+// и печатает уровни/сек, p50/p99 одной генерации и время каждого этапа Map::generate.
+//
+// Запуск: ASC11_bench_levelgen [seeds] [level]
+//   seeds — сколько сидов прогнать (по умолчанию 2000)
+//   level — номер уровня, который генерируем (по умолчанию 5)
+
+#include "BenchUtil.h"
+#include "Map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+// Итоговые суммы по этапам генерации карты.
+struct StageTotals {
+    MapGenTimings sum;
+
+    void add(const MapGenTimings& t)
+    {
+        sum.rooms += t.rooms;
+        sum.obstacles += t.obstacles;
+        sum.corridors += t.corridors;
+        sum.brokenAreas += t.brokenAreas;
+        sum.fovSync += t.fovSync;
+        sum.placement += t.placement;
+    }
+};
+
+void printStage(const char* name, double totalMicros, double allMicros, int runs)
+{
+    const double share = allMicros > 0.0 ? totalMicros * 100.0 / allMicros : 0.0;
+    std::printf("    %-14s %10.2f us/level  %5.1f%%\n", name, totalMicros / runs, share);
+}
+
+// Печатает сводку по выборке времён (в микросекундах) одной генерации.
+void printSummary(const char* title, std::vector<double>& samples, const StageTotals& stages, double extraMicros)
+{
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double s : samples) {
+        sum += s;
+    }
+    const int runs = static_cast<int>(samples.size());
+
+    std::printf("%s\n", title);
+    std::printf("  levels/sec: %.1f\n", sum > 0.0 ? runs * 1e6 / sum : 0.0);
+    std::printf("  mean: %.2f us  p50: %.2f us  p99: %.2f us  max: %.2f us\n",
+                sum / runs, percentile(samples, 50.0), percentile(samples, 99.0), samples.back());
+    if (stages.sum.total() <= 0.0) {
+        return;
+    }
+    std::printf("  stages:\n");
+    printStage("rooms", stages.sum.rooms, sum, runs);
+    printStage("obstacles", stages.sum.obstacles, sum, runs);
+    printStage("corridors", stages.sum.corridors, sum, runs);
+    printStage("broken areas", stages.sum.brokenAreas, sum, runs);
+    printStage("fov sync", stages.sum.fovSync, sum, runs);
+    printStage("items/exit", stages.sum.placement, sum, runs);
+    if (extraMicros > 0.0) {
+        printStage("spawn + fov", extraMicros, sum, runs);
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int seeds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+    const int level = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    std::printf("ASC11 level generation benchmark: %d seeds, level %d, map %dx%d\n\n",
+                seeds, level, Map::DEFAULT_WIDTH, Map::DEFAULT_HEIGHT);
+
+    // --- 1. Только Map::generate ---
+    {
+        auto map = std::make_unique<Map>();
+        std::vector<double> samples;
+        samples.reserve(seeds);
+        StageTotals stages;
+
+        for (int seed = 0; seed < seeds; ++seed) {
+            Rng rng(static_cast<uint64_t>(seed), 1);
+            const BenchClock::time_point start = BenchClock::now();
+            map->generate(level, rng);
+            const BenchClock::time_point end = BenchClock::now();
+            samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            stages.add(map->lastGenTimings);
+        }
+        printSummary("Map::generate", samples, stages, 0.0);
+    }
+
+    std::printf("\n");
+
+    // --- 2. Полный переход на уровень: GameState::generateNewLevel ---
+    {
+        auto game = std::make_unique<GameState>(0);
+        // Открываем всех мобов и предметы, чтобы спавн был как на глубоком этаже.
+        game->unlockedRat = game->unlockedBear = game->unlockedSnake = true;
+        game->unlockedGhost = game->unlockedCrab = true;
+        game->unlockedMedkit = game->unlockedMaxHP = game->unlockedShield = true;
+        game->unlockedTrap = game->unlockedQuest = true;
+
+        std::vector<double> samples;
+        samples.reserve(seeds);
+        StageTotals stages;
+        double spawnMicros = 0.0;
+
+        for (int seed = 0; seed < seeds; ++seed) {
+            game->reseed(static_cast<uint64_t>(seed));
+            game->level = level;
+            const BenchClock::time_point start = BenchClock::now();
+            game->generateNewLevel();
+            const BenchClock::time_point end = BenchClock::now();
+            const double micros = std::chrono::duration<double, std::micro>(end - start).count();
+            samples.push_back(micros);
+            stages.add(game->map.lastGenTimings);
+            spawnMicros += std::max(0.0, micros - game->map.lastGenTimings.total());
+        }
+        printSummary("GameState::generateNewLevel", samples, stages, spawnMicros);
+    }
+
+    std::printf("\n");
+
+    // --- 3. Переход по лестнице, когда карта уже построена в фоне ---
+    // Так выглядит кадр, в котором игрок выбрал перк: обмен буферов + спавн + FOV.
+    {
+        auto game = std::make_unique<GameState>(0);
+        game->unlockedRat = game->unlockedBear = game->unlockedSnake = true;
+        game->unlockedGhost = game->unlockedCrab = true;
+        game->unlockedMedkit = game->unlockedMaxHP = game->unlockedShield = true;
+        game->unlockedTrap = game->unlockedQuest = true;
+
+        std::vector<double> samples;
+        samples.reserve(seeds);
+        for (int seed = 0; seed < seeds; ++seed) {
+            game->reseed(static_cast<uint64_t>(seed));
+            game->level = level - 1;
+            game->startNextLevelPregeneration();
+            game->waitNextLevel(); // В игре в это время открыт экран перков
+            const BenchClock::time_point start = BenchClock::now();
+            game->applyLevelChoice(3); // Перк "только на следующий этаж" не накапливается
+            const BenchClock::time_point end = BenchClock::now();
+            samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        printSummary("applyLevelChoice (map pregenerated)", samples, StageTotals{}, 0.0);
+    }
+
+    return 0;
+}
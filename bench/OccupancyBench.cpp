@@ -0,0 +1,99 @@
+// Бенчмарк вопроса "есть ли живой моб на клетке (x, y)?" при росте числа мобов.
+// На этаж мира 500x500 досыпаются крысы (до 10, 100, 1000, 10000 штук), затем:
+//  * один и тот же набор случайных клеток проверяется перебором enemies и через enemyGrid;
+//  * делаются случайные ходы через step (игрок бессмертен, чтобы этаж не сбрасывался).
+// Перебор растёт линейно с числом мобов, сетка — нет. Ход всё равно содержит линейные части
+// (каждый моб делает шаг в updateEnemies), но в нём больше нет перебора на каждый запрос клетки.
+//
+// Запуск: ASC11_bench_occupancy [queries] [turns] [seed]
+//   queries — сколько клеток проверить на каждом размере (по умолчанию 200000)
+//   turns   — сколько ходов сделать (по умолчанию 200)
+//   seed    — сид игры (по умолчанию 1)
+
+#include "BenchUtil.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+// Как раньше: перебор всех мобов.
+bool linearEnemyAt(const GameState& game, int x, int y)
+{
+    const EnemyStore& enemies = game.enemies;
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        if (enemies.isAlive(i) && enemies.x[i] == x && enemies.y[i] == y) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int queries = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200000;
+    const int turns = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+    const uint64_t seed = argc > 3 ? static_cast<uint64_t>(std::atoll(argv[3])) : 1;
+
+    const int enemyCounts[] = {10, 100, 1000, 10000};
+
+    std::printf("ASC11 occupancy benchmark: %d queries, %d turns, world 500x500, seed %llu\n\n",
+                queries, turns, static_cast<unsigned long long>(seed));
+    std::printf("  %8s %14s %14s %9s %14s\n", "enemies", "scan ns/query", "grid ns/query", "speedup", "turn us");
+
+    for (int enemyCount : enemyCounts) {
+        auto game = makeRatFloor(seed, 500, 500);
+        game->player.maxHealth = game->player.health = 1000000000;
+        // Досыпаем крыс на свободные клетки до нужного числа
+        fillEnemies(*game, enemyCount);
+        const size_t placed = game->enemies.size();
+
+        // Клетки запросов: половина — под мобами, половина — случайные
+        Rng pick(seed, 77);
+        std::vector<Position> cells(static_cast<size_t>(queries));
+        for (int i = 0; i < queries; ++i) {
+            if (i % 2 == 0 && !game->enemies.empty()) {
+                const size_t enemy = static_cast<size_t>(pick.below(static_cast<int>(game->enemies.size())));
+                cells[static_cast<size_t>(i)] = Position(game->enemies.x[enemy], game->enemies.y[enemy]);
+            } else {
+                cells[static_cast<size_t>(i)] = Position(pick.below(game->map.getWidth()), pick.below(game->map.getHeight()));
+            }
+        }
+
+        int scanHits = 0;
+        BenchClock::time_point start = BenchClock::now();
+        for (const Position& cell : cells) {
+            scanHits += linearEnemyAt(*game, cell.x, cell.y) ? 1 : 0;
+        }
+        const double scanNanos = elapsedNanos(start, queries);
+
+        int gridHits = 0;
+        start = BenchClock::now();
+        for (const Position& cell : cells) {
+            gridHits += game->enemyAt(cell.x, cell.y) >= 0 ? 1 : 0;
+        }
+        const double gridNanos = elapsedNanos(start, queries);
+        if (scanHits != gridHits) {
+            std::printf("  mismatch: scan %d hits, grid %d hits\n", scanHits, gridHits);
+            return 1;
+        }
+
+        Rng input(seed, 99);
+        start = BenchClock::now();
+        for (int turn = 0; turn < turns; ++turn) {
+            // Экран перка (игрок наступил на выход) не открываем: ходы идут по тому же этажу
+            game->isPerkChoiceActive = false;
+            step(*game, MOVE_ACTIONS[input.below(8)]);
+        }
+        const double turnMicros = elapsedNanos(start, turns) / 1000.0;
+
+        std::printf("  %8zu %14.1f %14.1f %8.1fx %14.2f\n",
+                    placed, scanNanos, gridNanos, scanNanos / gridNanos, turnMicros);
+    }
+
+    return 0;
+}
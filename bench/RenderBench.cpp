@@ -0,0 +1,217 @@
+// Микробенчмарк освещения карты (то, что drawMap делает для каждой видимой клетки окна 80x36).
+// Три варианта:
+//   old    — sqrt, clamp и два обращения к шуму на каждого светлячка в каждой клетке;
+//   tables — таблицы затухания по квадрату расстояния, шум раз на источник за кадр,
+//            но каждая клетка всё ещё перебирает все источники (клетки x источники);
+//   buffer — FrameLighting: источник впечатывается в буфер только в свой квадрат
+//            (сумма площадей источников), клетка читает из буфера один уровень.
+// Вся карта видима (как под зельем видения), светлячки стоят на случайных клетках пола.
+// Окно и SDL не нужны: считаются только цвета клеток.
+//
+// Запуск: ASC11_bench_render [frames] [seed]
+//   frames — сколько кадров на каждый вариант (по умолчанию 2000)
+//   seed   — сид карты (по умолчанию 1)
+
+#include "Lighting.h"
+#include "Map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+
+const tcod::ColorRGB darkWall{0, 0, 100};
+const tcod::ColorRGB lightWall{130, 110, 50};
+const tcod::ColorRGB darkGround{50, 50, 150};
+const tcod::ColorRGB lightGround{200, 180, 50};
+
+// Так drawMap освещал клетки раньше (формулы перенесены без изменений).
+void shadeOld(const Map& map, int playerX, int playerY, int torchRadius,
+              const std::vector<std::pair<int, int>>& fireflies, TCODNoise& noise, float torchX,
+              std::vector<tcod::ColorRGB>& out)
+{
+    float tdx = torchX + 20.0f;
+    const float dx = noise.get(&tdx) * 0.5f;
+    tdx += 30.0f;
+    const float dy = noise.get(&tdx) * 0.5f;
+    const float pulse = 0.25f;
+    const float di = pulse * (0.5f + 0.5f * noise.get(&torchX));
+    const float squaredTorchRadius = static_cast<float>(torchRadius * torchRadius);
+
+    for (int y = 0; y < map.getHeight(); ++y) {
+        for (int x = 0; x < map.getWidth(); ++x) {
+            const bool isWall = map.isWall(x, y);
+            tcod::ColorRGB base = isWall ? darkWall : darkGround;
+            const tcod::ColorRGB light = isWall ? lightWall : lightGround;
+            const float r = static_cast<float>((x - playerX + dx) * (x - playerX + dx) +
+                                               (y - playerY + dy) * (y - playerY + dy));
+            if (r < squaredTorchRadius) {
+                const float l = std::clamp((1.0f - std::sqrt(r / squaredTorchRadius)) * (0.7f + di), 0.0f, 1.0f);
+                base = tcod::ColorRGB{TCODColor::lerp(base, light, l)};
+            }
+            if (!fireflies.empty()) {
+                const float squaredFireflyRadius = 4.0f;
+                const float fireflyDi = pulse * (0.5f + 0.5f * noise.get(&torchX));
+                for (const auto& firefly : fireflies) {
+                    const float fdx = noise.get(&torchX) * 0.3f;
+                    const float fdy = noise.get(&torchX) * 0.3f;
+                    const float dist = static_cast<float>((x - firefly.first + fdx) * (x - firefly.first + fdx) +
+                                                          (y - firefly.second + fdy) * (y - firefly.second + fdy));
+                    if (dist < squaredFireflyRadius) {
+                        const float l = std::clamp((1.0f - std::sqrt(dist / squaredFireflyRadius)) * (0.7f + fireflyDi), 0.0f, 1.0f);
+                        base = tcod::ColorRGB{TCODColor::lerp(base, light, l)};
+                    }
+                }
+            }
+            out[static_cast<size_t>(y) * map.getWidth() + x] = base;
+        }
+    }
+}
+
+// Таблицы без буфера: на клетку — цикл по всем источникам кадра.
+struct PerCellSource {
+    int x, y;
+    std::vector<float> levels; // Уровень по d2
+};
+
+void shadeTables(const Map& map, int playerX, int playerY, int torchRadius,
+                 const std::vector<std::pair<int, int>>& fireflies, TCODNoise& noise, float torchX,
+                 FrameLighting& lighting, std::vector<PerCellSource>& sources, std::vector<tcod::ColorRGB>& out)
+{
+    const float pulse = 0.25f;
+    sources.resize(fireflies.size() + 1);
+    auto setSource = [&](PerCellSource& source, int x, int y, int radius, float intensity) {
+        const std::vector<float>& table = lighting.falloff(radius);
+        source.x = x;
+        source.y = y;
+        source.levels.resize(table.size());
+        for (size_t d2 = 0; d2 < table.size(); ++d2) {
+            source.levels[d2] = std::clamp(table[d2] * intensity, 0.0f, 1.0f);
+        }
+    };
+    setSource(sources[0], playerX, playerY, torchRadius, 0.7f + pulse * (0.5f + 0.5f * noise.get(&torchX)));
+    for (size_t i = 0; i < fireflies.size(); ++i) {
+        float fireflyNoiseX = torchX + 13.0f * static_cast<float>(i + 1);
+        setSource(sources[i + 1], fireflies[i].first, fireflies[i].second, 2,
+                  0.7f + pulse * (0.5f + 0.5f * noise.get(&fireflyNoiseX)));
+    }
+    for (int y = 0; y < map.getHeight(); ++y) {
+        for (int x = 0; x < map.getWidth(); ++x) {
+            const bool isWall = map.isWall(x, y);
+            tcod::ColorRGB color = isWall ? darkWall : darkGround;
+            const tcod::ColorRGB light = isWall ? lightWall : lightGround;
+            for (const PerCellSource& source : sources) {
+                const int dx = x - source.x;
+                const int dy = y - source.y;
+                const size_t d2 = static_cast<size_t>(dx * dx + dy * dy);
+                if (d2 < source.levels.size()) {
+                    color = tcod::ColorRGB{TCODColor::lerp(color, light, source.levels[d2])};
+                }
+            }
+            out[static_cast<size_t>(y) * map.getWidth() + x] = color;
+        }
+    }
+}
+
+// Буфер света: источники впечатываются в свои квадраты, на клетку — FrameLighting::shade.
+void shadeBuffer(const Map& map, int playerX, int playerY, int torchRadius,
+                 const std::vector<std::pair<int, int>>& fireflies, TCODNoise& noise, float torchX,
+                 FrameLighting& lighting, std::vector<tcod::ColorRGB>& out)
+{
+    const float pulse = 0.25f;
+    lighting.begin(0, 0, map.getWidth(), map.getHeight());
+    lighting.addLight(playerX, playerY, torchRadius, 0.7f + pulse * (0.5f + 0.5f * noise.get(&torchX)));
+    for (size_t i = 0; i < fireflies.size(); ++i) {
+        float fireflyNoiseX = torchX + 13.0f * static_cast<float>(i + 1);
+        lighting.addLight(fireflies[i].first, fireflies[i].second, 2,
+                          0.7f + pulse * (0.5f + 0.5f * noise.get(&fireflyNoiseX)));
+    }
+    for (int y = 0; y < map.getHeight(); ++y) {
+        for (int x = 0; x < map.getWidth(); ++x) {
+            const bool isWall = map.isWall(x, y);
+            out[static_cast<size_t>(y) * map.getWidth() + x] =
+                lighting.shade(x, y, isWall ? darkWall : darkGround, isWall ? lightWall : lightGround);
+        }
+    }
+}
+
+// Контрольная сумма, чтобы компилятор не выбросил работу
+unsigned long long checksum(const std::vector<tcod::ColorRGB>& colors)
+{
+    unsigned long long sum = 0;
+    for (const tcod::ColorRGB& c : colors) {
+        sum = sum * 31 + c.r + c.g * 7u + c.b * 13u;
+    }
+    return sum;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+    const uint64_t seed = argc > 2 ? static_cast<uint64_t>(std::atoll(argv[2])) : 1;
+    const int torchRadius = 8;
+
+    auto map = std::make_unique<Map>();
+    Rng mapRng(seed, 1);
+    map->generate(5, mapRng);
+    map->revealAll();
+    std::vector<Position> floorCells;
+    map->collectFloorCells(floorCells);
+    const Position player = floorCells[floorCells.size() / 2];
+
+    std::printf("ASC11 render lighting benchmark: %d frames, view %dx%d fully visible, torch radius %d\n\n",
+                frames, map->getWidth(), map->getHeight(), torchRadius);
+
+    std::vector<tcod::ColorRGB> colors(static_cast<size_t>(map->getWidth()) * map->getHeight());
+    TCODNoise noise(1);
+    FrameLighting lighting;
+    std::vector<PerCellSource> perCellSources;
+    Rng placeRng(seed, 3);
+    unsigned long long sink = 0;
+
+    for (int fireflyCount : {0, 10, 100}) {
+        std::vector<std::pair<int, int>> fireflies;
+        for (int i = 0; i < fireflyCount; ++i) {
+            const Position& cell = floorCells[static_cast<size_t>(placeRng.below(static_cast<int>(floorCells.size())))];
+            fireflies.push_back({cell.x, cell.y});
+        }
+
+        auto timeFrames = [&](auto&& shade) {
+            float torchX = 0.0f;
+            const BenchClock::time_point start = BenchClock::now();
+            for (int frame = 0; frame < frames; ++frame) {
+                torchX += 0.1f;
+                shade(torchX);
+                sink += checksum(colors);
+            }
+            return std::chrono::duration<double, std::micro>(BenchClock::now() - start).count() / frames;
+        };
+        const double oldMicros = timeFrames([&](float torchX) {
+            shadeOld(*map, player.x, player.y, torchRadius, fireflies, noise, torchX, colors);
+        });
+        const double tablesMicros = timeFrames([&](float torchX) {
+            shadeTables(*map, player.x, player.y, torchRadius, fireflies, noise, torchX, lighting, perCellSources, colors);
+        });
+        const double bufferMicros = timeFrames([&](float torchX) {
+            shadeBuffer(*map, player.x, player.y, torchRadius, fireflies, noise, torchX, lighting, colors);
+        });
+
+        std::printf("%3d fireflies (%lld cells splatted per frame)\n", fireflyCount, lighting.splatCells());
+        std::printf("  old:    per-cell sqrt + noise       %10.2f us/frame\n", oldMicros);
+        std::printf("  tables: per-cell loop over lights   %10.2f us/frame   speedup %.1fx\n",
+                    tablesMicros, tablesMicros > 0.0 ? oldMicros / tablesMicros : 0.0);
+        std::printf("  buffer: splat into light boxes      %10.2f us/frame   speedup %.1fx\n\n",
+                    bufferMicros, bufferMicros > 0.0 ? oldMicros / bufferMicros : 0.0);
+    }
+
+    std::printf("(checksum %llu)\n", sink);
+    return 0;
+}
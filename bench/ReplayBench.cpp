@@ -0,0 +1,198 @@
+// Бенчмарк воспроизведения записанной сессии (Replay.h) без окна на полной скорости.
+// Каждое записанное действие идёт через step, как в игре; по каждому ходу меряется время,
+// поэтому кроме ходов в секунду видны самые медленные ходы — их номер можно воспроизвести снова.
+// В конце отпечаток состояния сверяется с записанным: если игра разошлась с записью, код выхода 1.
+// Затем перемотка (Replay::seek) в случайные точки записи: время и совпадение отпечатка
+// с состоянием в той же точке при проигрывании с начала.
+//
+// Запуск: ASC11_bench_replay [file] [repeats] [seeks]
+//   file    — запись сессии (asc11_replay.bin пишет игра при выходе). "-" или без аргумента —
+//             записать случайную сессию здесь же (20000 ходов, сид 1) и проиграть её
+//   repeats — сколько раз проиграть запись (по умолчанию 3, печатается лучший прогон)
+//   seeks   — сколько точек перемотки проверить (по умолчанию 20)
+
+#include "BenchUtil.h"
+#include "Replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+// Случайная сессия: ход в одну из 8 сторон, на экране перка — случайный перк, после смерти — новая игра.
+Replay recordRandomSession(int turns, uint64_t seed)
+{
+    const Action perks[3] = {Action::ChoosePerk1, Action::ChoosePerk2, Action::ChoosePerk3};
+    auto game = std::make_unique<GameState>(seed);
+    Replay replay;
+    replay.startRecording(*game);
+    Rng input(seed, 99);
+    for (int played = 0; played < turns;) {
+        if (game->isDeathScreenActive) {
+            step(*game, Action::Restart);
+        } else if (game->isPerkChoiceActive) {
+            step(*game, perks[input.below(3)]);
+        } else if (step(*game, MOVE_ACTIONS[input.below(8)])) {
+            ++played;
+        }
+    }
+    replay.stopRecording(*game);
+    return replay;
+}
+
+struct SlowTurn {
+    double micros;
+    size_t action; // Номер действия в записи
+    int level;
+};
+
+struct ReplayRun {
+    double seconds = 0.0;
+    int turns = 0;
+    int finalLevel = 0;
+    uint64_t hash = 0;
+    std::vector<double> turnMicros;
+    std::vector<SlowTurn> slowest;
+};
+
+ReplayRun playReplay(const Replay& replay)
+{
+    ReplayRun run;
+    run.turnMicros.reserve(replay.actions.size());
+    auto game = replay.makeGame();
+    const BenchClock::time_point start = BenchClock::now();
+    for (size_t i = 0; i < replay.actions.size(); ++i) {
+        const BenchClock::time_point turnStart = BenchClock::now();
+        const bool turn = step(*game, replay.actions[i]);
+        if (!turn) {
+            continue;
+        }
+        const double micros = std::chrono::duration<double, std::micro>(BenchClock::now() - turnStart).count();
+        run.turnMicros.push_back(micros);
+        run.slowest.push_back(SlowTurn{micros, i, game->level});
+    }
+    run.seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+    run.turns = static_cast<int>(run.turnMicros.size());
+    run.finalLevel = game->level;
+    run.hash = game->stateHash();
+
+    const size_t keep = std::min<size_t>(5, run.slowest.size());
+    std::partial_sort(run.slowest.begin(), run.slowest.begin() + static_cast<std::ptrdiff_t>(keep), run.slowest.end(),
+                      [](const SlowTurn& a, const SlowTurn& b) { return a.micros > b.micros; });
+    run.slowest.resize(keep);
+    std::sort(run.turnMicros.begin(), run.turnMicros.end());
+    return run;
+}
+
+// Отпечатки состояния перед действиями points (по возрастанию) при проигрывании с начала.
+std::vector<uint64_t> hashesAt(const Replay& replay, const std::vector<size_t>& points)
+{
+    std::vector<uint64_t> hashes;
+    auto game = replay.makeGame();
+    size_t next = 0;
+    for (size_t i = 0; i <= replay.actions.size() && next < points.size(); ++i) {
+        while (next < points.size() && points[next] == i) {
+            hashes.push_back(game->stateHash());
+            ++next;
+        }
+        if (i < replay.actions.size()) {
+            step(*game, replay.actions[i]);
+        }
+    }
+    return hashes;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::string path = argc > 1 ? argv[1] : "-";
+    const int repeats = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+    const int seeks = argc > 3 ? std::max(0, std::atoi(argv[3])) : 20;
+
+    Replay replay;
+    if (path == "-") {
+        replay = recordRandomSession(20000, 1);
+        // Через файл и обратно, чтобы проверить и формат записи
+        const char* tempPath = "asc11_bench_replay.bin";
+        Replay loaded;
+        if (!saveReplay(tempPath, replay) || !loadReplay(tempPath, loaded) || loaded.actions != replay.actions ||
+            loaded.finalHash != replay.finalHash || loaded.keyframes.size() != replay.keyframes.size()) {
+            std::printf("replay file round trip failed\n");
+            return 1;
+        }
+        std::remove(tempPath);
+        std::printf("ASC11 replay benchmark: random session, ");
+    } else {
+        if (!loadReplay(path, replay)) {
+            std::printf("cannot read replay %s\n", path.c_str());
+            return 1;
+        }
+        std::printf("ASC11 replay benchmark: %s, ", path.c_str());
+    }
+    std::printf("%zu actions, seed %llu, world %dx%d\n\n", replay.actions.size(),
+                static_cast<unsigned long long>(replay.seed), replay.mapWidth, replay.mapHeight);
+
+    ReplayRun best;
+    bool matches = true;
+    for (int r = 0; r < repeats; ++r) {
+        ReplayRun run = playReplay(replay);
+        matches = matches && run.hash == replay.finalHash;
+        if (r == 0 || run.seconds < best.seconds) {
+            best = std::move(run);
+        }
+    }
+
+    std::printf("  %d turns, final floor %d, best of %d runs\n", best.turns, best.finalLevel, repeats);
+    std::printf("  %12.0f turns/sec\n", best.turns / std::max(best.seconds, 1e-9));
+    std::printf("  turn us: p50 %.2f  p99 %.2f  max %.2f\n", percentile(best.turnMicros, 50),
+                percentile(best.turnMicros, 99), best.turnMicros.empty() ? 0.0 : best.turnMicros.back());
+    std::printf("  slowest turns (action #, floor):\n");
+    for (const SlowTurn& turn : best.slowest) {
+        std::printf("    %10.2f us  #%zu  floor %d\n", turn.micros, turn.action, turn.level);
+    }
+    std::printf("\n  final state hash %016llx, recorded %016llx: %s\n", static_cast<unsigned long long>(best.hash),
+                static_cast<unsigned long long>(replay.finalHash), matches ? "match" : "MISMATCH");
+
+    // Перемотка: случайные точки, сверка с проигрыванием с начала
+    if (seeks > 0 && !replay.actions.empty()) {
+        size_t snapshotBytes = 0;
+        for (const Replay::Keyframe& keyframe : replay.keyframes) {
+            snapshotBytes += keyframe.snapshot.size();
+        }
+        std::printf("\n  %zu keyframes (interval %u actions and every floor), %.1f KB of snapshots\n",
+                    replay.keyframes.size(), replay.keyframeInterval, snapshotBytes / 1024.0);
+
+        Rng pick(replay.seed, 5);
+        std::vector<size_t> points;
+        for (int i = 0; i < seeks; ++i) {
+            points.push_back(static_cast<size_t>(pick.below(static_cast<int>(replay.actions.size()) + 1)));
+        }
+        std::sort(points.begin(), points.end());
+        const std::vector<uint64_t> expected = hashesAt(replay, points);
+
+        double totalMillis = 0.0;
+        double maxMillis = 0.0;
+        int seekMismatches = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            const BenchClock::time_point start = BenchClock::now();
+            auto game = replay.seek(points[i]);
+            const double millis = std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+            totalMillis += millis;
+            maxMillis = std::max(maxMillis, millis);
+            if (!game || game->stateHash() != expected[i]) {
+                ++seekMismatches;
+            }
+        }
+        const double fromStartMillis = 1000.0 * best.seconds * (static_cast<double>(points.back()) / replay.actions.size());
+        std::printf("  seek: %d points, avg %.2f ms, max %.2f ms (from start to the last point: ~%.1f ms)\n",
+                    seeks, totalMillis / seeks, maxMillis, fromStartMillis);
+        std::printf("  seek state hashes: %s (%d mismatches)\n", seekMismatches == 0 ? "match" : "MISMATCH", seekMismatches);
+        matches = matches && seekMismatches == 0;
+    }
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// Микробенчмарк генератора случайных чисел: Rng (PCG32) против std::rand().
+// Меряем ровно то, что делает игра: "случайное число в [0, n)" для маленьких n.
+//
+// Запуск: ASC11_bench_rng [millions]
+//   millions — сколько миллионов чисел тянуть на каждый вариант (по умолчанию 50)
+
+#include "Random.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+
+// Печатает результат; checksum не даёт компилятору выкинуть цикл.
+void report(const char* name, BenchClock::time_point start, BenchClock::time_point end, long long count, unsigned checksum)
+{
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::printf("  %-28s %8.2f ns/call  %8.1f M calls/s  (checksum %u)\n",
+                name, seconds * 1e9 / static_cast<double>(count),
+                static_cast<double>(count) / seconds / 1e6, checksum);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const long long millions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+    const long long count = millions * 1000000LL;
+    // Типичные границы из генератора карты и спавна: 2, 4, 100, ширина карты.
+    const int bounds[4] = {2, 4, 100, 80};
+
+    std::printf("ASC11 RNG benchmark: %lld M draws per variant\n", millions);
+
+    {
+        std::srand(12345);
+        unsigned checksum = 0;
+        const BenchClock::time_point start = BenchClock::now();
+        for (long long i = 0; i < count; ++i) {
+            checksum += static_cast<unsigned>(std::rand() % bounds[i & 3]);
+        }
+        report("std::rand() % n", start, BenchClock::now(), count, checksum);
+    }
+
+    {
+        Rng rng(12345, 1);
+        unsigned checksum = 0;
+        const BenchClock::time_point start = BenchClock::now();
+        for (long long i = 0; i < count; ++i) {
+            checksum += static_cast<unsigned>(rng.below(bounds[i & 3]));
+        }
+        report("Rng::below(n)", start, BenchClock::now(), count, checksum);
+    }
+
+    {
+        Rng rng(12345, 1);
+        unsigned checksum = 0;
+        const BenchClock::time_point start = BenchClock::now();
+        for (long long i = 0; i < count; ++i) {
+            checksum += rng.next();
+        }
+        report("Rng::next()", start, BenchClock::now(), count, checksum);
+    }
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Демонстрация бота с поиском ходов (SearchPlayer, MCTS на копиях GameState) против AutoPlayer.
+// Оба бота играют одни и те же сиды до смерти (или до MAX_TURNS / застревания, как ASC11_balance);
+// печатается этаж и число ходов по каждой партии, средние, и сколько решений поиска в секунду
+// (на решение — iterations копий состояния и столько же откатов).
+//
+// Запуск: ASC11_search_bot [games] [iterations] [depth] [seed]
+//   games      — сколько сидов сыграть (по умолчанию 5)
+//   iterations — итераций MCTS на решение (по умолчанию 64)
+//   depth      — длина отката в ходах (по умолчанию 20)
+//   seed       — сид первой партии (по умолчанию 1)
+
+#include "SearchPlayer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+
+const int MAX_TURNS = 20000;
+const int STUCK_TURNS = 200;
+
+struct GameResult {
+    int level = 0;
+    int turns = 0;
+    double seconds = 0.0;
+};
+
+// Партия до экрана смерти ботом Bot (AutoPlayer или SearchPlayer).
+template <typename Bot>
+GameResult playGame(uint64_t seed, Bot& bot)
+{
+    GameResult result;
+    const BenchClock::time_point start = BenchClock::now();
+    GameState game(seed);
+    while (!game.isDeathScreenActive && result.turns < MAX_TURNS && bot.aimlessTurns() < STUCK_TURNS) {
+        if (step(game, bot.next(game))) {
+            ++result.turns;
+        }
+    }
+    result.level = game.level;
+    result.seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+    return result;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int games = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 64;
+    const int depth = argc > 3 ? std::max(1, std::atoi(argv[3])) : 20;
+    const uint64_t seed = argc > 4 ? static_cast<uint64_t>(std::atoll(argv[4])) : 1;
+
+    std::printf("ASC11 search bot: %d games, %d iterations, rollout depth %d, seeds %llu..%llu\n\n", games,
+                iterations, depth, static_cast<unsigned long long>(seed),
+                static_cast<unsigned long long>(seed) + static_cast<unsigned long long>(games) - 1);
+    std::printf("  %6s  %14s  %14s\n", "seed", "auto floor/turns", "search floor/turns");
+
+    double autoLevels = 0.0;
+    double searchLevels = 0.0;
+    double autoTurns = 0.0;
+    double searchTurns = 0.0;
+    double searchSeconds = 0.0;
+    uint64_t searches = 0;
+    uint64_t clones = 0;
+    uint64_t rollouts = 0;
+    for (int i = 0; i < games; ++i) {
+        const uint64_t gameSeed = seed + static_cast<uint64_t>(i);
+        AutoPlayer autoBot(gameSeed);
+        SearchPlayer searchBot(gameSeed, iterations, depth);
+        const GameResult autoResult = playGame(gameSeed, autoBot);
+        const GameResult searchResult = playGame(gameSeed, searchBot);
+        std::printf("  %6llu  %8d / %5d  %8d / %5d\n", static_cast<unsigned long long>(gameSeed), autoResult.level,
+                    autoResult.turns, searchResult.level, searchResult.turns);
+        autoLevels += autoResult.level;
+        searchLevels += searchResult.level;
+        autoTurns += autoResult.turns;
+        searchTurns += searchResult.turns;
+        searchSeconds += searchResult.seconds;
+        searches += searchBot.searches();
+        clones += searchBot.clones();
+        rollouts += searchBot.rollouts();
+    }
+
+    std::printf("\n  mean floor: auto %.2f, search %.2f\n", autoLevels / games, searchLevels / games);
+    std::printf("  mean turns: auto %.0f, search %.0f\n", autoTurns / games, searchTurns / games);
+    std::printf("  %llu searched decisions of %.0f turns, %llu clones, %llu rollouts\n",
+                static_cast<unsigned long long>(searches), searchTurns, static_cast<unsigned long long>(clones),
+                static_cast<unsigned long long>(rollouts));
+    // Время поискового бота почти целиком уходит на поиск: ходы без мобов рядом — это один AutoPlayer
+    std::printf("  %12.1f searched decisions/sec\n", searches / std::max(searchSeconds, 1e-9));
+    std::printf("  %12.0f rollouts/sec\n", rollouts / std::max(searchSeconds, 1e-9));
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Бенчмарк удаления по одному: vector::erase (как раньше в Map::removeItem) против SlotMap::erase,
+// и мобов: EnemyStore::remove (перенос строк) вместе с поправкой сетки клеток.
+// Из контейнера на N элементов удаляется половина в случайном порядке, по ссылке на элемент.
+// erase из вектора сдвигает хвост — O(N) на удаление; slot map переносит последний элемент — O(1).
+//
+// Запуск: ASC11_bench_slotmap [seed]
+
+#include "BenchUtil.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+// Половина номеров 0..count-1 в случайном порядке.
+std::vector<int> pickVictims(Rng& rng, int count)
+{
+    std::vector<int> order(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        order[static_cast<size_t>(i)] = i;
+    }
+    for (int i = count - 1; i > 0; --i) {
+        std::swap(order[static_cast<size_t>(i)], order[static_cast<size_t>(rng.below(i + 1))]);
+    }
+    order.resize(static_cast<size_t>(count / 2));
+    return order;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint64_t seed = argc > 1 ? static_cast<uint64_t>(std::atoll(argv[1])) : 1;
+    const int counts[] = {100, 1000, 10000, 100000};
+
+    std::printf("ASC11 slot map benchmark: remove half of N one by one, seed %llu\n\n",
+                static_cast<unsigned long long>(seed));
+    std::printf("  %8s %16s %16s %18s\n", "N", "vector ns/erase", "SlotMap ns/erase", "EnemyStore ns/rm");
+
+    for (int count : counts) {
+        Rng rng(seed, 11);
+        const std::vector<int> victims = pickVictims(rng, count);
+
+        // --- vector<Item>: искать по позиции (индексы сдвигаются) и erase ---
+        std::vector<Item> vectorItems;
+        for (int i = 0; i < count; ++i) {
+            vectorItems.push_back(Item(i, 0, 5, 0, SYM_ITEM));
+        }
+        BenchClock::time_point start = BenchClock::now();
+        for (int victim : victims) {
+            auto it = std::find_if(vectorItems.begin(), vectorItems.end(),
+                                   [victim](const Item& item) { return item.pos.x == victim; });
+            vectorItems.erase(it);
+        }
+        const double vectorNanos = elapsedNanos(start, victims.size());
+
+        // --- SlotMap<Item>: ссылка остаётся верной, удаление переносит последний ---
+        SlotMap<Item> slotItems;
+        std::vector<ItemHandle> itemHandles;
+        for (int i = 0; i < count; ++i) {
+            itemHandles.push_back(slotItems.insert(Item(i, 0, 5, 0, SYM_ITEM)));
+        }
+        start = BenchClock::now();
+        for (int victim : victims) {
+            slotItems.erase(itemHandles[static_cast<size_t>(victim)]);
+        }
+        const double slotNanos = elapsedNanos(start, victims.size());
+
+        // --- EnemyStore + сетка: мобы всех типов вперемешку ---
+        GameState game(seed, 500, 500);
+        game.enemies.clear();
+        std::vector<SlotHandle> enemyHandles;
+        for (int i = 0; i < count; ++i) {
+            game.enemies.add(static_cast<EnemyType>(i % ENEMY_TYPE_COUNT), i % 500, i / 500, 3, 1, RgbColor{255, 50, 50});
+        }
+        for (size_t i = 0; i < game.enemies.size(); ++i) {
+            enemyHandles.push_back(game.enemies.handle(i));
+        }
+        game.rebuildEnemyGrid();
+        start = BenchClock::now();
+        for (int victim : victims) {
+            const int row = game.enemies.find(enemyHandles[static_cast<size_t>(victim)]);
+            game.enemyGrid.remove(row);
+            game.enemies.remove(static_cast<size_t>(row), [&game](size_t from, size_t to) { game.onEnemyMoved(from, to); });
+        }
+        const double enemyNanos = elapsedNanos(start, victims.size());
+
+        if (vectorItems.size() != slotItems.size() || slotItems.size() != game.enemies.size()) {
+            std::printf("size mismatch\n");
+            return 1;
+        }
+        std::printf("  %8d %16.1f %16.1f %18.1f\n", count, vectorNanos, slotNanos, enemyNanos);
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+// Бенчмарк спавна на забитых этажах: старый способ (до 100–200 случайных попыток
+// на каждого моба/предмет с проверкой клетки и перебором врагов) против FreeCellIndex
+// (одна выборка O(1) на спавн). Считает время и сколько сущностей реально встало на карту.
+//
+// Запуск: ASC11_bench_spawn [seeds] [level]
+//   seeds — сколько карт прогнать (по умолчанию 500)
+//   level — этаж, по которому считаются количества мобов (по умолчанию 200: 5 + level крыс)
+
+#include "FreeCellIndex.h"
+#include "Game.h"
+#include "Map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+
+// Сколько чего спавнит generateNewLevel на этаже level (все мобы и предметы открыты).
+struct SpawnCounts {
+    int enemies;
+    int items;
+
+    explicit SpawnCounts(int level)
+    {
+        const int rats = 5 + level;
+        const int bears = 2 + level / 2;
+        const int snakes = 3 + level / 2;
+        const int ghosts = 1 + level / 2;
+        const int crabs = 2 + level / 2;
+        enemies = rats + bears + snakes + ghosts + crabs;
+        items = 5 + 3 + 1; // ловушки (до 5), щиты, квестовый предмет
+    }
+};
+
+struct SpawnResult {
+    double micros = 0.0;
+    long long placed = 0;
+};
+
+// Так спавнил generateNewLevel раньше: случайные попытки по всей карте.
+// Враги проверяют только клетку (и могли вставать друг на друга),
+// предметы ещё перебирают всех врагов и предметы.
+void spawnByRejection(Map& map, const Position& player, const SpawnCounts& counts, Rng& rng,
+                      SpawnResult& result)
+{
+    std::vector<Position> enemies;
+    std::vector<Position> items;
+    enemies.reserve(static_cast<size_t>(counts.enemies));
+
+    const BenchClock::time_point start = BenchClock::now();
+    for (int i = 0; i < counts.enemies; ++i) {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            int x = rng.below(map.getWidth());
+            int y = rng.below(map.getHeight());
+            if (map.getCell(x, y) == SYM_FLOOR &&
+                !(x == player.x && y == player.y) &&
+                !map.isExit(x, y)) {
+                enemies.push_back(Position(x, y));
+                break;
+            }
+        }
+    }
+    for (int i = 0; i < counts.items; ++i) {
+        for (int attempt = 0; attempt < 200; ++attempt) {
+            int x = rng.below(map.getWidth());
+            int y = rng.below(map.getHeight());
+            bool occupied = false;
+            for (const Position& e : enemies) {
+                if (e.x == x && e.y == y) {
+                    occupied = true;
+                    break;
+                }
+            }
+            for (const Position& it : items) {
+                if (it.x == x && it.y == y) {
+                    occupied = true;
+                    break;
+                }
+            }
+            if (occupied) continue;
+            if (map.getCell(x, y) == SYM_FLOOR &&
+                !(x == player.x && y == player.y) &&
+                !map.isExit(x, y) &&
+                !map.getItemAt(x, y).valid()) {
+                items.push_back(Position(x, y));
+                break;
+            }
+        }
+    }
+    result.micros += std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+    result.placed += static_cast<long long>(enemies.size() + items.size());
+}
+
+// Новый способ: индекс свободных клеток, каждый спавн — одна выборка.
+// Время включает построение индекса.
+void spawnByIndex(const Map& map, const Position& player, const SpawnCounts& counts, Rng& rng,
+                  FreeCellIndex& freeCells, SpawnResult& result)
+{
+    const BenchClock::time_point start = BenchClock::now();
+    freeCells.build(map);
+    freeCells.occupy(player.x, player.y);
+    long long placed = 0;
+    Position cell;
+    for (int i = 0; i < counts.enemies + counts.items; ++i) {
+        if (!freeCells.take(rng, cell)) {
+            break;
+        }
+        ++placed;
+    }
+    result.micros += std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+    result.placed += placed;
+}
+
+void printResult(const char* name, const SpawnResult& result, int seeds, long long requested)
+{
+    std::printf("  %-34s %10.2f us/level   placed %lld / %lld (%.1f%%)\n",
+                name, result.micros / seeds, result.placed, requested,
+                requested > 0 ? result.placed * 100.0 / static_cast<double>(requested) : 0.0);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int seeds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 500;
+    const int level = argc > 2 ? std::max(2, std::atoi(argv[2])) : 200;
+    const SpawnCounts counts(level);
+    const long long requested = static_cast<long long>(counts.enemies + counts.items) * seeds;
+
+    std::printf("ASC11 spawn benchmark: %d seeds, level %d (%d enemies + %d items per level), map %dx%d\n\n",
+                seeds, level, counts.enemies, counts.items, Map::DEFAULT_WIDTH, Map::DEFAULT_HEIGHT);
+
+    // --- 1. Один и тот же набор карт, два способа спавна ---
+    {
+        auto map = std::make_unique<Map>();
+        FreeCellIndex freeCells;
+        SpawnResult rejection;
+        SpawnResult indexed;
+        long long floorCells = 0;
+        for (int seed = 0; seed < seeds; ++seed) {
+            Rng mapRng(static_cast<uint64_t>(seed), 1);
+            map->generate(level, mapRng);
+            const Position player(map->getWidth() / 2, map->getHeight() / 2);
+
+            Rng spawnRng(static_cast<uint64_t>(seed), 2);
+            spawnByRejection(*map, player, counts, spawnRng, rejection);
+            spawnRng.seed(static_cast<uint64_t>(seed), 2);
+            spawnByIndex(*map, player, counts, spawnRng, freeCells, indexed);
+            floorCells += freeCells.size() + counts.enemies + counts.items;
+        }
+        std::printf("Spawn only (same maps, ~%lld free floor cells per level)\n", floorCells / seeds);
+        printResult("rejection sampling (old)", rejection, seeds, requested);
+        printResult("FreeCellIndex (build + take)", indexed, seeds, requested);
+    }
+
+    std::printf("\n");
+
+    // --- 2. Полный generateNewLevel на этом этаже ---
+    {
+        auto game = std::make_unique<GameState>(0);
+        game->unlockedRat = game->unlockedBear = game->unlockedSnake = true;
+        game->unlockedGhost = game->unlockedCrab = true;
+        game->unlockedMedkit = game->unlockedMaxHP = game->unlockedShield = true;
+        game->unlockedTrap = game->unlockedQuest = true;
+
+        double spawnMicros = 0.0;
+        long long enemies = 0;
+        for (int seed = 0; seed < seeds; ++seed) {
+            game->reseed(static_cast<uint64_t>(seed));
+            game->level = level;
+            const BenchClock::time_point start = BenchClock::now();
+            game->generateNewLevel();
+            const double micros = std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+            spawnMicros += std::max(0.0, micros - game->map.lastGenTimings.total());
+            enemies += static_cast<long long>(game->enemies.size());
+        }
+        std::printf("GameState::generateNewLevel\n");
+        std::printf("  spawn + fov: %.2f us/level   enemies %lld / %lld\n",
+                    spawnMicros / seeds, enemies, static_cast<long long>(counts.enemies) * seeds);
+    }
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Бенчмарк хода симуляции без окна: только библиотека ASC11_sim, ни SDL, ни libtcod.
+// Игра крутится через step(GameState&, Action), как её будут крутить боты и пакетные прогоны:
+// случайный ход в одну из 8 сторон, на экране перка — случайный перк, после смерти — новая игра.
+// Печатает ходов в секунду на одном ядре и сколько этажей и смертей случилось за прогон.
+//
+// Запуск: ASC11_bench_step [turns] [seed]
+//   turns — сколько ходов сделать (по умолчанию 200000)
+//   seed  — сид игры (по умолчанию 1)
+
+#include "Game.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+using BenchClock = std::chrono::steady_clock;
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int turns = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200000;
+    const uint64_t seed = argc > 2 ? static_cast<uint64_t>(std::atoll(argv[2])) : 1;
+    const Action perks[3] = {Action::ChoosePerk1, Action::ChoosePerk2, Action::ChoosePerk3};
+
+    auto game = std::make_unique<GameState>(seed);
+    game->map.computeFOV(game->player.pos.x, game->player.pos.y, game->torchRadius, true);
+    Rng input(seed, 99); // Отдельный поток для "нажатий", чтобы не трогать RNG игры
+
+    int played = 0;
+    int floors = 0;
+    int deaths = 0;
+    const BenchClock::time_point start = BenchClock::now();
+    while (played < turns) {
+        if (game->isDeathScreenActive) {
+            step(*game, Action::Restart);
+            ++deaths;
+        } else if (game->isPerkChoiceActive) {
+            step(*game, perks[input.below(3)]);
+            ++floors;
+        } else if (step(*game, MOVE_ACTIONS[input.below(8)])) {
+            ++played;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+    std::printf("ASC11 step benchmark: %d turns, seed %llu\n\n", played, static_cast<unsigned long long>(seed));
+    std::printf("  %12.0f turns/sec\n", played / std::max(seconds, 1e-9));
+    std::printf("  %12.2f us per turn\n", 1e6 * seconds / played);
+    std::printf("  %12d floors, %d deaths, final floor %d\n", floors, deaths, game->level);
+    return 0;
+}
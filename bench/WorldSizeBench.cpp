@@ -0,0 +1,97 @@
+// Бенчмарк цены хода в зависимости от размера мира.
+// Для каждого размера создаёт GameState с картой WxH, делает случайные ходы через step
+// и печатает время одного хода (mean/p50/p99), время генерации мира и сколько кусков карты выделено.
+// Цена хода не должна расти вместе с миром: FOV считается в окне вокруг игрока,
+// а память тратится только на куски, где есть что-то кроме скалы.
+//
+// Запуск: ASC11_bench_worldsize [turns] [level] [seed]
+//   turns — сколько ходов сделать на каждом размере (по умолчанию 5000)
+//   level — этаж, с которого начинаем (по умолчанию 10)
+//   seed  — сид игры (по умолчанию 1)
+
+#include "BenchUtil.h"
+#include "Map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+struct WorldSize {
+    int width;
+    int height;
+};
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int turns = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5000;
+    const int level = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10;
+    const uint64_t seed = argc > 3 ? static_cast<uint64_t>(std::atoll(argv[3])) : 1;
+
+    const WorldSize sizes[] = {
+        {Map::DEFAULT_WIDTH, Map::DEFAULT_HEIGHT},
+        {250, 250},
+        {500, 500},
+        {1000, 1000},
+        {2000, 2000},
+    };
+    const double chunkKb = static_cast<double>(Map::chunkBytes()) / 1024.0; // Клетки + биты explored/visible
+
+    std::printf("ASC11 world size benchmark: %d turns per size, level %d, seed %llu\n\n",
+                turns, level, static_cast<unsigned long long>(seed));
+    std::printf("  %-11s %10s %8s %10s %10s %10s %7s %14s\n",
+                "world", "gen ms", "enemies", "mean us", "p50 us", "p99 us", "levels", "chunks (MB)");
+
+    for (const WorldSize& size : sizes) {
+        auto game = std::make_unique<GameState>(seed, size.width, size.height);
+
+        // Открываем всех мобов и предметы и переходим на глубокий этаж, чтобы врагов было много.
+        game->unlockedRat = game->unlockedBear = game->unlockedSnake = true;
+        game->unlockedGhost = game->unlockedCrab = true;
+        game->unlockedMedkit = game->unlockedMaxHP = game->unlockedShield = true;
+        game->unlockedTrap = game->unlockedQuest = true;
+        game->level = level;
+        const BenchClock::time_point genStart = BenchClock::now();
+        game->generateNewLevel();
+        const double genMillis = std::chrono::duration<double, std::milli>(BenchClock::now() - genStart).count();
+        const size_t enemies = game->enemies.size();
+
+        Rng input(seed, 99); // Отдельный поток для "нажатий", чтобы не трогать RNG игры
+        std::vector<double> samples;
+        samples.reserve(turns);
+        int levels = 1;
+        for (int turn = 0; turn < turns; ++turn) {
+            // Переходы между уровнями и смерть — не ход, их в замер не берём.
+            if (game->isPerkChoiceActive) {
+                game->applyLevelChoice(3);
+                ++levels;
+            }
+            if (game->isDeathScreenActive) {
+                game->restartGame();
+                ++levels;
+            }
+            const Action action = MOVE_ACTIONS[input.below(8)];
+            const BenchClock::time_point start = BenchClock::now();
+            step(*game, action);
+            const BenchClock::time_point end = BenchClock::now();
+            samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double s : samples) {
+            sum += s;
+        }
+        const int chunks = game->map.getAllocatedChunkCount();
+        std::printf("  %5dx%-5d %10.2f %8zu %10.2f %10.2f %10.2f %7d %6d (%5.1f)\n",
+                    size.width, size.height, genMillis, enemies, sum / turns,
+                    percentile(samples, 50.0), percentile(samples, 99.0), levels,
+                    chunks, chunks * chunkKb / 1024.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Game.h"
+
+#include <cstdint>
+#include <vector>
+
+// Простой бот для пакетных прогонов (балансировка перков и спавна): решает, какое действие подать в step.
+// Играет только тем, что видит игрок: карта и предметы — по исследованным клеткам, мобы — соседние.
+//  * экран перка — заданный перк (или случайный), экран смерти — Restart;
+//  * краб на игроке (инверсия) — ход на месте, чтобы его снять;
+//  * моб на соседней клетке — бьёт его (шаг в его сторону);
+//  * иначе идёт по исследованным клеткам: к полезному предмету рядом (аптечка — только если ранен,
+//    MaxHP, щит, квестовый), к лестнице, если она уже найдена, или к краю тумана, а если тумана не осталось —
+//    к дальнему предмету. Известные ловушки обходит.
+//    Край тумана, на котором бот уже стоял, второй раз целью не считается (за ним стена, которую не видно),
+//    поэтому исследование этажа всегда кончается; дальше, если лестницы так и нет, бот бродит случайно.
+// Все случайные решения — из своего Rng, поэтому один и тот же сид игры и бота даёт одну и ту же партию.
+class AutoPlayer {
+public:
+    static const int PERK_RANDOM = 0; // Перк на каждом этаже выбирается случайно
+    static const int ITEM_DETOUR = 12; // На сколько шагов бот отходит за предметом от пути к лестнице или туману
+
+    // perkChoice_: 1, 2, 3 — всегда этот перк, PERK_RANDOM — случайный.
+    explicit AutoPlayer(uint64_t seed, int perkChoice_ = PERK_RANDOM);
+
+    // Следующее действие для state (state не меняется).
+    Action next(const GameState& state);
+
+    // Сколько ходов подряд бот бродит наугад (нет ни цели, ни моба рядом): лестница недостижима.
+    // Пакетный прогон по нему останавливает застрявшие партии.
+    int aimlessTurns() const { return aimless; }
+
+private:
+    Rng rng;
+    int perkChoice;
+    int aimless = 0;
+    // Клетки этажа, на которых бот уже стоял, по биту на клетку (сбрасывается по GameState::levelSerial)
+    std::vector<uint64_t> visited;
+    uint64_t visitedLevel = 0;
+
+    // Рабочие буферы одного решения: поиск в ширину от игрока и что бот знает о клетке.
+    // Клетка считается чистой (флагов нет, не посещена), пока её stamp не равен generation:
+    // новое решение только увеличивает generation, а не заполняет буферы размером с карту.
+    // Копия бота буферы не наследует — у неё свои, пустые до первого решения.
+    struct SearchBuffers {
+        SearchBuffers() = default;
+        SearchBuffers(const SearchBuffers&) {}
+        SearchBuffers& operator=(const SearchBuffers&) { return *this; }
+
+        uint32_t generation = 0;
+        std::vector<uint32_t> stamp;
+        std::vector<int32_t> parent;   // Откуда пришли в клетку; -1 — клетка не посещена
+        std::vector<int32_t> distance; // Шагов от игрока
+        // Флаги CELL_* (AutoPlayer.cpp). Предметы отмечаются перед поиском, а карта читается лениво
+        // (flagsAt) — поиск обычно останавливается рано и почти всю карту не трогает
+        std::vector<uint8_t> cellFlags;
+        std::vector<int32_t> queue;
+    };
+    SearchBuffers search;
+
+    // Начать новое решение на карте из cellCount клеток: все клетки становятся чистыми.
+    void beginSearch(size_t cellCount);
+    // Клетка cell в текущем решении; при первом обращении за решение — чистится.
+    void touch(int32_t cell);
+    void markItems(const GameState& state);
+    uint8_t flagsAt(const Map& map, int x, int y);
+    bool touchesFog(const Map& map, int x, int y);
+    // Первый шаг пути от игрока к клетке target (индекс y * width + x).
+    Action firstStepTo(const GameState& state, int32_t target) const;
+};
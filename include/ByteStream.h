@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Запись чисел в байтовый буфер (little-endian) для файлов записей и снимков состояния.
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<uint8_t>& out_) : out(out_) {}
+
+    void u8(uint8_t value) { out.push_back(value); }
+    void u32(uint32_t value) { put(value, 4); }
+    void u64(uint64_t value) { put(value, 8); }
+    void i32(int32_t value) { put(static_cast<uint32_t>(value), 4); }
+    void bytes(const void* data, size_t size)
+    {
+        const uint8_t* begin = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), begin, begin + size);
+    }
+    void string(const std::string& text)
+    {
+        u32(static_cast<uint32_t>(text.size()));
+        bytes(text.data(), text.size());
+    }
+
+    // Байты парами (длина серии 1..255, байт). Клетки карты — длинные серии стен и пола,
+    // поэтому кусок 64x64 ужимается в разы.
+    void runLength(const uint8_t* data, size_t size)
+    {
+        size_t i = 0;
+        while (i < size) {
+            size_t run = 1;
+            while (i + run < size && run < 255 && data[i + run] == data[i]) {
+                ++run;
+            }
+            u8(static_cast<uint8_t>(run));
+            u8(data[i]);
+            i += run;
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out;
+
+    void put(uint64_t value, int size)
+    {
+        for (int i = 0; i < size; ++i) {
+            out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+};
+
+// Чтение того, что записал ByteWriter. Любое чтение за концом или испорченная серия
+// ставит ok() в false и дальше возвращает нули — проверять достаточно один раз в конце.
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data_, size_t size_) : data(data_), size(size_) {}
+    explicit ByteReader(const std::vector<uint8_t>& buffer) : data(buffer.data()), size(buffer.size()) {}
+
+    uint8_t u8() { return static_cast<uint8_t>(take(1)); }
+    uint32_t u32() { return static_cast<uint32_t>(take(4)); }
+    uint64_t u64() { return take(8); }
+    int32_t i32() { return static_cast<int32_t>(static_cast<uint32_t>(take(4))); }
+    bool bytes(void* dest, size_t count)
+    {
+        if (!valid || size - pos < count) {
+            valid = false;
+            return false;
+        }
+        const uint8_t* begin = data + pos;
+        std::copy(begin, begin + count, static_cast<uint8_t*>(dest));
+        pos += count;
+        return true;
+    }
+    std::string string()
+    {
+        const uint32_t length = u32();
+        if (!valid || size - pos < length) {
+            valid = false;
+            return std::string();
+        }
+        std::string text(reinterpret_cast<const char*>(data + pos), length);
+        pos += length;
+        return text;
+    }
+
+    // Ровно count байт из серий runLength.
+    bool runLength(uint8_t* dest, size_t count)
+    {
+        size_t filled = 0;
+        while (valid && filled < count) {
+            const size_t run = u8();
+            const uint8_t value = u8();
+            if (run == 0 || run > count - filled) {
+                valid = false;
+                break;
+            }
+            std::fill(dest + filled, dest + filled + run, value);
+            filled += run;
+        }
+        return valid;
+    }
+
+    bool ok() const { return valid; }
+    size_t remaining() const { return size - pos; }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    bool valid = true;
+
+    uint64_t take(int count)
+    {
+        if (!valid || size - pos < static_cast<size_t>(count)) {
+            valid = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < count; ++i) {
+            value |= static_cast<uint64_t>(data[pos++]) << (8 * i);
+        }
+        return value;
+    }
+};
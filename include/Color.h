@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+// Цвет в логике игры (игрок, мобы, выход). Свой тип, чтобы симуляция не зависела от libtcod;
+// Graphics переводит его в tcod::ColorRGB при отрисовке.
+struct RgbColor {
+    uint8_t r, g, b;
+};
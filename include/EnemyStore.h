@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Entity.h"
+#include "SlotMap.h"
+
+// Тип моба. Порядок перечисления — порядок групп в EnemyStore и порядок спавна в generateNewLevel.
+enum class EnemyType : uint8_t { Rat, Bear, Snake, Ghost, Crab };
+constexpr int ENEMY_TYPE_COUNT = 5;
+
+int enemySymbol(EnemyType type);       // SYM_ENEMY, SYM_BEAR, ...
+const char* enemyName(EnemyType type); // "Rat", "Bear", ... (подсказки, панель Nearby)
+
+// Все мобы этажа, по колонкам (SoA): у каждого поля свой массив, индекс — номер моба.
+// Мобы одного типа лежат подряд, группы идут в порядке EnemyType, поэтому каждое поведение
+// (погоня крыс и медведей, змеи, призраки, крабы) — отдельный цикл по своему отрезку
+// [groupBegin, groupEnd) без ветвления по типу внутри и с последовательным доступом к памяти.
+// Индексы плотные (0 .. size-1) и меняются при add и remove: удаление за O(1) ставит на место
+// удалённого последнего моба его группы, а на освободившийся конец группы — последнего моба следующей
+// группы и т.д. (по одному переносу на тип). Кто хранит моба дольше хода, хранит handle(i) — он стабилен.
+class EnemyStore {
+public:
+    // --- Колонки, по элементу на моба ---
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<int> health;
+    std::vector<int> maxHealth;
+    std::vector<int> damage;
+    std::vector<RgbColor> color;
+
+    // --- Состояние краба (у остальных типов всегда 0) ---
+    // crabAttached: краб "прицепился" к игроку и инвертирует управление.
+    // crabCooldown > 0: краб недавно отцепился, убегает и пока не может снова цепляться.
+    std::vector<uint8_t> crabAttached;
+    std::vector<int> crabCooldown;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+    size_t groupBegin(EnemyType type) const { return type == EnemyType::Rat ? 0 : groupEnds[static_cast<size_t>(type) - 1]; }
+    size_t groupEnd(EnemyType type) const { return groupEnds[static_cast<size_t>(type)]; }
+
+    EnemyType typeOf(size_t i) const;
+    int symbol(size_t i) const { return enemySymbol(typeOf(i)); }
+    bool isAlive(size_t i) const { return health[i] > 0; }
+    void takeDamage(size_t i, int amount)
+    {
+        health[i] -= amount;
+        if (health[i] < 0) {
+            health[i] = 0;
+        }
+    }
+
+    // Стабильная ссылка на моба i и обратно: индекс моба по ссылке или -1, если его уже убрали.
+    SlotHandle handle(size_t i) const { return handles[i]; }
+    int find(SlotHandle handle) const
+    {
+        const uint32_t row = index.row(handle);
+        return row == SlotIndex::NONE ? -1 : static_cast<int>(row);
+    }
+
+    // Новый моб в конец группы своего типа (здоровье = maxHealth), O(1). Возвращает его индекс.
+    // Чтобы освободить место, первый моб каждой следующей группы переезжает в её конец —
+    // если спавнить по типам в порядке EnemyType (как generateNewLevel), никто не переезжает.
+    size_t add(EnemyType type, int x, int y, int maxHealth, int damage, const RgbColor& color);
+    void clear();
+
+    // Убрать моба i за O(ENEMY_TYPE_COUNT). Каждый перенос строки сообщается onMoved(from, to),
+    // чтобы владелец поправил свои индексы (сетку клеток); после всех переносов последняя строка отрезается.
+    template <typename Fn>
+    void remove(size_t i, Fn onMoved)
+    {
+        index.release(handles[i]);
+        size_t hole = i;
+        for (size_t t = static_cast<size_t>(typeOf(i)); t < groupEnds.size(); ++t) {
+            // Дыра лежит в группе t: закрываем её последним мобом группы, дыра уходит в конец группы
+            const size_t last = groupEnds[t] - 1;
+            moveRow(last, hole, onMoved);
+            hole = last;
+            --groupEnds[t];
+        }
+        resizeColumns(size() - 1);
+    }
+
+    // Убрать всех мёртвых (обход с конца, поэтому перенесённые строки уже проверены).
+    // onRemoved(i, type) зовётся до удаления моба i, onMoved — как в remove. Возвращает, сколько убрано.
+    template <typename RemovedFn, typename MovedFn>
+    size_t removeDead(RemovedFn onRemoved, MovedFn onMoved)
+    {
+        size_t removed = 0;
+        for (size_t i = size(); i > 0; --i) {
+            if (health[i - 1] <= 0) {
+                onRemoved(i - 1, typeOf(i - 1));
+                remove(i - 1, onMoved);
+                ++removed;
+            }
+        }
+        return removed;
+    }
+
+    // Моб i в виде Entity (копия) — для отрисовки, которая рисует игрока, мобов и выход одинаково.
+    Entity entity(size_t i) const;
+
+private:
+    std::array<size_t, ENEMY_TYPE_COUNT> groupEnds{}; // Конец группы каждого типа (начало — конец предыдущей)
+    std::vector<SlotHandle> handles;                   // Ссылка на каждого моба (колонка)
+    SlotIndex index;                                   // Ссылка -> индекс моба
+
+    // Перенести строку from на место to (строка to затирается).
+    void copyRow(size_t from, size_t to);
+    template <typename Fn>
+    void moveRow(size_t from, size_t to, Fn onMoved)
+    {
+        if (from == to) {
+            return;
+        }
+        copyRow(from, to);
+        onMoved(from, to);
+    }
+    void resizeColumns(size_t count);
+};
@@ -1,16 +1,6 @@
 #pragma once
 
-#ifndef TCOD_NO_CONSOLE
-#define TCOD_NO_CONSOLE 1
-#endif
-#ifdef _MSC_VER
-#pragma warning(push)
-#pragma warning(disable : 26439) // подавляем анализатор для внешнего libtcod
-#endif
-#include <libtcod.hpp>
-#ifdef _MSC_VER
-#pragma warning(pop)
-#endif
+#include "Color.h"
 
 // Символы, используемые в игре (CP437-compatible: отображаются с classic tileset).
 enum GameSymbols {
@@ -42,19 +32,12 @@ class Entity {
 public:
     Position pos;
     int symbol; // Код символа (ASCII, CP437 или Unicode при совместимом тайлсете)
-    TCOD_ColorRGB color;
+    RgbColor color;
     int health;
     int maxHealth;
     int damage;
 
-    // Дополнительные поля, которые используются только некоторыми типами мобов.
-    // Для краба:
-    //  - crabAttachedToPlayer == true, если краб "прицепился" к игроку и инвертирует управление.
-    //  - crabAttachmentCooldown > 0, если краб недавно отцепился и пока не может снова цепляться.
-    bool crabAttachedToPlayer;
-    int  crabAttachmentCooldown;
-
-    Entity(int startX, int startY, int sym, const TCOD_ColorRGB& col);
+    Entity(int startX, int startY, int sym, const RgbColor& col);
     void move(int dx, int dy);
     void takeDamage(int amount);
     bool isAlive() const;
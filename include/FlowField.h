@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Map.h"
+#include "Random.h"
+
+// Как ходит моб, который спускается по полю.
+enum class FlowMoves {
+    Orthogonal, // По кресту (крысы, медведи, крабы)
+    Diagonal    // Только по диагонали (змеи)
+};
+
+// Поле расстояний до цели (игрока) по проходимым клеткам — одно на всех мобов с одинаковым шагом.
+// Строится поиском в ширину один раз за ход, а каждый моб просто делает шаг к соседу
+// с меньшим расстоянием, поэтому обходит преграды в комнатах и не застревает, как жадный шаг по осям.
+// Цена — O(клеток окна) за ход, от числа мобов не зависит.
+//
+// Поле считается в квадратном окне radius вокруг цели: на больших мирах далёкие мобы
+// всё равно не успеют дойти, а цена хода не растёт вместе с картой. Вне окна и в недостижимых
+// клетках расстояния нет (-1) — там моб ходит по-старому.
+class FlowField {
+public:
+    static constexpr int UNREACHED = -1;
+
+    // Пересчитать поле до (targetX, targetY). Если цель, карта и шаг с прошлого раза не менялись,
+    // ничего не делает. Возвращает true, если поле пересчитано.
+    // Для Diagonal источниками служат ещё и 4 соседа цели по кресту (расстояние 1): диагональный шаг
+    // не меняет чётность x + y, а змея кусает с любой соседней клетки — так до цели доходят змеи обеих чётностей.
+    bool build(const Map& map, int targetX, int targetY, int radius, FlowMoves moves);
+    // Забыть посчитанное: следующий build пересчитает поле. Нужно, когда под тем же адресом
+    // оказалась другая карта с тем же счётчиком изменений (присваивание GameState).
+    void invalidate() { valid = false; }
+
+    // Сколько шагов до цели из (x, y), или UNREACHED.
+    int distance(int x, int y) const
+    {
+        const int wx = x - originX;
+        const int wy = y - originY;
+        if (wx < 0 || wy < 0 || wx >= width || wy >= height) {
+            return UNREACHED;
+        }
+        return distances[static_cast<size_t>(wy) * static_cast<size_t>(width) + static_cast<size_t>(wx)];
+    }
+
+    // Шаг из (x, y) к соседу на 1 ближе к цели. Если таких соседей несколько, выбирает случайного (rng).
+    // Возвращает false, если поля здесь нет или (x, y) уже цель.
+    bool step(int x, int y, Rng& rng, int& dx, int& dy) const;
+
+    uint64_t builds() const { return buildCount; } // Сколько раз поле реально пересчитывалось
+
+private:
+    bool valid = false;
+    int targetX = 0, targetY = 0, radius = 0;
+    FlowMoves moves = FlowMoves::Orthogonal;
+    uint64_t mapMutation = 0;
+    const Map* map = nullptr;
+    uint64_t buildCount = 0;
+
+    int originX = 0, originY = 0; // Левый верхний угол окна на карте
+    int width = 0, height = 0;
+    std::vector<int32_t> distances; // По клетке окна
+    std::vector<int32_t> queue;     // Очередь поиска в ширину (индексы клеток окна)
+};
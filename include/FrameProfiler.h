@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+
+// Этапы, которые показывает оверлей профайлера.
+// Кадровые меряются в runFrame каждый кадр, ходовые — в step (TurnTimings) раз за ход.
+enum class ProfileStage {
+    // Кадр
+    Fov,          // updateFOV (computeFOV/addFOV, если что-то сдвинулось)
+    DrawMap,      // drawMap: свет и клетки окна карты
+    DrawEntities, // Мобы, предметы, выход, игрок
+    DrawUI,       // drawUI
+    Hover,        // Поиск под мышью и подписи
+    Present,      // refreshScreen: спрайты и вывод кадра бэкендом
+    // Ход
+    TurnMove,
+    TurnCombat,
+    TurnItems,
+    TurnEnemies,
+    TurnFireflies,
+    TurnEffects,
+    TurnFov,
+    Count
+};
+
+// Скользящая статистика по этапам за последние WINDOW кадров (и WINDOW ходов) —
+// чтобы на медленном этаже было видно, какой этап тормозит, без внешнего профайлера.
+// Замер — пара чтений steady_clock на этап, поэтому профайлер работает всегда,
+// а оверлей лишь показывает уже накопленное.
+class FrameProfiler {
+public:
+    static const int WINDOW = 120;
+    static const int STAGE_COUNT = static_cast<int>(ProfileStage::Count);
+
+    struct StageStats {
+        double average = 0.0; // мкс
+        double peak = 0.0;    // мкс, максимум за окно
+    };
+
+    // Время этапа текущего кадра (или хода, для ходовых этапов); повторные вызовы складываются.
+    void add(ProfileStage stage, double micros);
+    // Закрыть кадр длительностью frameMicros. turnTaken — в этом кадре был ход (ходовые этапы в окно ходов).
+    void commitFrame(double frameMicros, bool turnTaken);
+
+    // Кадровые этапы — по окну кадров, ходовые — по окну ходов.
+    StageStats stats(ProfileStage stage) const;
+    StageStats frameStats() const;
+    int framesInWindow() const { return frameCount; }
+    int turnsInWindow() const { return turnCount; }
+
+    static const char* stageName(ProfileStage stage);
+    static bool isTurnStage(ProfileStage stage) { return stage >= ProfileStage::TurnMove; }
+
+private:
+    using Sample = std::array<double, STAGE_COUNT>;
+
+    Sample current{};
+    std::array<Sample, WINDOW> frames{};
+    std::array<double, WINDOW> frameTotals{};
+    int frameCount = 0;
+    int frameNext = 0;
+    std::array<Sample, WINDOW> turns{};
+    int turnCount = 0;
+    int turnNext = 0;
+};
+
+// Замер этапа от создания до конца области видимости.
+class ProfileScope {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ProfileScope(FrameProfiler& profiler_, ProfileStage stage_)
+        : profiler(profiler_), stage(stage_), start(Clock::now())
+    {
+    }
+    ~ProfileScope()
+    {
+        profiler.add(stage, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    FrameProfiler& profiler;
+    ProfileStage stage;
+    Clock::time_point start;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Entity.h"
+#include "Map.h"
+#include "Random.h"
+
+// Множество свободных клеток пола для спавна.
+// Строится один раз после генерации карты; занятые клетки удаляются обменом с последней
+// (swap-remove), поэтому и выбор случайной свободной клетки, и пометка "занято" — O(1).
+// В отличие от "100 случайных попыток" спавн не промахивается на забитых этажах:
+// пока свободные клетки есть, каждый спавн находит место.
+// Обратный индекс (клетка -> место в cells) разбит на куски карты (Map::CHUNK_SIZE): таблица есть
+// только у кусков, где есть пол, поэтому память, как и у самой карты, зависит от занятой площади.
+class FreeCellIndex {
+public:
+    // Собрать все клетки пола без предметов и выхода.
+    void build(const Map& map)
+    {
+        width = map.getWidth();
+        height = map.getHeight();
+        chunksX = (width + Map::CHUNK_MASK) >> Map::CHUNK_SHIFT;
+        const int chunksY = (height + Map::CHUNK_MASK) >> Map::CHUNK_SHIFT;
+        map.collectFloorCells(cells);
+
+        // Таблицы — только кускам с полом; таблицы кусков, где пола больше нет, освобождаются
+        chunkUsed.assign(static_cast<size_t>(chunksX) * static_cast<size_t>(chunksY), 0);
+        for (const Position& cell : cells) {
+            chunkUsed[chunkIndex(cell.x, cell.y)] = 1;
+        }
+        chunkSlots.resize(chunkUsed.size());
+        for (size_t i = 0; i < chunkSlots.size(); ++i) {
+            if (chunkUsed[i]) {
+                chunkSlots[i].assign(static_cast<size_t>(Map::CHUNK_SIZE) * Map::CHUNK_SIZE, -1);
+            } else {
+                std::vector<int32_t>().swap(chunkSlots[i]);
+            }
+        }
+        for (size_t i = 0; i < cells.size(); ++i) {
+            *slotAt(cells[i].x, cells[i].y) = static_cast<int32_t>(i);
+        }
+        // Выход стоит на своей клетке, а ловушка '.' совпадает с символом пола —
+        // поэтому выход и предметы убираем явно.
+        occupy(map.exitPos.x, map.exitPos.y);
+        for (const Item& item : map.items) {
+            occupy(item.pos.x, item.pos.y);
+        }
+    }
+
+    // Клетка занята (игрок, враг, предмет). Ничего не делает, если она и так не свободна.
+    void occupy(int x, int y)
+    {
+        const int32_t* slot = slotAt(x, y);
+        if (!slot || *slot < 0) {
+            return;
+        }
+        removeAt(*slot);
+    }
+
+    // Случайная свободная клетка; она сразу помечается занятой.
+    // Возвращает false, если свободных клеток не осталось.
+    bool take(Rng& rng, Position& out)
+    {
+        if (cells.empty()) {
+            return false;
+        }
+        const int32_t slot = static_cast<int32_t>(rng.below(static_cast<int>(cells.size())));
+        out = cells[static_cast<size_t>(slot)];
+        removeAt(slot);
+        return true;
+    }
+
+    int size() const { return static_cast<int>(cells.size()); }
+
+private:
+    int width = 0;
+    int height = 0;
+    int chunksX = 0;
+    std::vector<Position> cells; // Свободные клетки (порядок не важен)
+    // Индекс клетки в cells или -1: по таблице CHUNK_SIZE x CHUNK_SIZE на кусок с полом, пустая — у остальных
+    std::vector<std::vector<int32_t>> chunkSlots;
+    std::vector<uint8_t> chunkUsed; // Буфер build: в каких кусках есть пол
+
+    size_t chunkIndex(int x, int y) const
+    {
+        return static_cast<size_t>(y >> Map::CHUNK_SHIFT) * static_cast<size_t>(chunksX) +
+               static_cast<size_t>(x >> Map::CHUNK_SHIFT);
+    }
+
+    // Место клетки в таблице своего куска; nullptr — клетка вне карты или в куске без пола.
+    int32_t* slotAt(int x, int y)
+    {
+        if (x < 0 || y < 0 || x >= width || y >= height) {
+            return nullptr;
+        }
+        std::vector<int32_t>& table = chunkSlots[chunkIndex(x, y)];
+        if (table.empty()) {
+            return nullptr;
+        }
+        return &table[static_cast<size_t>(y & Map::CHUNK_MASK) * Map::CHUNK_SIZE + static_cast<size_t>(x & Map::CHUNK_MASK)];
+    }
+
+    void removeAt(int32_t slot)
+    {
+        const Position removed = cells[static_cast<size_t>(slot)];
+        const Position last = cells.back();
+        cells[static_cast<size_t>(slot)] = last;
+        *slotAt(last.x, last.y) = slot;
+        *slotAt(removed.x, removed.y) = -1;
+        cells.pop_back();
+    }
+};
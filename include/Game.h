@@ -1,9 +1,36 @@
 ﻿#pragma once
 
+#include "ByteStream.h"
 #include "Map.h"
 #include "Entity.h"
+#include "EnemyStore.h"
+#include "Random.h"
+#include "FreeCellIndex.h"
+#include "FlowField.h"
+#include "OccupancyGrid.h"
+#include "PerkEffect.h"
+#include "SlotMap.h"
+#include <cstdint>
+#include <future>
+#include <memory>
 #include <vector>
 
+struct Replay;
+
+// Время этапов последнего хода (step) в микросекундах.
+// Заполняется каждым ходом (пара замеров часов на этап), читается профайлером кадра.
+struct TurnTimings {
+    double move = 0.0;      // Шаг игрока и удар по мобу на пути (и переход на новый этаж)
+    double combat = 0.0;    // processCombat, оба вызова
+    double items = 0.0;     // processItems и проверка квеста
+    double enemies = 0.0;   // updateEnemies
+    double fireflies = 0.0; // Светлячки: полёт, столкновения, раскрытие тумана
+    double effects = 0.0;   // Яд, призрак, краб
+    double fov = 0.0;       // updateFOV или revealAll в конце хода
+
+    double total() const { return move + combat + items + enemies + fireflies + effects + fov; }
+};
+
 // Все поля GameState объявлены ниже, включая shieldTurns, visionTurns, questActive и т.д.
 
 // Главное состояние игры.
@@ -11,7 +38,7 @@
 struct GameState {
     Map map;
     Entity player;
-    std::vector<Entity> enemies; // Враги (крысы, медведи, змеи)
+    EnemyStore enemies; // Враги по колонкам, сгруппированы по типам (см. EnemyStore)
     bool isRunning;
     int torchRadius; // Радиус факела для FOV
     int level;       // Текущий уровень (начинается с 1)
@@ -58,7 +85,7 @@ struct GameState {
         int x, y;
         Firefly(int x_, int y_) : x(x_), y(y_) {}
     };
-    std::vector<Firefly> fireflies; // Вектор позиций светлячков
+    SlotMap<Firefly> fireflies; // Светлячки (удаление за O(1), порядок не сохраняется)
 
     // Постоянный эффект: на каждом уровне первые несколько шагов показываем лестницу.
     bool perkShowExitFirst3Steps = false;
@@ -130,18 +157,101 @@ struct GameState {
     int itemsTrap = 0;
     int itemsQuest = 0;
     
-    // Список собранных перков (для отображения на экране смерти)
-    std::vector<std::string> collectedPerks;
+    // Список собранных перков (для отображения на экране смерти): эффекты по порядку, названия — perkEffectName
+    std::vector<PerkEffect> collectedPerks;
 
     // Флаг для экрана смерти
     bool isDeathScreenActive = false;
 
-    GameState(); // Конструктор задает стартовые значения.
+    // --- Случайные числа ---
+    // Вместо глобального std::rand() у каждой подсистемы свой поток,
+    // чтобы, например, лишний бросок в бою не менял следующую карту.
+    uint64_t seed = 0; // Сид текущей сессии (по нему можно воспроизвести игру)
+    Rng rngMap;        // Генерация карты (Map::generate)
+    Rng rngSpawn;      // Спавн мобов и предметов, квесты, варианты перков
+    Rng rngAi;         // Движение мобов и светлячков
+    Rng rngCombat;     // Бой, отбрасывание и длительности эффектов
+
+    // --- Фоновая генерация следующего этажа ---
+    // Как только игрок дошёл до лестницы, следующая карта строится в отдельном потоке,
+    // пока открыт экран выбора перка. При переходе карты просто меняются местами,
+    // а перки влияют только на спавн, который выполняется уже после обмена.
+    std::unique_ptr<Map> pendingMap; // Второй буфер карты (строится в фоне)
+    Rng pendingMapRng;               // Копия rngMap, которой пользуется фоновая генерация
+    int pendingMapLevel = 0;         // Для какого уровня строится pendingMap (0 — ни для какого)
+    std::future<void> pendingMapTask;
+    // Строить ли следующий этаж в фоне. У копий для поиска ходов выключено: поток на каждый выход
+    // в откате дороже самой генерации, а синхронная генерация из той же rngMap даёт ту же карту.
+    bool pregenerateNextLevel = true;
+
+    // Свободные клетки пола текущего уровня. Заполняется в generateNewLevel,
+    // спавн мобов и предметов берёт клетки отсюда (см. FreeCellIndex).
+    FreeCellIndex freeCells;
+
+    // Кто из врагов на какой клетке (индексы в enemies). Обновляется при спавне, движении и смерти,
+    // поэтому врагов двигаем только через moveEnemy, при удалении правим onEnemyMoved,
+    // а после спавна (add может переставлять мобов) зовём rebuildEnemyGrid.
+    OccupancyGrid enemyGrid;
+
+    // Поля расстояний до игрока для updateEnemies: по кресту (крысы, медведи, крабы) и по диагонали (змеи).
+    // Считаются в окне FLOW_RADIUS вокруг игрока не чаще раза за ход.
+    static const int FLOW_RADIUS = 48;
+    FlowField groundFlow;
+    FlowField snakeFlow;
+
+    std::vector<FovLight> fovLights; // Буфер источников света для updateFOV (не выделяем каждый кадр)
+
+    // Тайминги этапов последнего хода (см. TurnTimings)
+    TurnTimings lastTurnTimings;
+
+    // Сколько раз строился этаж (generateNewLevel): по нему запись ставит ключевой кадр на каждом этаже.
+    uint64_t levelSerial = 0;
+
+    // Куда step пишет принятые действия (см. Replay::startRecording); nullptr — сессия не пишется.
+    Replay* recording = nullptr;
+
+    GameState(); // Конструктор задает стартовые значения (сид берётся из текущего времени).
+    // То же самое, но с заданным сидом и размером мира (по умолчанию — размер экрана карты).
+    explicit GameState(uint64_t seed, int mapWidth = Map::DEFAULT_WIDTH, int mapHeight = Map::DEFAULT_HEIGHT);
+    ~GameState(); // Дожидается фоновой генерации, если она ещё идёт.
+    // Копия для поиска ходов (SearchPlayer): копируется всё, что пишет снимок, — карта (клетки общие
+    // до первой записи), игрок, мобы, эффекты, квест, перки, статистика и потоки Rng, — поэтому копия
+    // играет дальше ход в ход как оригинал. Не копируются запись (recording), фоновая генерация
+    // (следующий этаж копия построит сама, карта выйдет та же) и кеши с буферами (поля расстояний,
+    // свободные клетки, тайминги). У копии из конструктора pregenerateNextLevel выключен,
+    // присваивание его не трогает и переиспользует память приёмника — повторные копии почти не выделяют память.
+    GameState(const GameState& other);
+    GameState& operator=(const GameState& other);
+    void reseed(uint64_t newSeed); // Пересеять все потоки случайных чисел
+    // Отпечаток всего, что влияет на дальнейшую игру: карта, игрок, мобы, эффекты, перки, статистика
+    // и положение потоков Rng. Одинаковые сид и действия дают одинаковый отпечаток (проверка записей).
+    uint64_t stateHash() const;
+    // Снимок того же состояния для ключевых кадров записи (Replay). Пишется только вне экрана выбора перка,
+    // пока нет фоновой генерации; читается в GameState с тем же размером мира.
+    // Сетка мобов, поля расстояний и видимость после чтения строятся заново.
+    // false — снимок испорчен (в том числе игрок, моб, светлячок, предмет или выход вне карты).
+    void writeSnapshot(ByteWriter& out) const;
+    bool readSnapshot(ByteReader& in);
     void updateEnemies(); // Обновление позиций врагов
+    // Индекс первого (в порядке enemies) живого врага на клетке (x, y) или -1.
+    int enemyAt(int x, int y) const;
+    // Переставить врага index на (x, y) вместе с его клеткой в enemyGrid.
+    void moveEnemy(size_t index, int x, int y);
+    // Моб переехал из строки from в строку to (EnemyStore::remove) — переставить его в enemyGrid.
+    void onEnemyMoved(size_t from, size_t to);
+    void rebuildEnemyGrid(); // enemyGrid заново по текущим enemies
     void processCombat(); // Обработка боя
     void processItems(); // Обработка предметов
     void generateQuest(); // Генерация нового квеста (убийство или сбор)
     void generateNewLevel(); // Генерация нового уровня
+    // Обновить FOV игрока (и светлячков). Если ничего не сдвинулось, работы нет — можно звать каждый кадр.
+    void updateFOV(bool withFireflies = true);
+    // Запустить фоновую генерацию карты для уровня level + 1.
+    void startNextLevelPregeneration();
+    // Готова ли уже карта, которую строит фоновая генерация.
+    bool isNextLevelReady() const;
+    // Дождаться фоновой генерации (без опроса в цикле: поток ждёт future и не отнимает ядро у генерации).
+    void waitNextLevel();
     bool checkExit(); // Проверка перехода на следующий уровень
     // Применить выбранный перк (1, 2 или 3) и перейти на следующий уровень.
     void applyLevelChoice(int choiceIndex);
@@ -166,6 +276,32 @@ struct GameState {
     int applyShieldHit(int damage);
 };
 
-// Обработка ввода и простейшая логика перемещения игрока.
-// key - обычный int (символ или код клавиши)
-void handleInput(GameState& state, int key);
+// Что игрок делает за один вызов step. Клавиши в действия переводит игровой цикл (actionFromKey),
+// поэтому симуляция не знает ни про клавиатуру, ни про libtcod: её могут крутить боты и бенчмарки.
+enum class Action : uint8_t {
+    Wait,        // Ход на месте (с крабом на игроке — снять краба)
+    MoveUp,
+    MoveDown,
+    MoveLeft,
+    MoveRight,
+    MoveUpLeft,
+    MoveUpRight,
+    MoveDownLeft,
+    MoveDownRight,
+    Quit,        // Выход из игры (isRunning = false)
+    ChoosePerk1, // Экран выбора перка: варианты 1/2/3
+    ChoosePerk2,
+    ChoosePerk3,
+    Restart      // Экран смерти: новая игра
+};
+
+// Восемь ходов в сторону (для ботов и бенчмарков): как WASD, затем диагонали QEZC.
+constexpr Action MOVE_ACTIONS[8] = {Action::MoveUp,     Action::MoveLeft,    Action::MoveDown,     Action::MoveRight,
+                                    Action::MoveUpLeft, Action::MoveUpRight, Action::MoveDownLeft, Action::MoveDownRight};
+
+// Один шаг симуляции. На экране смерти понимает только Restart, на экране перков — ChoosePerkN,
+// в обычной игре — ходы, Wait и Quit (ChoosePerkN и Restart там ничего не делают).
+// Перед действием обновляет FOV так же, как кадр игрового цикла, поэтому без окна игра идёт так же, как в окне.
+// Принятые действия пишутся в state.recording. Возвращает true, если сыгран ход игрока
+// (тогда его этапы — в lastTurnTimings).
+bool step(GameState& state, Action action);
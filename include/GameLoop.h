@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Game.h"
+#include "Graphics.h"
+
+// Раскладка экрана: карта в центре (80x36), панели вокруг.
+// <<< Можешь менять ширину боковых панелей и высоту нижней панели вот здесь >>>
+namespace ScreenLayout {
+constexpr int leftPanelWidth = 15;   // ширина левого UI-слоя
+constexpr int rightPanelWidth = 15;  // ширина правого UI-слоя
+constexpr int topPanelHeight = 1;    // верхняя панель (HP‑линия)
+constexpr int bottomPanelHeight = 6; // нижняя панель (управление + Floor + центр)
+constexpr int screenWidth = leftPanelWidth + Map::DEFAULT_WIDTH + rightPanelWidth;
+constexpr int screenHeight = topPanelHeight + Map::DEFAULT_HEIGHT + bottomPanelHeight;
+} // namespace ScreenLayout
+
+// Куда пишется трасса (Trace.h) по F9 и при выходе из игры; есть только в сборке с ASC11_ENABLE_TRACE.
+constexpr const char* TRACE_FILE = "asc11_trace.json";
+
+// Куда main пишет запись сессии (Replay.h) при выходе; проигрывает её ASC11_bench_replay.
+constexpr const char* REPLAY_FILE = "asc11_replay.bin";
+
+// Graphics с раскладкой ScreenLayout поверх backend (окно SDL или HeadlessBackend).
+std::unique_ptr<Graphics> makeGameGraphics(std::unique_ptr<RenderBackend> backend);
+
+// Клавиша из RenderBackend::getInput (символ или TCODK_*) -> действие для step с учётом экрана:
+// на экране смерти F/ESC — Restart, на экране перков 1/2/3 — ChoosePerkN, в игре WASD/QEZC и стрелки —
+// ходы (с крабом на игроке стрелки — Wait: стряхнуть краба), ESC — Quit, остальное — Wait.
+// F3/F9/F11 обрабатывает сам runFrame.
+Action actionFromKey(const GameState& game, int key);
+
+// Игровой цикл разбит на кадры, чтобы его одинаково крутили main (окно),
+// бенчмарки и автоматическая игра (HeadlessBackend со сценарием ввода).
+// Перед первым кадром: начальный FOV.
+void beginGame(GameState& game);
+// Один кадр: отрисовка экрана и не больше одной клавиши из graphics.getInput.
+// Время этапов кадра и хода пишется в graphics.profiler (F3 показывает оверлей),
+// F9 сбрасывает трассу в TRACE_FILE.
+void runFrame(GameState& game, Graphics& graphics);
@@ -11,26 +11,61 @@
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
+#include "Color.h"
+#include "FrameProfiler.h"
+#include "Lighting.h"
+#include "PerkEffect.h"
+#include "RenderBackend.h"
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 // Вперед объявляем классы, чтобы не тянуть сюда все заголовки.
 class Map;
 class Entity;
+class EnemyStore;
 struct Item;
 
+// Цвет симуляции (RgbColor) в цвет libtcod для вывода.
+inline tcod::ColorRGB toTcodColor(const RgbColor& color)
+{
+    return tcod::ColorRGB{color.r, color.g, color.b};
+}
+
+// Счётчики последнего кадра: сколько клеток консоли реально переписано, по слоям.
+// Сбрасываются в beginFrame, заполняются draw* и refreshScreen.
+struct RenderStats {
+    int mapCells = 0;     // Карта (пол, стены, свет факела)
+    int spriteCells = 0;  // Игрок, мобы, предметы, выход, подписи при наведении
+    int uiCells = 0;      // Панели интерфейса
+    int overlayCells = 0; // Экран выбора перка и экран смерти
+    bool mapFullRedraw = false; // Карта перерисована целиком, а не только круги света
+    bool uiRedrawn = false;     // Панели перерисованы (что-то в них поменялось)
+
+    int total() const { return mapCells + spriteCells + uiCells + overlayCells; }
+};
+
 // Класс для работы с выводом через libtcod.
-// Использует TCOD_Context для окна и TCOD_Console для отрисовки.
+// Рисует в TCOD_Console; окно, ввод и время — у RenderBackend (SDL или без окна).
 class Graphics {
 private:
-    std::shared_ptr<TCOD_Context> context;
+    std::unique_ptr<RenderBackend> backend;
     tcod::Console console;
     int screenWidth;
     int screenHeight;
-    // Размеры UI‑слоёв, которые приходят из main.cpp.
+    // Размеры UI‑слоёв, которые приходят из ScreenLayout (GameLoop.h).
     int leftPanelWidth;
     int rightPanelWidth;
     int topPanelHeight;
     int bottomPanelHeight;
+    // Окно карты на экране (между панелями) и его левый верхний угол в координатах мира.
+    // Камера пересчитывается в drawMap, остальные draw* рисуют относительно неё.
+    int viewWidth;
+    int viewHeight;
+    int cameraX;
+    int cameraY;
     
     // Цвета для разных объектов
     tcod::ColorRGB colorPlayer;
@@ -44,19 +79,113 @@ private:
     // Для эффекта факела
     TCODNoise torchNoise;
     float torchX;
+    uint32_t lastTicks; // backend->ticks() прошлого кадра
+    float pulseTime;    // Время пульсации факела, секунды
+    FrameLighting lighting; // Буфер света окна на кадр и таблицы затухания
+    // Строка окна при отрисовке карты (переиспользуются между строками и кадрами)
+    ColorPlanes rowBase;   // Тёмные цвета стен/пола
+    ColorPlanes rowLight;  // Светлые цвета стен/пола
+    ColorPlanes rowColor;  // Результат смешивания
+    std::vector<float> rowLevels;
+    std::vector<TCOD_ConsoleTile> rowTiles;
+
+    // --- Отрисовка только изменившихся клеток (dirtyRendering) ---
+    // Консоль не очищается между кадрами. Экран поделён на слои:
+    //  * карта — окно карты (без строк, которые перекрывает нижняя панель);
+    //  * панели — всё остальное, перерисовываются целиком, только если поменялись их данные;
+    //  * спрайты — символы поверх карты и панелей (мобы, предметы, игрок, подписи),
+    //    собираются за кадр и выводятся в refreshScreen: старые клетки восстанавливаются из baseTiles;
+    //  * оверлеи — экран перка и экран смерти, закрывают окно карты целиком.
+    // Карта перерисовывается целиком, только если сменился MapLayerKey; иначе мерцание факела
+    // и светлячков перерисовывает лишь квадраты вокруг источников света.
+    // В консоль пишутся только клетки, которые действительно отличаются.
+    struct MapLayerKey {
+        const Map* map = nullptr;
+        uint64_t visibilityVersion = 0;
+        uint64_t mutationCount = 0;
+        int cameraX = 0, cameraY = 0;
+        int playerX = 0, playerY = 0;
+        int torchRadius = 0;
+        bool showExitHint = false;
+        std::vector<std::pair<int, int>> fireflies;
+
+        bool operator==(const MapLayerKey& other) const;
+    };
+
+    // Что рисует drawMap в этом кадре (свет — в lighting).
+    struct MapFrame {
+        const Map* map;
+        bool showExitHint;
+    };
+
+    struct SpriteCell {
+        int x, y;
+        int ch;
+        tcod::ColorRGB fg;
+        tcod::ColorRGB bg;
+        bool hasBg; // Подписи закрашивают фон, символы мобов и предметов — нет
+    };
+
+    bool dirtyRendering;
+    std::vector<TCOD_ConsoleTile> baseTiles; // Карта и панели без спрайтов, по клетке экрана
+    MapLayerKey mapLayerKey;
+    bool mapLayerValid;
+    uint64_t uiSignature;
+    bool uiLayerValid;
+    uint64_t overlaySignature;
+    bool overlayInView; // Окно карты сейчас закрыто оверлеем
+    std::vector<SpriteCell> sprites;       // Спрайты текущего кадра (в порядке рисования)
+    std::vector<int> prevSpriteCells;      // Клетки экрана, занятые спрайтами в прошлом кадре
+    std::vector<int> frameSpriteCells;     // То же для текущего кадра (собирается в flushSprites)
+    std::vector<TCOD_ConsoleTile> spriteTiles; // Итоговые клетки спрайтов (индекс — клетка экрана)
+    std::vector<uint8_t> spriteMarks;      // 1 — в клетке есть спрайт этого кадра, 2 — уже выведен
+
+    void updateCamera(const Map& map, int playerX, int playerY);
+    bool isInView(int mapX, int mapY) const; // Клетка мира попадает в окно карты
+    int mapScreenRows() const;               // Сколько строк окна карты не закрыто нижней панелью
+    bool isInMapLayer(int screenX, int screenY) const;
+    // Клетки строки карты mapY от mapX0 (count штук) — в rowTiles
+    void shadeMapRow(const MapFrame& frame, int mapX0, int mapY, int count);
+    // Перерисовать клетки окна карты [viewX0, viewX1) x [viewY0, viewY1)
+    void drawMapRect(const MapFrame& frame, int viewX0, int viewY0, int viewX1, int viewY1);
+    void writeTile(int screenX, int screenY, const TCOD_ConsoleTile& tile, int& counter);
+    void pushSprite(int screenX, int screenY, int ch, const tcod::ColorRGB& fg);
+    void flushSprites();
+    void invalidateLayers();
+    // Общая часть оверлеев: true — оверлей с той же подписью уже на экране, рисовать не нужно
+    bool beginOverlay(uint64_t signature);
+    void endOverlay(uint64_t signature);
+    // Текст поверх всего (подписи, профайлер): в режиме dirtyRendering — спрайтами с фоном
+    void putText(int screenX, int screenY, const std::string& text, const tcod::ColorRGB& fg, const tcod::ColorRGB& bg);
+
+    bool profilerVisible;
+    RenderStats lastFrameStats; // renderStats прошлого, уже законченного кадра (для профайлера)
 
 public:
     // width/height — полный размер экрана.
     // Остальные параметры задают толщину UI‑панелей (те же значения,
-    // которые используются в main.cpp при расчёте screenWidth/screenHeight).
+    // которые используются в ScreenLayout при расчёте screenWidth/screenHeight).
+    // backend — куда выводить кадры (SdlBackend для окна, HeadlessBackend без него).
     Graphics(int width,
              int height,
              int leftPanelWidth,
              int rightPanelWidth,
              int topPanelHeight,
-             int bottomPanelHeight);
+             int bottomPanelHeight,
+             std::unique_ptr<RenderBackend> backend);
     ~Graphics();
 
+    // Режим отрисовки: true — только изменившиеся клетки (по умолчанию), false — весь экран каждый кадр.
+    void setDirtyRendering(bool enabled);
+    bool isDirtyRendering() const { return dirtyRendering; }
+    RenderStats renderStats; // Счётчики последнего кадра
+    // Время этапов кадра и хода; заполняет игровой цикл (runFrame), показывает drawProfilerOverlay.
+    FrameProfiler profiler;
+    // Ядро смешивания цветов карты; по умолчанию лучшее, что умеет процессор (detectBlendKernel).
+    BlendKernel blendKernel;
+
+    // Начало кадра: сбрасывает счётчики; в режиме полного кадра ещё и очищает консоль.
+    void beginFrame();
     void drawMap(const Map& map, int playerX, int playerY, int torchRadius, bool showExitHint, const std::vector<std::pair<int, int>>& fireflyPositions = {});
     void drawEntity(const Entity& entity);
     // Специальный метод для игрока с динамическим цветом.
@@ -64,7 +193,7 @@ public:
     void drawPlayer(const Entity& player, bool isPoisoned, bool hasShield);
     void drawItem(const Item& item);
     void drawUI(const Entity& player,
-                const std::vector<Entity>& enemies,
+                const EnemyStore& enemies,
                 int level,
                 const Map& map,
                 bool isPlayerPoisoned,
@@ -91,12 +220,12 @@ public:
                 bool seenTrap,
                 bool seenQuest);
     void refreshScreen();
-    void clearScreen();
+    void clearScreen(); // Полная очистка: все слои будут перерисованы
     // Читает одну клавишу. Возвращает true если что-то нажали.
     // В key кладем либо символ ('w','a','s','d','q'), либо код стрелки (TCODK_UP и т.п.)
     bool getInput(int& key);
     // Получает позицию мыши на карте. Возвращает true если мышь над игровой областью.
-    // mapX, mapY - координаты на карте (0..WIDTH-1, 0..HEIGHT-1)
+    // mapX, mapY - координаты на карте (с учётом камеры)
     bool getMousePosition(int& mapX, int& mapY);
     // Рисует название справа от символа при наведении мыши
     void drawHoverName(int mapX, int mapY, const std::string& name, const tcod::ColorRGB& color);
@@ -106,7 +235,11 @@ public:
     void drawDeathScreen(int level,
                          int killsRat, int killsBear, int killsSnake, int killsGhost, int killsCrab,
                          int itemsMedkit, int itemsMaxHP, int itemsShield, int itemsTrap, int itemsQuest,
-                         const std::vector<std::string>& collectedPerks);
+                         const std::vector<PerkEffect>& collectedPerks);
     // Переключение полноэкранного режима
     void toggleFullscreen();
+    // Оверлей профайлера (F3): среднее и максимум по этапам кадра и хода в правом верхнем углу карты
+    void toggleProfilerOverlay() { profilerVisible = !profilerVisible; }
+    bool isProfilerOverlayVisible() const { return profilerVisible; }
+    void drawProfilerOverlay();
 };
@@ -0,0 +1,109 @@
+#pragma once
+
+#ifndef TCOD_NO_CONSOLE
+#define TCOD_NO_CONSOLE 1
+#endif
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 26439) // подавляем анализатор для внешнего libtcod
+#endif
+#include <libtcod.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+#include <cstdint>
+#include <vector>
+
+// Освещение окна карты на один кадр (факел игрока и светлячки).
+// Клетки освещаются по целому квадрату расстояния до источника d2 = dx*dx + dy*dy:
+// затухание 1 - sqrt(d2) / radius считается один раз на радиус (таблица по d2),
+// а шум и пульсация источника — один раз на кадр (яркость intensity).
+//
+// Каждый источник сразу «впечатывается» в буфер окна, и только в свой квадрат радиуса,
+// поэтому цена кадра — сумма площадей источников, а не (клетки окна) x (источники).
+// Несколько lerp к одному цвету подряд равны одному lerp с уровнем 1 - П(1 - l_i),
+// поэтому в буфере копится произведение (1 - l_i), и порядок источников не важен.
+// Рисование и SDL здесь не нужны, поэтому модуль можно гонять в бенчмарках без окна.
+class FrameLighting {
+public:
+    // Новый кадр: буфер на прямоугольник карты (originX, originY, width x height), света нет.
+    void begin(int originX, int originY, int width, int height);
+    // Источник света радиуса radius. Уровень в клетке: min(1, затухание * intensity).
+    // Части квадрата вне буфера отбрасываются.
+    void addLight(int x, int y, int radius, float intensity);
+
+    // Суммарный уровень света в клетке карты (x, y): 0 — темно (и вне буфера), 1 — полный свет.
+    float level(int x, int y) const
+    {
+        const int bx = x - originX;
+        const int by = y - originY;
+        if (bx < 0 || by < 0 || bx >= width || by >= height) {
+            return 0.0f;
+        }
+        return 1.0f - darkness[static_cast<size_t>(by) * width + bx];
+    }
+
+    // Уровни света строки y карты для клеток x0 .. x0 + count - 1 (вне буфера — 0).
+    void levelRow(int y, int x0, int count, float* out) const;
+
+    // Цвет видимой клетки (x, y): base, подкрашенный в сторону light на level(x, y).
+    tcod::ColorRGB shade(int x, int y, const tcod::ColorRGB& base, const tcod::ColorRGB& light) const
+    {
+        const float l = level(x, y);
+        if (l <= 0.0f) {
+            return base;
+        }
+        return tcod::ColorRGB{TCODColor::lerp(base, light, l)};
+    }
+
+    // Затухание для радиуса radius по d2 (0 <= d2 < radius * radius); строится при первом обращении.
+    const std::vector<float>& falloff(int radius);
+
+    // Сколько клеток буфера обновили источники с начала кадра (для бенчмарков).
+    long long splatCells() const { return splattedCells; }
+
+private:
+    int originX = 0;
+    int originY = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<float> darkness; // На клетку: П(1 - уровень источника), 1 — света нет
+    std::vector<float> levels;   // Уровни текущего источника по d2 (временный буфер addLight)
+    std::vector<std::vector<float>> falloffTables; // Индекс — радиус
+    long long splattedCells = 0;
+};
+
+// --- Смешивание цветов строкой ---
+// Цвета строки окна лежат тремя плоскостями r/g/b (SoA), чтобы смешивать их векторами
+// сразу по 16 клеток. Результат совпадает с TCODColor::lerp до бита:
+// канал = (uint8_t)(base + (light - base) * level), вычисления во float, дробь отбрасывается.
+
+struct ColorPlanes {
+    std::vector<uint8_t> r, g, b;
+
+    void resize(size_t count)
+    {
+        r.resize(count);
+        g.resize(count);
+        b.resize(count);
+    }
+    void set(size_t i, const tcod::ColorRGB& color)
+    {
+        r[i] = color.r;
+        g[i] = color.g;
+        b[i] = color.b;
+    }
+    tcod::ColorRGB get(size_t i) const { return tcod::ColorRGB{r[i], g[i], b[i]}; }
+};
+
+// Реализация blendRow. Порядок важен: каждая следующая требует больше от процессора.
+enum class BlendKernel { Scalar, Sse2, Avx2 };
+
+// Лучшее ядро, которое поддерживает процессор (проверяется при запуске, не при сборке).
+BlendKernel detectBlendKernel();
+const char* blendKernelName(BlendKernel kernel);
+
+// out[i] = lerp(base[i], light[i], level[i]) для i из [0, count).
+// Ядро, которое процессор не поддерживает, заменяется лучшим доступным.
+void blendRow(BlendKernel kernel, const ColorPlanes& base, const ColorPlanes& light, const float* level,
+              ColorPlanes& out, int count);
@@ -1,18 +1,14 @@
 #pragma once
 
-#ifndef TCOD_NO_CONSOLE
-#define TCOD_NO_CONSOLE 1
-#endif
-#ifdef _MSC_VER
-#pragma warning(push)
-#pragma warning(disable : 26439) // подавляем анализатор для внешнего libtcod
-#endif
-#include <libtcod.hpp>
-#ifdef _MSC_VER
-#pragma warning(pop)
-#endif
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
 #include <vector>
+#include "ByteStream.h"
 #include "Entity.h"
+#include "Random.h"
+#include "SlotMap.h"
 
 // Структура для предмета на карте.
 struct Item {
@@ -25,33 +21,184 @@ struct Item {
         : pos(x, y), healAmount(heal), maxHealthBoost(boost), symbol(sym) {}
 };
 
+// Стабильная ссылка на предмет карты: переживает удаление других предметов (см. SlotMap).
+using ItemHandle = SlotHandle;
+
+// Время этапов последнего вызова Map::generate() в микросекундах.
+// Заполняется при каждой генерации (пара замеров часов на этап),
+// читается бенчмарком генерации уровней.
+struct MapGenTimings {
+    double rooms = 0.0;       // Большие и маленькие комнаты
+    double obstacles = 0.0;   // Преграды и разруха внутри комнат
+    double corridors = 0.0;   // Коридоры и дополнительные связи между комнатами
+    double brokenAreas = 0.0; // Разбитые участки ("внешняя среда")
+    double fovSync = 0.0;     // Сброс FOV и стены по краям
+    double placement = 0.0;   // Предметы и выход
+
+    double total() const { return rooms + obstacles + corridors + brokenAreas + fovSync + placement; }
+};
+
+// Дополнительный источник света для FOV (светлячок и т.п.).
+struct FovLight {
+    int x, y;
+    int radius;
+
+    bool operator==(const FovLight& other) const { return x == other.x && y == other.y && radius == other.radius; }
+};
+
+// Счётчики работы FOV (для профилирования): сколько раз поле зрения реально считалось
+// и сколько раз updateFOV обошёлся кешем.
+struct FovStats {
+    uint64_t computes = 0;  // Полных пересчётов в updateFOV
+    uint64_t cacheHits = 0; // Вызовов updateFOV без работы
+};
+
 class Map {
 public:
-    // Сделаем размеры карты доступны снаружи,
-    // чтобы их могли использовать другие части кода.
-    // Размеры карты 16:9, чтобы мир и интерфейс занимали весь экран без черных полос.
+    // Размер карты по умолчанию. Он же — размер окна карты на экране:
+    // 16:9, чтобы мир и интерфейс занимали весь экран без черных полос.
     // 80x36 -> вместе с 9 строками HUD получаем консоль 80x45, тоже 16:9.
-    static const int WIDTH = 80;
-    static const int HEIGHT = 36;
+    // Сама карта может быть любого размера (см. конструктор), на экране видна её часть.
+    static const int DEFAULT_WIDTH = 80;
+    static const int DEFAULT_HEIGHT = 36;
+
+    // Карта хранится кусками CHUNK_SIZE x CHUNK_SIZE клеток.
+    // Кусок выделяется только когда в него пишут что-то кроме "сплошной скалы"
+    // (стена, не видно, не исследовано), поэтому память зависит от занятой площади,
+    // а не от размера карты.
+    static const int CHUNK_SHIFT = 6;
+    static const int CHUNK_SIZE = 1 << CHUNK_SHIFT; // 64
+    static const int CHUNK_MASK = CHUNK_SIZE - 1;
 
 private:
-    char cells[HEIGHT][WIDTH];
-    bool explored[HEIGHT][WIDTH]; // Какие клетки уже были видны
-    bool visible[HEIGHT][WIDTH];  // Какие клетки видны сейчас (для FOV)
-    TCODMap fovMap; // Карта для расчета поля зрения
+    // Клетки куска. Блок клеток общий у карты и её копий (копия для поиска ходов): запись клетки
+    // сначала даёт куску собственный блок (copy-on-write, см. putCell), поэтому копия карты клетки не копирует.
+    // Новый кусок ссылается на общий блок сплошной скалы — кусок, который FOV выделил под скалой, клеток не держит.
+    struct CellBlock {
+        char rows[CHUNK_SIZE][CHUNK_SIZE];
+    };
+
+    // Видимость и исследованность — битовые строки: одно 64-битное слово на строку куска,
+    // бит x — клетка x. Очистка, подсветка и объединение идут словами, а не по клетке.
+    // Исследованность "досчитывается" лениво: клетка исследована, если бит стоит
+    // в explored или в visible, а visible сливается в explored при очистке видимости.
+    // Биты у каждой копии карты свои (меняются каждый ход).
+    struct Chunk {
+        std::shared_ptr<CellBlock> cells;
+        uint64_t explored[CHUNK_SIZE]; // Какие клетки уже были видны (без текущих visible)
+        uint64_t visible[CHUNK_SIZE];  // Какие клетки видны сейчас (для FOV)
+        Chunk();
+        char cell(int localX, int localY) const { return cells->rows[localY][localX]; }
+    };
+
+    int width;
+    int height;
+    int chunksX; // Сколько кусков по горизонтали
+    int chunksY; // Сколько кусков по вертикали
+    std::vector<std::unique_ptr<Chunk>> chunks; // nullptr — кусок ещё не выделен (сплошная стена)
+
+    // Прямоугольник, вне которого нет видимых клеток.
+    // Нужен, чтобы очищать видимость только там, где она была, а не по всей карте.
+    bool hasVisible;
+    int visibleMinX, visibleMinY, visibleMaxX, visibleMaxY;
+
+    // Строка октанта для shadowcasting: глубина и границы видимого сектора
+    // в виде точных дробей num/den (den > 0), чтобы не было ошибок округления.
+    struct ShadowRow {
+        int depth;
+        int startNum, startDen;
+        int endNum, endDen;
+    };
+    std::vector<ShadowRow> shadowRows; // Стек строк (вместо рекурсии), не выделяем каждый вызов
+
+    // Изменения клеток и предметов (setCell/addItem/removeItem/generate).
+    uint64_t mutationCount;
+    // Изменения видимости (computeFOV/addFOV/revealAll/revealCircle/generate/swap).
+    uint64_t visibilityVersion;
+
+    // Кеш updateFOV: с какими параметрами посчитана текущая видимость.
+    // Любое прямое изменение видимости (computeFOV, addFOV, revealAll, revealCircle) сбрасывает кеш.
+    bool fovCacheValid;
+    int fovCacheX, fovCacheY, fovCacheRadius;
+    bool fovCacheLightWalls;
+    uint64_t fovCacheMutation;
+    std::vector<FovLight> fovCacheLights;
+
+    // Какой предмет лежит на клетке: номер клетки (y * width + x) -> ссылка в items.
+    // Предметов на этаже десятки-сотни, поэтому хеш-таблица, а не массив на всю (кусковую) карту.
+    // Ведут её только addItem/removeItem/generate/swap; ссылки стабильны, так что перенос
+    // предметов внутри items при удалении таблицу не трогает.
+    std::unordered_map<uint64_t, ItemHandle> itemCells;
+    uint64_t cellKey(int x, int y) const
+    {
+        return static_cast<uint64_t>(y) * static_cast<uint64_t>(width) + static_cast<uint64_t>(x);
+    }
+
+    Chunk* chunkAt(int x, int y) const;  // Кусок с клеткой (x, y) или nullptr (координаты в границах)
+    Chunk& ensureChunk(int x, int y);    // Кусок с клеткой (x, y), при необходимости выделяем
+    void putCell(int x, int y, char symbol); // Запись клетки без проверки границ
+    void markVisibleSpan(int y, int x0, int x1); // Клетки [x0, x1] строки y видимы (в границах)
+    void includeInVisibleArea(int minX, int minY, int maxX, int maxY);
+    void clearVisible();
+    void addFOVShadowcast(int sourceX, int sourceY, int radius, bool lightWalls);
+
+    // Один сектор генератора (см. generate), возвращает центр его первой комнаты
+    Position generateSector(int originX, int originY, int sectorW, int sectorH, Rng& rng,
+                            std::chrono::steady_clock::time_point& stageStart);
 
 public:
-    Map();
+    explicit Map(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
     ~Map();
+    // Копия карты (поиск ходов копирует GameState тысячами): клетки кусков общие до первой записи,
+    // копируются биты видимости, предметы, выход и кеш FOV. Присваивание переиспользует куски и буферы приёмника.
+    Map(const Map& other);
+    Map& operator=(const Map& other);
 
-    void generate(int currentLevel = 1); // Уровень для контроля спавна предметов на первом уровне
+    // Обменяться содержимым с другой картой (двойная буферизация уровней).
+    // Меняются только указатели на куски, клетки не копируются.
+    void swap(Map& other);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getAllocatedChunkCount() const; // Сколько кусков реально выделено (для бенчмарков)
+    // Память одного выделенного куска: клетки и битовые строки видимости (кусок под скалой делит блок клеток).
+    static size_t chunkBytes() { return sizeof(Chunk) + sizeof(CellBlock); }
+    // Отпечаток содержимого: клетки выделенных кусков, предметы и выход (видимость не входит).
+    uint64_t contentHash() const;
+
+    // Снимок карты для ключевых кадров записи (Replay): клетки и исследованность непустых кусков
+    // (сжатые сериями), предметы в порядке items и выход. Видимость не пишется: после чтения
+    // её пересчитывает ближайший updateFOV (кеш FOV сброшен). Читать можно только в карту того же размера.
+    // false — снимок испорчен: другой размер, предмет вне карты или с чужим символом, выход вне карты.
+    void writeSnapshot(ByteWriter& out) const;
+    bool readSnapshot(ByteReader& in);
+
+    // Уровень нужен для контроля спавна предметов на первом уровне.
+    // Все случайные числа берутся из rng, поэтому одинаковый сид даёт одинаковую карту.
+    void generate(int currentLevel, Rng& rng);
     char getCell(int x, int y) const;
     void setCell(int x, int y, char symbol);
     bool isWall(int x, int y) const;
     bool isWalkable(int x, int y) const;
     bool inBounds(int x, int y) const; // Проверка границ карты
+    // Все клетки пола (SYM_FLOOR) в out; обходит только выделенные куски.
+    void collectFloorCells(std::vector<Position>& out) const;
+
+    // Тайминги этапов последней генерации (см. MapGenTimings)
+    MapGenTimings lastGenTimings;
+
+    // Сколько раз менялись клетки/предметы карты. По нему кеши понимают, что карта стала другой.
+    uint64_t getMutationCount() const { return mutationCount; }
+    // Сколько раз менялась видимость. Пока он тот же, isVisible/isExplored отвечают так же (для отрисовки).
+    uint64_t getVisibilityVersion() const { return visibilityVersion; }
+
+    // Видимость от игрока (playerX, playerY, radius) плюс дополнительные источники света.
+    // Если с прошлого вызова не изменились ни позиции и радиусы, ни карта, ничего не считает.
+    // Возвращает true, если FOV действительно пересчитан.
+    bool updateFOV(int playerX, int playerY, int radius, const std::vector<FovLight>& lights, bool lightWalls = true);
+    FovStats fovStats;
 
-    // FOV функции с использованием TCODMap
+    // FOV функции: круг радиуса radius вокруг источника (радиус <= 0 — без ограничения)
     void computeFOV(int playerX, int playerY, int radius, bool lightWalls = true);
     // Добавляет FOV от дополнительного источника света (не перезаписывает существующий FOV)
     void addFOV(int sourceX, int sourceY, int radius, bool lightWalls = true);
@@ -61,16 +208,19 @@ public:
     // Отмечаем клетки внутри круга как "исследованные" (но не обязательно видимые).
     void revealCircle(int cx, int cy, int radius);
 
-    // Предметы на карте
-    std::vector<Item> items;
-    void addItem(int x, int y, int healAmount, int maxHealthBoost, char symbol);
+    // Предметы на карте (плотный массив, удаление за O(1) — порядок предметов не сохраняется).
+    // Менять состав только через addItem/removeItem: они же ведут индекс клеток для getItemAt.
+    // На клетке лежит не больше одного предмета: addItem на занятую клетку заменяет старый.
+    SlotMap<Item> items;
+    ItemHandle addItem(int x, int y, int healAmount, int maxHealthBoost, char symbol);
     void addHealItem(int x, int y, int healAmount);
     void addMaxHealthItem(int x, int y, int maxHealthBoost);
     void addTrapItem(int x, int y);  // Ловушка (мина) '.'
     void addShieldItem(int x, int y); // Щит "O"
     void addQuestItem(int x, int y);  // Квестовый предмет '?'
-    Item* getItemAt(int x, int y);
-    void removeItem(int index);
+    // Предмет на клетке (x, y) или недействительная ссылка, O(1); сам предмет — items.get(handle).
+    ItemHandle getItemAt(int x, int y) const;
+    void removeItem(ItemHandle handle); // Устаревшую ссылку молча пропускает
     
     // Выход на следующий уровень
     Position exitPos;
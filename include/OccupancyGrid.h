@@ -0,0 +1,229 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Map.h"
+
+// Кто стоит на клетке: индексы сущностей (например, мобов GameState::enemies) по клеткам карты.
+// Мобы не обходят друг друга, а краб сидит прямо на игроке, поэтому в одной клетке
+// может оказаться несколько сущностей: в клетке хранится начало цепочки, у сущности — следующая
+// в той же клетке. Цепочка упорядочена по индексу, так что обход клетки идёт в том же порядке,
+// что и перебор вектора. Вопрос "кто на (x, y)?" стоит O(сущностей в клетке), а не O(всех).
+// Мёртвые сущности сетка не отличает — это проверяет вызывающий.
+// Начала цепочек лежат по кускам карты (Map::CHUNK_SIZE): таблица куска заводится, когда в него встаёт
+// первая сущность, поэтому память и сброс зависят от площади, где есть сущности, а не от размера мира.
+class OccupancyGrid {
+public:
+    static constexpr int32_t NONE = -1;
+
+    // Пустая сетка под карту width x height. Таблицы кусков освобождаются.
+    void reset(int width_, int height_)
+    {
+        width = width_;
+        height = height_;
+        chunksX = (width + Map::CHUNK_MASK) >> Map::CHUNK_SHIFT;
+        const int chunksY = (height + Map::CHUNK_MASK) >> Map::CHUNK_SHIFT;
+        chunkHeads.resize(static_cast<size_t>(chunksX) * static_cast<size_t>(chunksY));
+        for (std::vector<int32_t>& table : chunkHeads) {
+            std::vector<int32_t>().swap(table);
+        }
+        next.clear();
+        cellOf.clear();
+    }
+
+    // Сетка заново по позициям (xs[i], ys[i]) (индекс в сетке — индекс в массивах).
+    void rebuild(int width_, int height_, const std::vector<int>& xs, const std::vector<int>& ys)
+    {
+        reset(width_, height_);
+        next.assign(xs.size(), NONE);
+        cellOf.assign(xs.size(), NONE);
+        // С конца: каждая сущность встаёт в начало цепочки, и цепочки сразу выходят по возрастанию
+        for (size_t i = xs.size(); i > 0; --i) {
+            const int32_t index = static_cast<int32_t>(i - 1);
+            const int32_t cell = cellIndex(xs[i - 1], ys[i - 1]);
+            if (cell != NONE) {
+                int32_t& head = headOf(cell);
+                next[static_cast<size_t>(index)] = head;
+                head = index;
+                cellOf[static_cast<size_t>(index)] = cell;
+            }
+        }
+    }
+
+    // Стать копией other. Если размер тот же, переписываются только занятые клетки обеих сеток —
+    // O(сущностей), а не O(клеток карты): так копии GameState для поиска ходов не гоняют всю сетку.
+    // Таблицы кусков приёмника остаются (пустые клетки в них — NONE) и переиспользуются следующими копиями.
+    void assign(const OccupancyGrid& other)
+    {
+        if (width != other.width || height != other.height) {
+            *this = other;
+            return;
+        }
+        for (int32_t cell : cellOf) {
+            if (cell != NONE) {
+                headOf(cell) = NONE;
+            }
+        }
+        for (int32_t cell : other.cellOf) {
+            if (cell != NONE) {
+                headOf(cell) = other.chunkHeads[chunkOf(cell)][localOf(cell)];
+            }
+        }
+        next = other.next;
+        cellOf = other.cellOf;
+    }
+
+    // Поставить сущность index на (x, y); если она уже стоит на другой клетке — переставить.
+    // Клетки вне карты допустимы: такая сущность просто не находится запросами.
+    void place(int32_t index, int x, int y)
+    {
+        if (static_cast<size_t>(index) >= cellOf.size()) {
+            next.resize(static_cast<size_t>(index) + 1, NONE);
+            cellOf.resize(static_cast<size_t>(index) + 1, NONE);
+        }
+        const int32_t cell = cellIndex(x, y);
+        if (cell == cellOf[static_cast<size_t>(index)]) {
+            return;
+        }
+        unlink(index);
+        link(index, cell);
+    }
+
+    // Убрать сущность index из сетки.
+    void remove(int32_t index)
+    {
+        if (static_cast<size_t>(index) < cellOf.size()) {
+            unlink(index);
+        }
+    }
+
+    // Первая (с наименьшим индексом) сущность на клетке и следующая за index в той же клетке; NONE — больше нет.
+    int32_t first(int x, int y) const
+    {
+        const int32_t cell = cellIndex(x, y);
+        if (cell == NONE) {
+            return NONE;
+        }
+        const std::vector<int32_t>& table = chunkHeads[chunkOf(cell)];
+        return table.empty() ? NONE : table[localOf(cell)];
+    }
+    int32_t following(int32_t index) const { return next[static_cast<size_t>(index)]; }
+
+    // Первая сущность на клетке, для которой pred(index) == true, или NONE.
+    template <typename Pred>
+    int32_t findAt(int x, int y, Pred pred) const
+    {
+        for (int32_t index = first(x, y); index != NONE; index = following(index)) {
+            if (pred(index)) {
+                return index;
+            }
+        }
+        return NONE;
+    }
+
+    // fn(index) для каждой сущности на клетке (x, y), по возрастанию индекса.
+    template <typename Fn>
+    void forEachAt(int x, int y, Fn fn) const
+    {
+        for (int32_t index = first(x, y); index != NONE; index = following(index)) {
+            fn(index);
+        }
+    }
+
+    // Соседи по кресту: вправо, влево, вниз, вверх. Сама клетка (x, y) не входит.
+    template <typename Fn>
+    void forEachAdjacent4(int x, int y, Fn fn) const
+    {
+        static const int dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        for (const auto& dir : dirs) {
+            forEachAt(x + dir[0], y + dir[1], fn);
+        }
+    }
+
+    // Все 8 соседей (крест, затем диагонали). Сама клетка (x, y) не входит.
+    template <typename Fn>
+    void forEachAdjacent8(int x, int y, Fn fn) const
+    {
+        static const int diagonals[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+        forEachAdjacent4(x, y, fn);
+        for (const auto& dir : diagonals) {
+            forEachAt(x + dir[0], y + dir[1], fn);
+        }
+    }
+
+    // Клетки круга dx*dx + dy*dy <= radius*radius, построчно сверху вниз (включая саму (x, y)).
+    template <typename Fn>
+    void forEachInRadius(int x, int y, int radius, Fn fn) const
+    {
+        const int squaredRadius = radius * radius;
+        for (int dy = -radius; dy <= radius; ++dy) {
+            for (int dx = -radius; dx <= radius; ++dx) {
+                if (dx * dx + dy * dy <= squaredRadius) {
+                    forEachAt(x + dx, y + dy, fn);
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr int CHUNK_CELLS = Map::CHUNK_SIZE * Map::CHUNK_SIZE;
+
+    int width = 0;
+    int height = 0;
+    int chunksX = 0;
+    // Первая сущность клетки или NONE: по таблице CHUNK_CELLS на кусок, где побывали сущности, пустая — у остальных
+    std::vector<std::vector<int32_t>> chunkHeads;
+    std::vector<int32_t> next;   // Следующая сущность в той же клетке, по одной на сущность
+    std::vector<int32_t> cellOf; // Клетка сущности или NONE (вне сетки)
+
+    // Номер клетки: кусок * CHUNK_CELLS + место в куске, так таблица куска находится без деления.
+    int32_t cellIndex(int x, int y) const
+    {
+        if (x < 0 || y < 0 || x >= width || y >= height) {
+            return NONE;
+        }
+        const int chunk = (y >> Map::CHUNK_SHIFT) * chunksX + (x >> Map::CHUNK_SHIFT);
+        return chunk * CHUNK_CELLS + ((y & Map::CHUNK_MASK) << Map::CHUNK_SHIFT) + (x & Map::CHUNK_MASK);
+    }
+    static size_t chunkOf(int32_t cell) { return static_cast<size_t>(cell) / CHUNK_CELLS; }
+    static size_t localOf(int32_t cell) { return static_cast<size_t>(cell) % CHUNK_CELLS; }
+
+    // Начало цепочки клетки; таблица куска заводится при первом обращении.
+    int32_t& headOf(int32_t cell)
+    {
+        std::vector<int32_t>& table = chunkHeads[chunkOf(cell)];
+        if (table.empty()) {
+            table.assign(CHUNK_CELLS, NONE);
+        }
+        return table[localOf(cell)];
+    }
+
+    // Вставка в цепочку клетки с сохранением порядка по индексу (цепочки короткие).
+    void link(int32_t index, int32_t cell)
+    {
+        cellOf[static_cast<size_t>(index)] = cell;
+        if (cell == NONE) {
+            return;
+        }
+        int32_t* slot = &headOf(cell);
+        while (*slot != NONE && *slot < index) {
+            slot = &next[static_cast<size_t>(*slot)];
+        }
+        next[static_cast<size_t>(index)] = *slot;
+        *slot = index;
+    }
+
+    void unlink(int32_t index)
+    {
+        const int32_t cell = cellOf[static_cast<size_t>(index)];
+        if (cell != NONE) {
+            int32_t* slot = &headOf(cell);
+            while (*slot != index) {
+                slot = &next[static_cast<size_t>(*slot)];
+            }
+            *slot = next[static_cast<size_t>(index)];
+        }
+        next[static_cast<size_t>(index)] = NONE;
+        cellOf[static_cast<size_t>(index)] = NONE;
+    }
+};
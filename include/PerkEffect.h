@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// Эффект выбранного перка — строка в списке перков экрана смерти (GameState::collectedPerks).
+// Один перк даёт несколько эффектов (applyLevelChoice). В состоянии игры хранится номер,
+// а не строка: копия состояния для поиска ходов не тянет за собой строки.
+enum class PerkEffect : uint8_t {
+    MoreRats,
+    MoreMedkits,
+    Firefly,
+    PoisonBears,
+    MoreShields,
+    ExitHint,
+    QuestHighlight,
+    MoreSnakes,
+    MoreMaxHpItems,
+    SmallerTorch
+};
+constexpr int PERK_EFFECT_COUNT = 10;
+
+const char* perkEffectName(PerkEffect effect); // "+5 rats", "Firefly reveals fog", ...
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+
+// Небольшой быстрый генератор случайных чисел (PCG32).
+// В отличие от std::rand() у него нет глобального состояния: каждый экземпляр независим,
+// поэтому две карты можно генерировать в разных потоках, а одинаковый сид
+// всегда даёт одинаковую последовательность (воспроизводимые уровни).
+class Rng {
+public:
+    Rng() { seed(0, 0); }
+    Rng(uint64_t seedValue, uint64_t stream) { seed(seedValue, stream); }
+
+    // stream выбирает одну из независимых последовательностей при том же сиде.
+    void seed(uint64_t seedValue, uint64_t stream)
+    {
+        state = 0;
+        increment = (stream << 1u) | 1u;
+        next();
+        state += seedValue;
+        next();
+    }
+
+    // Следующее 32-битное случайное число.
+    uint32_t next()
+    {
+        const uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        const uint32_t xorShifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        const uint32_t rotation = static_cast<uint32_t>(old >> 59u);
+        return (xorShifted >> rotation) | (xorShifted << ((32u - rotation) & 31u));
+    }
+
+    // Равномерное число в [0, bound) без перекоса "std::rand() % n" (метод Лемира).
+    // Для bound <= 0 возвращает 0.
+    int below(int bound)
+    {
+        if (bound <= 0) {
+            return 0;
+        }
+        const uint32_t range = static_cast<uint32_t>(bound);
+        uint64_t product = static_cast<uint64_t>(next()) * range;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < range) {
+            const uint32_t threshold = (0u - range) % range;
+            while (low < threshold) {
+                product = static_cast<uint64_t>(next()) * range;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<int>(product >> 32);
+    }
+
+    // Равномерное число в [min, max] включительно.
+    int range(int min, int max)
+    {
+        if (max < min) {
+            return min;
+        }
+        return min + below(max - min + 1);
+    }
+
+    // Положение в последовательности и номер потока (для отпечатка и снимков состояния игры).
+    uint64_t getState() const { return state; }
+    uint64_t getIncrement() const { return increment; }
+    // Вернуть генератор в положение, снятое getState/getIncrement.
+    void restore(uint64_t state_, uint64_t increment_)
+    {
+        state = state_;
+        increment = increment_;
+    }
+
+    bool operator==(const Rng& other) const { return state == other.state && increment == other.increment; }
+    bool operator!=(const Rng& other) const { return !(*this == other); }
+
+private:
+    uint64_t state;
+    uint64_t increment;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef TCOD_NO_CONSOLE
+#define TCOD_NO_CONSOLE 1
+#endif
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 26439) // подавляем анализатор для внешнего libtcod
+#endif
+#include <libtcod.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+
+// Куда Graphics выводит готовый кадр и откуда берёт клавиши, мышь и время.
+// Graphics рисует в свою tcod::Console и ничего не знает об окне:
+//  * SdlBackend — окно SDL2 через TCOD_Context (обычная игра);
+//  * HeadlessBackend — без окна: кадры остаются в памяти (и по желанию пишутся в файл),
+//    ввод идёт из сценария, время — по кадрам. Для бенчмарков, CI и автоматической игры.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    // Вызывается один раз из конструктора Graphics с консолью, в которую тот рисует.
+    virtual void open(tcod::Console& console) = 0;
+    // Показать готовый кадр.
+    virtual void present(tcod::Console& console) = 0;
+    // Одна клавиша без ожидания: символ ('w', '1', ...) или код TCODK_*. false — ничего не нажато.
+    virtual bool pollKey(int& key) = 0;
+    // Клетка консоли под мышью. false — положение мыши неизвестно.
+    virtual bool mouseTile(int& consoleX, int& consoleY) = 0;
+    // Миллисекунды от произвольной точки отсчёта (пульсация факела).
+    virtual uint32_t ticks() = 0;
+    virtual void toggleFullscreen() {}
+};
+
+// Окно SDL2. Открывается на весь экран (SDL_WINDOW_FULLSCREEN_DESKTOP), F11 переключает режим.
+class SdlBackend : public RenderBackend {
+public:
+    explicit SdlBackend(std::string windowTitle);
+
+    void open(tcod::Console& console) override;
+    void present(tcod::Console& console) override;
+    bool pollKey(int& key) override;
+    bool mouseTile(int& consoleX, int& consoleY) override;
+    uint32_t ticks() override;
+    void toggleFullscreen() override;
+
+private:
+    std::string title;
+    std::shared_ptr<TCOD_Context> context;
+};
+
+// Без окна и без SDL-событий. Время идёт только в present: msPerFrame на кадр,
+// поэтому анимация факела одинакова при любой скорости прогона.
+class HeadlessBackend : public RenderBackend {
+public:
+    explicit HeadlessBackend(uint32_t msPerFrame = 16);
+
+    void open(tcod::Console& console) override;
+    void present(tcod::Console& console) override;
+    bool pollKey(int& key) override;
+    bool mouseTile(int& consoleX, int& consoleY) override;
+    uint32_t ticks() override { return now; }
+
+    // --- Сценарий ввода ---
+    // Клавиша выдаётся после idleFrames опросов без нажатия (то есть через idleFrames кадров).
+    void pushKey(int key, int idleFrames = 0);
+    // Каждый символ строки — клавиша, между ними по idleFrames пустых кадров.
+    void pushKeys(const std::string& keys, int idleFrames = 0);
+    bool scriptDone() const { return script.empty(); }
+    // Мышь над клеткой консоли (x, y); clearMouse — мыши нет (как вне окна).
+    void setMouseTile(int x, int y);
+    void clearMouse();
+
+    // --- Кадры ---
+    // Каждый every-й показанный кадр дописывается текстом в path: строка "frame N",
+    // затем строки консоли (печатные ASCII как есть, остальные символы — '#').
+    // false — файл не открылся.
+    bool dumpFrames(const std::string& path, int every = 1);
+    // Консоль последнего показанного кадра (та же, в которую рисует Graphics).
+    const tcod::Console* lastFrame() const { return console; }
+    uint64_t framesPresented() const { return frames; }
+    // FNV-1a по символам и цветам последнего кадра — для сравнения прогонов.
+    uint64_t frameHash() const;
+
+private:
+    struct ScriptedKey {
+        int key;
+        int idleFrames;
+    };
+
+    uint32_t msPerFrame;
+    uint32_t now;
+    uint64_t frames;
+    const tcod::Console* console;
+    std::deque<ScriptedKey> script;
+    bool mouseKnown;
+    int mouseX, mouseY;
+    std::ofstream dump;
+    int dumpEvery;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Game.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Запись сессии для воспроизведения: сид и размер мира, с которыми создан GameState, и все действия,
+// которые принял step (ходы, выбор перка, новая игра после смерти), по порядку.
+// Вся случайность игры идёт из потоков Rng от сида, поэтому те же действия с тем же сидом
+// дают ту же игру до бита — это проверяет finalHash (GameState::stateHash в конце записи).
+//
+// Чтобы не проигрывать длинную сессию с начала ради хода 50000, запись держит ключевые кадры —
+// снимки GameState (GameState::writeSnapshot) на каждом новом этаже и не реже чем раз в keyframeInterval
+// действий. seek восстанавливает ближайший кадр и доигрывает от него не больше keyframeInterval действий.
+//
+// Файл (little-endian): "A11R", версия u32, seed u64, ширина u32, высота u32,
+// число действий u32, действия по байту, finalHash u64, затем (с версии 2) число кадров u32
+// и кадры: номер действия u32, этаж i32, размер снимка u32, снимок.
+struct Replay {
+    static constexpr uint32_t VERSION = 2;
+    // Самая большая сторона мира, которую принимает loadReplay: ширина и высота идут прямо в конструктор
+    // GameState, и испорченный файл иначе заказал бы карту на миллиарды клеток.
+    static constexpr uint32_t MAX_MAP_SIDE = 4096;
+
+    // Состояние игры перед действием actions[actionIndex].
+    struct Keyframe {
+        uint32_t actionIndex;
+        int level;
+        std::vector<uint8_t> snapshot;
+    };
+
+    uint64_t seed = 0;
+    int mapWidth = Map::DEFAULT_WIDTH;
+    int mapHeight = Map::DEFAULT_HEIGHT;
+    std::vector<Action> actions;
+    uint64_t finalHash = 0;
+
+    std::vector<Keyframe> keyframes; // По возрастанию actionIndex
+    uint32_t keyframeInterval = 250; // Не больше стольких действий между кадрами (0 — только на новых этажах)
+
+    // Начать запись сессии state, только что созданной конструктором: сид и размер мира — из неё,
+    // дальше step дописывает действия (и ключевые кадры) сюда.
+    void startRecording(GameState& state);
+    // Дописать принятое действие (зовёт step перед тем, как его выполнить).
+    void record(const GameState& state, Action action);
+    // Закончить запись: отпечаток итогового состояния в finalHash, state больше не пишет.
+    void stopRecording(GameState& state);
+
+    // Новая игра в начале записанной сессии; на ней step(actions[i]) по порядку повторяет сессию.
+    std::unique_ptr<GameState> makeGame() const;
+    // Игра в состоянии перед действием actionIndex (actions.size() — конец записи):
+    // ближайший ключевой кадр не позже actionIndex, затем step до actionIndex. nullptr — кадр испорчен.
+    std::unique_ptr<GameState> seek(size_t actionIndex) const;
+
+private:
+    size_t lastKeyframeAction = 0;
+    uint64_t lastKeyframeLevel = 0; // GameState::levelSerial последнего кадра
+};
+
+// Записать/прочитать файл записи. false — не удалось открыть файл или он испорчен.
+bool saveReplay(const std::string& path, const Replay& replay);
+bool loadReplay(const std::string& path, Replay& replay);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "AutoPlayer.h"
+#include "Game.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Бот с поиском ходов (MCTS): там, где AutoPlayer решает по одному правилу, этот проигрывает варианты вперёд.
+// Пока рядом нет мобов, ходит как AutoPlayer (guide) — исследовать этаж перебором незачем.
+// Когда моб ближе SEARCH_RADIUS, строит дерево по ходам игрока (ожидание и 8 шагов):
+//  * каждая итерация копирует корневое состояние в рабочую GameState (присваивание — без выделений памяти,
+//    клетки карты общие до первой записи) и проходит путь по дереву через step;
+//  * лист выбирается по UCB1, из него — откат до rolloutDepth ходов: AutoPlayer с долей случайных шагов;
+//  * оценка отката: смерть — 0, переход на следующий этаж — 1, иначе доля здоровья (не больше 0.8).
+// Выбирается ход корня, который посещали чаще всех, — если он заметно лучше хода guide (оценка не видит
+// продвижения к лестнице, и без этого бот топчется возле безопасных мобов).
+// Поиск видит детерминированные потоки Rng копии, то есть "знает", куда пойдут мобы и попадёт ли удар:
+// для бота-исследователя баланса это приемлемо, как честный соперник — нет.
+class SearchPlayer {
+public:
+    static const int SEARCH_RADIUS = 6; // Чебышёвское расстояние до моба, с которого включается поиск
+
+    // iterations_ — итераций MCTS на решение, rolloutDepth_ — длина отката в ходах.
+    SearchPlayer(uint64_t seed, int iterations_, int rolloutDepth_, int perkChoice_ = AutoPlayer::PERK_RANDOM);
+
+    // Следующее действие для state (state не меняется).
+    Action next(const GameState& state);
+
+    int aimlessTurns() const { return guide.aimlessTurns(); }
+
+    // --- Счётчики для бенчмарков ---
+    uint64_t searches() const { return searchCount; } // Решений, принятых поиском
+    uint64_t clones() const { return cloneCount; }     // Копий состояния (по одной на итерацию)
+    uint64_t rollouts() const { return rolloutCount; }
+
+private:
+    // Вершина дерева. children — индексы в nodes по номерам ходов SEARCH_ACTIONS (SearchPlayer.cpp):
+    // NO_CHILD — ход ещё не пробовали, ILLEGAL — шаг в стену без моба (тот же ход на месте, что Wait).
+    struct Node {
+        static const int32_t NO_CHILD = -1;
+        static const int32_t ILLEGAL = -2;
+        int32_t children[9] = {NO_CHILD, NO_CHILD, NO_CHILD, NO_CHILD, NO_CHILD,
+                               NO_CHILD, NO_CHILD, NO_CHILD, NO_CHILD};
+        int tried = 0; // Сколько ходов уже пробовали (дети заводятся по порядку)
+        int visits = 0;
+        double valueSum = 0.0;
+    };
+
+    int iterations;
+    int rolloutDepth;
+    Rng rng;
+    AutoPlayer guide;      // Ходит вне боя и помнит исследованные клетки этажа
+    AutoPlayer rolloutBot; // Политика отката: перед каждым откатом копия guide
+    std::unique_ptr<GameState> scratch; // Рабочая копия корня: заводится при первом поиске, дальше переиспользуется
+    std::vector<Node> nodes;
+    std::vector<int32_t> path;
+
+    uint64_t searchCount = 0;
+    uint64_t cloneCount = 0;
+    uint64_t rolloutCount = 0;
+
+    bool enemyNear(const GameState& state) const;
+    // Доиграть scratch политикой отката и оценить (от 0 до 1).
+    double rollout();
+    double evaluate() const;
+    // Попробовать из вершины node следующий ещё не пробованный ход (scratch — состояние вершины).
+    // Возвращает нового ребёнка (scratch уже сделал ход) или -1, если пробовать больше нечего.
+    int32_t expand(int32_t node);
+    // Номер хода к ребёнку с лучшей оценкой UCB1 или -1, если законных ходов нет.
+    int selectAction(int32_t node) const;
+};
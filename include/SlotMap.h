@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Ссылка на элемент, которая переживает удаление других элементов: номер слота + поколение.
+// Когда элемент удаляют, поколение слота растёт, и все старые ссылки на него перестают находиться
+// (а не указывают молча на чужой элемент, как индекс или указатель в вектор после erase).
+struct SlotHandle {
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+    uint32_t index = NONE;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != NONE; }
+    bool operator==(const SlotHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// Таблица слотов: ссылка (SlotHandle) -> номер строки в плотном массиве.
+// Сам массив (или колонки) хранит владелец: при удалении он переносит последнюю строку на место
+// удалённой и сообщает об этом через relocate. Всё за O(1), свободные слоты переиспользуются.
+class SlotIndex {
+public:
+    static constexpr uint32_t NONE = SlotHandle::NONE;
+
+    // Новая ссылка на строку row.
+    SlotHandle acquire(uint32_t row)
+    {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = static_cast<uint32_t>(slots.size());
+            slots.push_back(Slot{NONE, 0});
+        }
+        slots[index].row = row;
+        return SlotHandle{index, slots[index].generation};
+    }
+
+    // Ссылка больше не действительна; слот уйдёт следующему acquire уже с новым поколением.
+    void release(SlotHandle handle)
+    {
+        if (!contains(handle)) {
+            return;
+        }
+        Slot& slot = slots[handle.index];
+        slot.row = NONE;
+        ++slot.generation;
+        freeSlots.push_back(handle.index);
+    }
+
+    // Строка, на которую указывает ссылка, переехала.
+    void relocate(SlotHandle handle, uint32_t row) { slots[handle.index].row = row; }
+
+    bool contains(SlotHandle handle) const
+    {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation &&
+               slots[handle.index].row != NONE;
+    }
+
+    // Номер строки или NONE, если ссылка устарела.
+    uint32_t row(SlotHandle handle) const { return contains(handle) ? slots[handle.index].row : NONE; }
+
+    // Освободить все слоты разом (все выданные ссылки устаревают).
+    void clear()
+    {
+        freeSlots.clear();
+        for (size_t i = slots.size(); i > 0; --i) {
+            Slot& slot = slots[i - 1];
+            if (slot.row != NONE) {
+                slot.row = NONE;
+                ++slot.generation;
+            }
+            freeSlots.push_back(static_cast<uint32_t>(i - 1));
+        }
+    }
+
+private:
+    struct Slot {
+        uint32_t row;        // Строка в плотном массиве или NONE (слот свободен)
+        uint32_t generation; // Растёт при каждом освобождении слота
+    };
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+};
+
+// Плотный массив элементов со стабильными ссылками (slot map).
+//  * insert и erase — O(1): удалённый элемент заменяется последним (порядок элементов не сохраняется);
+//  * перебор — по плотному массиву без дыр: for (T& value : map) или map[i], i < size();
+//  * ссылка (SlotHandle) остаётся действительной, пока её элемент не удалят, как бы ни двигались другие.
+// Индекс i в плотном массиве меняется при удалении других элементов — между ходами храните ссылку.
+template <typename T>
+class SlotMap {
+public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    SlotHandle insert(T value)
+    {
+        const SlotHandle handle = index.acquire(static_cast<uint32_t>(values.size()));
+        values.push_back(std::move(value));
+        handles.push_back(handle);
+        return handle;
+    }
+
+    // Удалить элемент по ссылке; false, если ссылка устарела.
+    bool erase(SlotHandle handle)
+    {
+        const uint32_t row = index.row(handle);
+        if (row == SlotIndex::NONE) {
+            return false;
+        }
+        eraseAt(row);
+        return true;
+    }
+
+    // Удалить i-й элемент плотного массива: на его место встаёт последний.
+    // При обходе с конца (i = size()-1 .. 0) так можно удалять прямо во время перебора.
+    void eraseAt(size_t i)
+    {
+        index.release(handles[i]);
+        const size_t last = values.size() - 1;
+        if (i != last) {
+            values[i] = std::move(values[last]);
+            handles[i] = handles[last];
+            index.relocate(handles[i], static_cast<uint32_t>(i));
+        }
+        values.pop_back();
+        handles.pop_back();
+    }
+
+    // Элемент по ссылке или nullptr, если его уже удалили.
+    T* get(SlotHandle handle)
+    {
+        const uint32_t row = index.row(handle);
+        return row == SlotIndex::NONE ? nullptr : &values[row];
+    }
+    const T* get(SlotHandle handle) const
+    {
+        const uint32_t row = index.row(handle);
+        return row == SlotIndex::NONE ? nullptr : &values[row];
+    }
+    bool contains(SlotHandle handle) const { return index.contains(handle); }
+
+    // Ссылка на i-й элемент плотного массива.
+    SlotHandle handleAt(size_t i) const { return handles[i]; }
+
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+    T& operator[](size_t i) { return values[i]; }
+    const T& operator[](size_t i) const { return values[i]; }
+    iterator begin() { return values.begin(); }
+    iterator end() { return values.end(); }
+    const_iterator begin() const { return values.begin(); }
+    const_iterator end() const { return values.end(); }
+
+    void clear()
+    {
+        values.clear();
+        handles.clear();
+        index.clear();
+    }
+
+    void swap(SlotMap& other)
+    {
+        values.swap(other.values);
+        handles.swap(other.handles);
+        std::swap(index, other.index);
+    }
+
+private:
+    std::vector<T> values;          // Плотный массив элементов
+    std::vector<SlotHandle> handles; // Ссылка на каждый элемент (для relocate при удалении)
+    SlotIndex index;
+};
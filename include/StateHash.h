@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// Отпечаток состояния (FNV-1a, 64 бита): одинаковая игра даёт одинаковое число.
+// Нужен, чтобы проверять воспроизведение записей, а не для защиты от подделки.
+class StateHash {
+public:
+    void addBytes(const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            value = (value ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+
+    // Числа и bool подмешиваются как 64-битное значение, чтобы результат не зависел от размера типа.
+    template <typename T>
+    void add(T number)
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "StateHash::add: только числа");
+        const uint64_t wide = static_cast<uint64_t>(number);
+        addBytes(&wide, sizeof(wide));
+    }
+
+    void add(const std::string& text)
+    {
+        add(text.size());
+        addBytes(text.data(), text.size());
+    }
+
+    uint64_t get() const { return value; }
+
+private:
+    uint64_t value = 14695981039346656037ULL;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+// Трассировка в формате Chrome trace (открывается в ui.perfetto.dev и chrome://tracing).
+// Собирается только с -DASC11_ENABLE_TRACE=ON: без него макросы ниже раскрываются в пустоту,
+// и в коде игры от трассировки не остаётся ни вызова, ни чтения часов.
+//
+//   ASC11_TRACE_SCOPE("name")            — событие от этой строки до конца области видимости;
+//   ASC11_TRACE_SPAN("name", start, end) — событие по готовым отметкам steady_clock
+//                                          (этапы, которые и так меряются для таймингов);
+//   ASC11_TRACE_FLUSH("file.json")       — записать накопленные события в файл.
+//
+// События пишутся в кольцевой буфер без блокировок (последние TRACE_CAPACITY штук),
+// из любого потока: фоновая генерация этажа попадает в трассу своей дорожкой.
+// name — строковый литерал: буфер хранит только указатель.
+
+#if defined(ASC11_ENABLE_TRACE)
+
+#include <chrono>
+
+namespace trace {
+using Clock = std::chrono::steady_clock;
+
+void record(const char* name, Clock::time_point start, Clock::time_point end);
+// true — файл записан. Буфер не очищается: повторный сброс пишет и старые события.
+bool flush(const char* path);
+
+class Scope {
+public:
+    explicit Scope(const char* name_) : name(name_), start(Clock::now()) {}
+    ~Scope() { record(name, start, Clock::now()); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name;
+    Clock::time_point start;
+};
+} // namespace trace
+
+#define ASC11_TRACE_CONCAT_INNER(a, b) a##b
+#define ASC11_TRACE_CONCAT(a, b) ASC11_TRACE_CONCAT_INNER(a, b)
+#define ASC11_TRACE_SCOPE(name) ::trace::Scope ASC11_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define ASC11_TRACE_SPAN(name, start, end) ::trace::record((name), (start), (end))
+#define ASC11_TRACE_FLUSH(path) ::trace::flush(path)
+
+#else
+
+#define ASC11_TRACE_SCOPE(name) ((void)0)
+#define ASC11_TRACE_SPAN(name, start, end) ((void)(name), (void)(start), (void)(end))
+#define ASC11_TRACE_FLUSH(path) ((void)(path))
+
+#endif
@@ -0,0 +1,233 @@
+#include "AutoPlayer.h"
+
+#include <algorithm>
+
+namespace {
+// Восемь соседей в порядке MOVE_ACTIONS: вверх, влево, вниз, вправо, затем диагонали.
+const int STEP_DIRS[8][2] = {{0, -1}, {-1, 0}, {0, 1}, {1, 0}, {-1, -1}, {1, -1}, {-1, 1}, {1, 1}};
+
+// Флаги AutoPlayer::cellFlags
+const uint8_t CELL_READ = 1;     // Клетка карты уже прочитана (flagsAt)
+const uint8_t CELL_EXPLORED = 2;
+const uint8_t CELL_PASSABLE = 4; // Пол без известной ловушки или лестница
+const uint8_t CELL_EXIT = 8;
+const uint8_t CELL_WANTED = 16;  // Предмет, за которым стоит сходить
+const uint8_t CELL_TRAP = 32;
+} // namespace
+
+AutoPlayer::AutoPlayer(uint64_t seed, int perkChoice_)
+    : rng(seed, 77), perkChoice(perkChoice_)
+{
+}
+
+void AutoPlayer::beginSearch(size_t cellCount)
+{
+    if (search.stamp.size() != cellCount) {
+        search.stamp.assign(cellCount, 0);
+        search.parent.resize(cellCount);
+        search.distance.resize(cellCount);
+        search.cellFlags.resize(cellCount);
+        search.generation = 0;
+    }
+    if (++search.generation == 0) {
+        // Счётчик обернулся: старые отметки могли бы совпасть с новыми
+        std::fill(search.stamp.begin(), search.stamp.end(), 0);
+        search.generation = 1;
+    }
+    search.queue.clear();
+}
+
+void AutoPlayer::touch(int32_t cell)
+{
+    const size_t index = static_cast<size_t>(cell);
+    if (search.stamp[index] != search.generation) {
+        search.stamp[index] = search.generation;
+        search.parent[index] = -1;
+        search.distance[index] = 0;
+        search.cellFlags[index] = 0;
+    }
+}
+
+void AutoPlayer::markItems(const GameState& state)
+{
+    const Map& map = state.map;
+    const bool hurt = state.player.health < state.player.maxHealth;
+    for (const Item& item : map.items) {
+        uint8_t mark = 0;
+        switch (item.symbol) {
+        case SYM_TRAP:
+            mark = CELL_TRAP;
+            break;
+        case SYM_ITEM:
+            mark = hurt ? CELL_WANTED : 0;
+            break;
+        case SYM_MAX_HP:
+        case SYM_SHIELD:
+        case SYM_QUEST:
+            mark = CELL_WANTED;
+            break;
+        default:
+            break;
+        }
+        const int32_t cell = item.pos.y * map.getWidth() + item.pos.x;
+        touch(cell);
+        search.cellFlags[static_cast<size_t>(cell)] = mark;
+    }
+}
+
+uint8_t AutoPlayer::flagsAt(const Map& map, int x, int y)
+{
+    const int32_t cell = y * map.getWidth() + x;
+    touch(cell);
+    uint8_t& flags = search.cellFlags[static_cast<size_t>(cell)];
+    if (flags & CELL_READ) {
+        return flags;
+    }
+    flags |= CELL_READ;
+    if (!map.isExplored(x, y)) {
+        flags &= static_cast<uint8_t>(~(CELL_WANTED | CELL_TRAP)); // Предмета в тумане бот не знает
+        return flags;
+    }
+    flags |= CELL_EXPLORED;
+    if (map.isExit(x, y)) {
+        flags |= CELL_PASSABLE | CELL_EXIT;
+    } else if (map.isWalkable(x, y) && !(flags & CELL_TRAP)) {
+        flags |= CELL_PASSABLE;
+    }
+    return flags;
+}
+
+bool AutoPlayer::touchesFog(const Map& map, int x, int y)
+{
+    for (const auto& dir : STEP_DIRS) {
+        const int nx = x + dir[0];
+        const int ny = y + dir[1];
+        if (map.inBounds(nx, ny) && !(flagsAt(map, nx, ny) & CELL_EXPLORED)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Action AutoPlayer::firstStepTo(const GameState& state, int32_t target) const
+{
+    const int width = state.map.getWidth();
+    const int32_t start = state.player.pos.y * width + state.player.pos.x;
+    int32_t cell = target;
+    while (search.parent[static_cast<size_t>(cell)] != start) {
+        cell = search.parent[static_cast<size_t>(cell)];
+    }
+    const int dx = cell % width - state.player.pos.x;
+    const int dy = cell / width - state.player.pos.y;
+    for (int d = 0; d < 8; ++d) {
+        if (STEP_DIRS[d][0] == dx && STEP_DIRS[d][1] == dy) {
+            return MOVE_ACTIONS[d];
+        }
+    }
+    return Action::Wait;
+}
+
+Action AutoPlayer::next(const GameState& state)
+{
+    if (state.isDeathScreenActive) {
+        return Action::Restart;
+    }
+    if (state.isPerkChoiceActive) {
+        const int choice = perkChoice >= 1 && perkChoice <= 3 ? perkChoice : 1 + rng.below(3);
+        return static_cast<Action>(static_cast<int>(Action::ChoosePerk1) + choice - 1);
+    }
+    // Краб на игроке: ход на месте снимает его (а шаги с инверсией бот бы путал)
+    if (state.isPlayerControlsInverted) {
+        return Action::Wait;
+    }
+
+    const int width = state.map.getWidth();
+    const int height = state.map.getHeight();
+    const size_t cellCount = static_cast<size_t>(width) * static_cast<size_t>(height);
+    const int px = state.player.pos.x;
+    const int py = state.player.pos.y;
+    const int32_t start = py * width + px;
+    const size_t visitedWords = (cellCount + 63) / 64;
+    if (visitedLevel != state.levelSerial || visited.size() != visitedWords) {
+        visited.assign(visitedWords, 0);
+        visitedLevel = state.levelSerial;
+    }
+    visited[static_cast<size_t>(start) >> 6] |= uint64_t{1} << (start & 63);
+
+    // Моб рядом — бьём
+    for (int d = 0; d < 8; ++d) {
+        if (state.enemyAt(px + STEP_DIRS[d][0], py + STEP_DIRS[d][1]) >= 0) {
+            aimless = 0;
+            return MOVE_ACTIONS[d];
+        }
+    }
+
+    // Поиск в ширину по исследованным клеткам: ближайшие предмет, лестница и край тумана.
+    // Как только найдена лестница (или туман, если лестницы бот ещё не видел), а предмет найден
+    // или уже дальше ITEM_DETOUR, выбор сделан.
+    const Map& map = state.map;
+    const bool exitKnown = map.isExplored(map.exitPos.x, map.exitPos.y);
+    beginSearch(cellCount);
+    markItems(state);
+    std::vector<int32_t>& parent = search.parent;
+    std::vector<int32_t>& distance = search.distance;
+    std::vector<int32_t>& queue = search.queue;
+    touch(start);
+    parent[static_cast<size_t>(start)] = start;
+    queue.push_back(start);
+
+    int32_t itemCell = -1;
+    int32_t exitCell = -1;
+    int32_t fogCell = -1;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const int32_t cell = queue[head];
+        const int x = cell % width;
+        const int y = cell / width;
+        const uint8_t flags = flagsAt(map, x, y);
+        if ((exitCell >= 0 || (!exitKnown && fogCell >= 0)) && (itemCell >= 0 || distance[static_cast<size_t>(cell)] > ITEM_DETOUR)) {
+            break;
+        }
+        if (cell != start) {
+            if (itemCell < 0 && (flags & CELL_WANTED)) {
+                itemCell = cell;
+            }
+            if (exitCell < 0 && (flags & CELL_EXIT)) {
+                exitCell = cell;
+            }
+            const bool wasVisited = (visited[static_cast<size_t>(cell) >> 6] >> (cell & 63)) & 1;
+            if (fogCell < 0 && !wasVisited && touchesFog(map, x, y)) {
+                fogCell = cell;
+            }
+        }
+        if (flags & CELL_EXIT) {
+            continue; // Через лестницу не ходим: шаг на неё — уже переход
+        }
+        for (const auto& dir : STEP_DIRS) {
+            const int nx = x + dir[0];
+            const int ny = y + dir[1];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) {
+                continue;
+            }
+            const int32_t nextCell = ny * width + nx;
+            touch(nextCell);
+            if (parent[static_cast<size_t>(nextCell)] >= 0 || !(flagsAt(map, nx, ny) & CELL_PASSABLE)) {
+                continue;
+            }
+            parent[static_cast<size_t>(nextCell)] = cell;
+            distance[static_cast<size_t>(nextCell)] = distance[static_cast<size_t>(cell)] + 1;
+            queue.push_back(nextCell);
+        }
+    }
+
+    // Предмет рядом, затем лестница, затем туман; когда идти больше некуда — предмет где угодно
+    int32_t target = itemCell;
+    if (itemCell < 0 || distance[static_cast<size_t>(itemCell)] > ITEM_DETOUR) {
+        target = exitCell >= 0 ? exitCell : fogCell >= 0 ? fogCell : itemCell;
+    }
+    if (target >= 0) {
+        aimless = 0;
+        return firstStepTo(state, target);
+    }
+    ++aimless;
+    return MOVE_ACTIONS[rng.below(8)];
+}
@@ -0,0 +1,112 @@
+#include "EnemyStore.h"
+
+int enemySymbol(EnemyType type)
+{
+    switch (type) {
+    case EnemyType::Bear:
+        return SYM_BEAR;
+    case EnemyType::Snake:
+        return SYM_SNAKE;
+    case EnemyType::Ghost:
+        return SYM_GHOST;
+    case EnemyType::Crab:
+        return SYM_CRAB;
+    case EnemyType::Rat:
+        break;
+    }
+    return SYM_ENEMY;
+}
+
+const char* enemyName(EnemyType type)
+{
+    switch (type) {
+    case EnemyType::Bear:
+        return "Bear";
+    case EnemyType::Snake:
+        return "Snake";
+    case EnemyType::Ghost:
+        return "Ghost";
+    case EnemyType::Crab:
+        return "Crab";
+    case EnemyType::Rat:
+        break;
+    }
+    return "Rat";
+}
+
+EnemyType EnemyStore::typeOf(size_t i) const
+{
+    int t = 0;
+    while (t < ENEMY_TYPE_COUNT - 1 && i >= groupEnds[static_cast<size_t>(t)]) {
+        ++t;
+    }
+    return static_cast<EnemyType>(t);
+}
+
+size_t EnemyStore::add(EnemyType type, int x_, int y_, int maxHealth_, int damage_, const RgbColor& color_)
+{
+    // Свободное место — новая строка в конце; сдвигаем его к концу группы type,
+    // перенося первого моба каждой следующей группы в её конец (с последней группы назад).
+    size_t hole = size();
+    resizeColumns(hole + 1);
+    for (size_t t = groupEnds.size() - 1; t > static_cast<size_t>(type); --t) {
+        const size_t first = groupEnds[t - 1];
+        moveRow(first, hole, [](size_t, size_t) {});
+        hole = first;
+        ++groupEnds[t];
+    }
+    x[hole] = x_;
+    y[hole] = y_;
+    health[hole] = maxHealth_;
+    maxHealth[hole] = maxHealth_;
+    damage[hole] = damage_;
+    color[hole] = color_;
+    crabAttached[hole] = 0;
+    crabCooldown[hole] = 0;
+    handles[hole] = index.acquire(static_cast<uint32_t>(hole));
+    ++groupEnds[static_cast<size_t>(type)];
+    return hole;
+}
+
+void EnemyStore::clear()
+{
+    resizeColumns(0);
+    groupEnds.fill(0);
+    index.clear();
+}
+
+Entity EnemyStore::entity(size_t i) const
+{
+    Entity view(x[i], y[i], symbol(i), color[i]);
+    view.health = health[i];
+    view.maxHealth = maxHealth[i];
+    view.damage = damage[i];
+    return view;
+}
+
+void EnemyStore::copyRow(size_t from, size_t to)
+{
+    x[to] = x[from];
+    y[to] = y[from];
+    health[to] = health[from];
+    maxHealth[to] = maxHealth[from];
+    damage[to] = damage[from];
+    color[to] = color[from];
+    crabAttached[to] = crabAttached[from];
+    crabCooldown[to] = crabCooldown[from];
+    handles[to] = handles[from];
+    index.relocate(handles[to], static_cast<uint32_t>(to));
+}
+
+void EnemyStore::resizeColumns(size_t count)
+{
+    x.resize(count);
+    y.resize(count);
+    health.resize(count);
+    maxHealth.resize(count);
+    damage.resize(count);
+    color.resize(count);
+    crabAttached.resize(count);
+    crabCooldown.resize(count);
+    handles.resize(count);
+}
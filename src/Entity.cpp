@@ -1,15 +1,13 @@
 #include "Entity.h"
 
 // Конструктор просто запоминает стартовые значения.
-Entity::Entity(int startX, int startY, int sym, const TCOD_ColorRGB& col)
+Entity::Entity(int startX, int startY, int sym, const RgbColor& col)
     : pos(startX, startY),
       symbol(sym),
       color(col),
       health(20),
       maxHealth(20),
-      damage(1),
-      crabAttachedToPlayer(false),
-      crabAttachmentCooldown(0)
+      damage(1)
 {
 }
 
@@ -0,0 +1,113 @@
+#include "FlowField.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+namespace {
+const int ORTHOGONAL_DIRS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+const int DIAGONAL_DIRS[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+using DirTable = int[4][2];
+
+const DirTable& dirsFor(FlowMoves moves)
+{
+    return moves == FlowMoves::Diagonal ? DIAGONAL_DIRS : ORTHOGONAL_DIRS;
+}
+} // namespace
+
+bool FlowField::build(const Map& map_, int targetX_, int targetY_, int radius_, FlowMoves moves_)
+{
+    if (valid && map == &map_ && mapMutation == map_.getMutationCount() &&
+        targetX == targetX_ && targetY == targetY_ && radius == radius_ && moves == moves_) {
+        return false;
+    }
+    ASC11_TRACE_SCOPE("FlowField::build");
+    valid = true;
+    map = &map_;
+    mapMutation = map_.getMutationCount();
+    targetX = targetX_;
+    targetY = targetY_;
+    radius = radius_;
+    moves = moves_;
+    ++buildCount;
+
+    // Окно radius вокруг цели, обрезанное по карте
+    originX = std::max(0, targetX - radius);
+    originY = std::max(0, targetY - radius);
+    width = std::max(0, std::min(map_.getWidth(), targetX + radius + 1) - originX);
+    height = std::max(0, std::min(map_.getHeight(), targetY + radius + 1) - originY);
+    distances.assign(static_cast<size_t>(width) * static_cast<size_t>(height), UNREACHED);
+    queue.clear();
+
+    auto seed = [&](int x, int y, int32_t distance) {
+        const int wx = x - originX;
+        const int wy = y - originY;
+        if (wx < 0 || wy < 0 || wx >= width || wy >= height) {
+            return;
+        }
+        const int32_t index = wy * width + wx;
+        if (distances[static_cast<size_t>(index)] != UNREACHED) {
+            return;
+        }
+        distances[static_cast<size_t>(index)] = distance;
+        queue.push_back(index);
+    };
+
+    // Клетка цели — источник всегда (игрок стоит на полу или на выходе)
+    seed(targetX, targetY, 0);
+    if (moves == FlowMoves::Diagonal) {
+        for (const auto& dir : ORTHOGONAL_DIRS) {
+            if (map_.isWalkable(targetX + dir[0], targetY + dir[1])) {
+                seed(targetX + dir[0], targetY + dir[1], 1);
+            }
+        }
+    }
+
+    // Очередь растёт по ходу обхода; источники с расстоянием 1 стоят после цели, порядок BFS не ломается
+    const auto& dirs = dirsFor(moves);
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const int32_t index = queue[head];
+        const int x = originX + index % width;
+        const int y = originY + index / width;
+        const int32_t next = distances[static_cast<size_t>(index)] + 1;
+        for (const auto& dir : dirs) {
+            const int nx = x + dir[0];
+            const int ny = y + dir[1];
+            const int wx = nx - originX;
+            const int wy = ny - originY;
+            if (wx < 0 || wy < 0 || wx >= width || wy >= height) {
+                continue;
+            }
+            const size_t nIndex = static_cast<size_t>(wy) * static_cast<size_t>(width) + static_cast<size_t>(wx);
+            if (distances[nIndex] != UNREACHED || !map_.isWalkable(nx, ny)) {
+                continue;
+            }
+            distances[nIndex] = next;
+            queue.push_back(static_cast<int32_t>(nIndex));
+        }
+    }
+    return true;
+}
+
+bool FlowField::step(int x, int y, Rng& rng, int& dx, int& dy) const
+{
+    const int here = distance(x, y);
+    if (here <= 0) {
+        return false;
+    }
+    int candidates[4];
+    int count = 0;
+    const auto& dirs = dirsFor(moves);
+    for (int d = 0; d < 4; ++d) {
+        if (distance(x + dirs[d][0], y + dirs[d][1]) == here - 1) {
+            candidates[count++] = d;
+        }
+    }
+    if (count == 0) {
+        return false;
+    }
+    const int chosen = candidates[count > 1 ? rng.below(count) : 0];
+    dx = dirs[chosen][0];
+    dy = dirs[chosen][1];
+    return true;
+}
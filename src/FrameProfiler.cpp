@@ -0,0 +1,73 @@
+#include "FrameProfiler.h"
+
+#include <algorithm>
+
+void FrameProfiler::add(ProfileStage stage, double micros)
+{
+    current[static_cast<size_t>(stage)] += micros;
+}
+
+void FrameProfiler::commitFrame(double frameMicros, bool turnTaken)
+{
+    frames[static_cast<size_t>(frameNext)] = current;
+    frameTotals[static_cast<size_t>(frameNext)] = frameMicros;
+    frameNext = (frameNext + 1) % WINDOW;
+    frameCount = std::min(frameCount + 1, WINDOW);
+    if (turnTaken) {
+        turns[static_cast<size_t>(turnNext)] = current;
+        turnNext = (turnNext + 1) % WINDOW;
+        turnCount = std::min(turnCount + 1, WINDOW);
+    }
+    current.fill(0.0);
+}
+
+FrameProfiler::StageStats FrameProfiler::stats(ProfileStage stage) const
+{
+    const bool turnStage = isTurnStage(stage);
+    const std::array<Sample, WINDOW>& samples = turnStage ? turns : frames;
+    const int count = turnStage ? turnCount : frameCount;
+    StageStats result;
+    for (int i = 0; i < count; ++i) {
+        const double micros = samples[static_cast<size_t>(i)][static_cast<size_t>(stage)];
+        result.average += micros;
+        result.peak = std::max(result.peak, micros);
+    }
+    if (count > 0) {
+        result.average /= count;
+    }
+    return result;
+}
+
+FrameProfiler::StageStats FrameProfiler::frameStats() const
+{
+    StageStats result;
+    for (int i = 0; i < frameCount; ++i) {
+        result.average += frameTotals[static_cast<size_t>(i)];
+        result.peak = std::max(result.peak, frameTotals[static_cast<size_t>(i)]);
+    }
+    if (frameCount > 0) {
+        result.average /= frameCount;
+    }
+    return result;
+}
+
+const char* FrameProfiler::stageName(ProfileStage stage)
+{
+    switch (stage) {
+    case ProfileStage::Fov: return "FOV";
+    case ProfileStage::DrawMap: return "map";
+    case ProfileStage::DrawEntities: return "entities";
+    case ProfileStage::DrawUI: return "UI";
+    case ProfileStage::Hover: return "hover";
+    case ProfileStage::Present: return "present";
+    case ProfileStage::TurnMove: return "move";
+    case ProfileStage::TurnCombat: return "combat";
+    case ProfileStage::TurnItems: return "items";
+    case ProfileStage::TurnEnemies: return "enemies";
+    case ProfileStage::TurnFireflies: return "fireflies";
+    case ProfileStage::TurnEffects: return "effects";
+    case ProfileStage::TurnFov: return "FOV";
+    case ProfileStage::Count: break;
+    }
+    return "?";
+}
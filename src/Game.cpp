@@ -1,14 +1,27 @@
 #include "Game.h"
+#include "Replay.h"
+#include "StateHash.h"
+#include "Trace.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <ctime>
+#include <initializer_list>
+#include <type_traits>
 
 namespace {
-// Простой helper для целых случайных чисел в диапазоне [min, max].
-int rng(int min, int max)
+using TurnClock = std::chrono::steady_clock;
+
+// Сколько микросекунд прошло с отметки stageStart; отметка сдвигается на "сейчас".
+// Этот же отрезок уходит в трассу под именем traceName (если трассировка собрана).
+double takeStageMicros(TurnClock::time_point& stageStart, const char* traceName)
 {
-    return min + (std::rand() % (max - min + 1));
+    const TurnClock::time_point now = TurnClock::now();
+    const double micros = std::chrono::duration<double, std::micro>(now - stageStart).count();
+    ASC11_TRACE_SPAN(traceName, stageStart, now);
+    stageStart = now;
+    return micros;
 }
 
 // Проверка, стоят ли клетки по соседству по стороне.
@@ -19,48 +32,215 @@ bool isAdjacent(const Position& a, const Position& b)
     return (dx == 1 && dy == 0) || (dx == 0 && dy == 1);
 }
 
-// Отбрасывание игрока от медведя.
-void applyBearKnockback(GameState& state, const Entity& bear)
+// Отбрасывание игрока от медведя, стоящего на (bearX, bearY): на 4–7 клеток в сторону от медведя,
+// пока не упрёмся в стену или другого моба. Щит отбрасывание гасит (дальность всё равно бросается).
+void knockPlayerBack(GameState& state, int bearX, int bearY)
 {
-    const int knockbackDx = (bear.pos.x < state.player.pos.x) ? 1
-                           : (bear.pos.x > state.player.pos.x) ? -1
+    // Определяем направление от медведя к игроку (игрок отлетает в противоположную сторону)
+    const int knockbackDx = (bearX < state.player.pos.x) ? 1
+                           : (bearX > state.player.pos.x) ? -1
                            : 0;
-    const int knockbackDy = (bear.pos.y < state.player.pos.y) ? 1
-                           : (bear.pos.y > state.player.pos.y) ? -1
+    const int knockbackDy = (bearY < state.player.pos.y) ? 1
+                           : (bearY > state.player.pos.y) ? -1
                            : 0;
 
-    if (knockbackDx == 0 && knockbackDy == 0) {
+    // Случайное количество клеток от 4 до 7
+    const int knockbackDistance = 4 + state.rngCombat.below(4);
+
+    // Если есть эффект щита, отбрасывание не действует
+    if (state.shieldTurns > 0) {
         return;
     }
-
-    const int knockbackDistance = rng(4, 7);
     for (int step = 0; step < knockbackDistance; ++step) {
         const int newX = state.player.pos.x + knockbackDx;
         const int newY = state.player.pos.y + knockbackDy;
 
+        // Уперлись в стену, границу или врага — останавливаемся
         if (!state.map.inBounds(newX, newY) || !state.map.isWalkable(newX, newY)) {
             break;
         }
-
-        bool blocked = false;
-        for (const auto& e : state.enemies) {
-            if (e.isAlive() && e.pos.x == newX && e.pos.y == newY) {
-                blocked = true;
-                break;
-            }
-        }
-        if (blocked) {
+        if (state.enemyAt(newX, newY) >= 0) {
             break;
         }
 
         state.player.move(knockbackDx, knockbackDy);
     }
 }
+
+int signOf(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+// Моб i стоит рядом с игроком по кресту / в любой из 8 соседних клеток.
+bool isNextToPlayerOrthogonally(const GameState& state, size_t i)
+{
+    return isAdjacent(Position(state.enemies.x[i], state.enemies.y[i]), state.player.pos);
+}
+
+bool isNextToPlayer(const GameState& state, size_t i)
+{
+    const int dx = std::abs(state.enemies.x[i] - state.player.pos.x);
+    const int dy = std::abs(state.enemies.y[i] - state.player.pos.y);
+    return dx <= 1 && dy <= 1 && (dx + dy) > 0;
+}
+
+// Шаг моба i на (dx, dy): в границах карты, не на клетку игрока и (кроме призрака) не в стену.
+void stepEnemy(GameState& state, size_t i, int dx, int dy, bool throughWalls)
+{
+    if (dx == 0 && dy == 0) {
+        return;
+    }
+    const int newX = state.enemies.x[i] + dx;
+    const int newY = state.enemies.y[i] + dy;
+    if (!state.map.inBounds(newX, newY) || (newX == state.player.pos.x && newY == state.player.pos.y)) {
+        return;
+    }
+    if (!throughWalls && !state.map.isWalkable(newX, newY)) {
+        return;
+    }
+    state.moveEnemy(i, newX, newY);
+}
+
+// Начало боя для живого моба i: если он стоит на клетке игрока, игрок его бьёт
+// (oneHitKill — умирает с одного удара, как змея), убийство засчитывается в квест.
+// Затем моб, если виден, отмечается как встреченный (seen, для Legend).
+void engageEnemy(GameState& state, size_t i, bool oneHitKill, bool& seen)
+{
+    EnemyStore& enemies = state.enemies;
+    if (enemies.x[i] == state.player.pos.x && enemies.y[i] == state.player.pos.y) {
+        if (oneHitKill) {
+            enemies.health[i] = 0;
+        } else {
+            enemies.takeDamage(i, state.player.damage);
+        }
+        // Отслеживаем убийства для квеста
+        if (state.questActive && !enemies.isAlive(i)) {
+            if (state.questType == GameState::QUEST_KILL) {
+                // Ищем цель квеста с таким символом моба
+                const int symbol = enemies.symbol(i);
+                for (size_t t = 0; t < state.questTargets.size(); ++t) {
+                    if (state.questTargets[t].first == symbol) {
+                        state.questProgress[t]++;
+                        break;
+                    }
+                }
+            }
+            // Для обратной совместимости
+            state.questKills++;
+        }
+    }
+    if (state.map.isVisible(enemies.x[i], enemies.y[i])) {
+        seen = true;
+    }
+}
+
+// fn(поле) для каждого числового и логического поля GameState, влияющего на игру
+// (отпечаток stateHash и снимки пишут и читают их в этом порядке).
+template <typename State, typename Fn>
+void forEachScalar(State& state, Fn fn)
+{
+    fn(state.isRunning);
+    fn(state.torchRadius);
+    fn(state.level);
+    fn(state.shieldTurns);
+    fn(state.shieldWhiteSegments);
+    fn(state.visionTurns);
+    fn(state.questActive);
+    fn(state.questType);
+    fn(state.questTarget);
+    fn(state.questKills);
+    fn(state.perkQuestHighlightEnabled);
+    fn(state.isPerkChoiceActive);
+    fn(state.perkChoiceVariant1);
+    fn(state.perkChoiceVariant2);
+    fn(state.perkChoiceVariant3);
+    fn(state.perkBonusRats);
+    fn(state.perkBonusHeals);
+    fn(state.perkBonusShields);
+    fn(state.perkFireflyEnabled);
+    fn(state.perkShowExitFirst3Steps);
+    fn(state.stepsOnCurrentLevel);
+    fn(state.perkBearPoisonNextLevel);
+    fn(state.perkBearPoisonActiveThisLevel);
+    fn(state.perkSnakesNextLevel);
+    fn(state.perkExtraMaxHpItemsNextLevel);
+    fn(state.perkTorchRadiusDeltaNextLevel);
+    fn(state.isPlayerPoisoned);
+    fn(state.poisonTurnsRemaining);
+    fn(state.isPlayerGhostCursed);
+    fn(state.ghostCurseTurnsRemaining);
+    fn(state.isPlayerControlsInverted);
+    fn(state.crabInversionTurnsRemaining);
+    fn(state.showExitBecauseCleared);
+    fn(state.seenRat);
+    fn(state.seenBear);
+    fn(state.seenSnake);
+    fn(state.seenGhost);
+    fn(state.seenCrab);
+    fn(state.seenMedkit);
+    fn(state.seenMaxHP);
+    fn(state.seenShield);
+    fn(state.seenTrap);
+    fn(state.seenQuest);
+    fn(state.unlockedRat);
+    fn(state.unlockedBear);
+    fn(state.unlockedSnake);
+    fn(state.unlockedGhost);
+    fn(state.unlockedCrab);
+    fn(state.unlockedMedkit);
+    fn(state.unlockedMaxHP);
+    fn(state.unlockedShield);
+    fn(state.unlockedTrap);
+    fn(state.unlockedQuest);
+    fn(state.killsRat);
+    fn(state.killsBear);
+    fn(state.killsSnake);
+    fn(state.killsGhost);
+    fn(state.killsCrab);
+    fn(state.itemsMedkit);
+    fn(state.itemsMaxHP);
+    fn(state.itemsShield);
+    fn(state.itemsTrap);
+    fn(state.itemsQuest);
+    fn(state.isDeathScreenActive);
+    fn(state.player.pos.x);
+    fn(state.player.pos.y);
+    fn(state.player.health);
+    fn(state.player.maxHealth);
+    fn(state.player.damage);
+}
+
+// Скалярные поля from -> to по списку forEachScalar (через int32_t, как в снимке).
+void copyScalars(GameState& to, const GameState& from)
+{
+    constexpr size_t MAX_SCALARS = 128; // Полей в forEachScalar меньше
+    int32_t values[MAX_SCALARS];
+    size_t count = 0;
+    forEachScalar(from, [&values, &count](const auto& field) { values[count++] = static_cast<int32_t>(field); });
+    count = 0;
+    forEachScalar(to, [&values, &count](auto& field) {
+        field = static_cast<std::decay_t<decltype(field)>>(values[count++]);
+    });
+}
+
+// Краб, которого игрок снял с себя или отпугнул: откат 15–35 ходов, пока он снова не сможет цепляться.
+int rollCrabCooldown(Rng& rng)
+{
+    const int minCooldown = 15;
+    const int maxCooldown = 35;
+    return minCooldown + rng.below(maxCooldown - minCooldown + 1);
+}
 } // namespace
 
 GameState::GameState()
-    : map(),
-      player(5, 5, SYM_PLAYER, TCOD_ColorRGB{100, 200, 255}),
+    : GameState(static_cast<uint64_t>(std::time(nullptr)))
+{
+}
+
+GameState::GameState(uint64_t seed_, int mapWidth, int mapHeight)
+    : map(mapWidth, mapHeight),
+      player(5, 5, SYM_PLAYER, RgbColor{100, 200, 255}),
       enemies(),
       isRunning(true),
       torchRadius(8), // Базовый радиус факела
@@ -89,350 +269,486 @@ GameState::GameState()
       perkTorchRadiusDeltaNextLevel(0),
       showExitBecauseCleared(false)
 {
-    // Инициализируем генератор случайных чисел один раз.
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
+    // Инициализируем генераторы случайных чисел один раз.
+    reseed(seed_);
 
     generateNewLevel();
 }
 
-// Обновление позиций врагов (простой AI: двигаются к игроку)
-void GameState::updateEnemies()
+GameState::~GameState()
+{
+    if (pendingMapTask.valid()) {
+        pendingMapTask.wait();
+    }
+}
+
+GameState::GameState(const GameState& other)
+    : map(other.map.getWidth(), other.map.getHeight()),
+      player(other.player),
+      pregenerateNextLevel(false)
+{
+    *this = other;
+}
+
+GameState& GameState::operator=(const GameState& other)
 {
+    if (this == &other) {
+        return *this;
+    }
+    // Своя фоновая генерация строила этаж для прежнего состояния — дожидаемся и забываем
+    if (pendingMapTask.valid()) {
+        pendingMapTask.wait();
+    }
+    pendingMapLevel = 0;
+
+    map = other.map;
+    player = other.player;
+    enemies = other.enemies;
+    copyScalars(*this, other);
+    questTargets = other.questTargets;
+    questProgress = other.questProgress;
+    fireflies = other.fireflies;
+    collectedPerks = other.collectedPerks;
+    seed = other.seed;
+    rngMap = other.rngMap;
+    rngSpawn = other.rngSpawn;
+    rngAi = other.rngAi;
+    rngCombat = other.rngCombat;
+    levelSerial = other.levelSerial;
+    enemyGrid.assign(other.enemyGrid);
+    // Поля расстояний помнят карту по адресу и счётчику изменений — у нашей карты теперь чужой счётчик
+    groundFlow.invalidate();
+    snakeFlow.invalidate();
+    return *this;
+}
+
+// Пересеиваем все потоки случайных чисел от одного сида.
+// Номер потока у каждой подсистемы свой, поэтому последовательности не пересекаются.
+void GameState::reseed(uint64_t newSeed)
+{
+    seed = newSeed;
+    rngMap.seed(newSeed, 1);
+    rngSpawn.seed(newSeed, 2);
+    rngAi.seed(newSeed, 3);
+    rngCombat.seed(newSeed, 4);
+}
+
+uint64_t GameState::stateHash() const
+{
+    StateHash hash;
+    hash.add(map.contentHash());
+    forEachScalar(*this, [&hash](const auto& field) { hash.add(field); });
+
     for (size_t i = 0; i < enemies.size(); ++i) {
-        if (!enemies[i].isAlive()) {
-            continue; // Пропускаем мертвых
-        }
+        hash.add(enemies.typeOf(i));
+        hash.add(enemies.x[i]);
+        hash.add(enemies.y[i]);
+        hash.add(enemies.health[i]);
+        hash.add(enemies.maxHealth[i]);
+        hash.add(enemies.damage[i]);
+        hash.add(enemies.crabAttached[i]);
+        hash.add(enemies.crabCooldown[i]);
+    }
+    for (const Firefly& firefly : fireflies) {
+        hash.add(firefly.x);
+        hash.add(firefly.y);
+    }
+    for (size_t i = 0; i < questTargets.size(); ++i) {
+        hash.add(questTargets[i].first);
+        hash.add(questTargets[i].second);
+        hash.add(i < questProgress.size() ? questProgress[i] : 0);
+    }
+    for (PerkEffect perk : collectedPerks) {
+        hash.add(std::string(perkEffectName(perk))); // По названию: отпечатки старых записей остаются верными
+    }
 
-        int dx = 0;
-        int dy = 0;
+    hash.add(seed);
+    hash.add(rngMap.getState());
+    hash.add(rngSpawn.getState());
+    hash.add(rngAi.getState());
+    hash.add(rngCombat.getState());
+    return hash.get();
+}
 
-        // Простое приближение к игроку.
-        // Для обычных врагов (крыса, медведь) — как раньше: двигаемся по прямой.
-        // Для змеи — особое поведение: ходит только по диагонали.
-        if (enemies[i].symbol == SYM_SNAKE) {
-            // Считаем направление до игрока по осям.
-            int diffX = player.pos.x - enemies[i].pos.x;
-            int diffY = player.pos.y - enemies[i].pos.y;
+void GameState::writeSnapshot(ByteWriter& out) const
+{
+    map.writeSnapshot(out);
+    forEachScalar(*this, [&out](const auto& field) { out.i32(static_cast<int32_t>(field)); });
 
-            if (diffX > 0) dx = 1;
-            else if (diffX < 0) dx = -1;
+    out.u32(static_cast<uint32_t>(enemies.size()));
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        out.u8(static_cast<uint8_t>(enemies.typeOf(i)));
+        out.i32(enemies.x[i]);
+        out.i32(enemies.y[i]);
+        out.i32(enemies.health[i]);
+        out.i32(enemies.maxHealth[i]);
+        out.i32(enemies.damage[i]);
+        out.bytes(&enemies.color[i], sizeof(RgbColor));
+        out.u8(enemies.crabAttached[i]);
+        out.i32(enemies.crabCooldown[i]);
+    }
+    out.u32(static_cast<uint32_t>(fireflies.size()));
+    for (const Firefly& firefly : fireflies) {
+        out.i32(firefly.x);
+        out.i32(firefly.y);
+    }
+    out.u32(static_cast<uint32_t>(questTargets.size()));
+    for (size_t i = 0; i < questTargets.size(); ++i) {
+        out.i32(questTargets[i].first);
+        out.i32(questTargets[i].second);
+        out.i32(i < questProgress.size() ? questProgress[i] : 0);
+    }
+    out.u32(static_cast<uint32_t>(collectedPerks.size()));
+    for (PerkEffect perk : collectedPerks) {
+        out.string(perkEffectName(perk));
+    }
 
-            if (diffY > 0) dy = 1;
-            else if (diffY < 0) dy = -1;
+    out.u64(seed);
+    out.u64(levelSerial);
+    for (const Rng* rng : {&rngMap, &rngSpawn, &rngAi, &rngCombat}) {
+        out.u64(rng->getState());
+        out.u64(rng->getIncrement());
+    }
+}
 
-            // Змея ходит только по диагонали: если одна из осей совпадает,
-            // она просто стоит на месте и ждет более удобного момента.
-            if (dx == 0 || dy == 0) {
-                dx = 0;
-                dy = 0;
-            }
-        } else if (enemies[i].symbol == SYM_GHOST) {
-            // Призрак двигается свободно по диагонали и игнорирует стены.
-            // Он всегда старается приблизиться к игроку на 1 клетку (как "король" в шахматах).
-            int diffX = player.pos.x - enemies[i].pos.x;
-            int diffY = player.pos.y - enemies[i].pos.y;
-
-            if (diffX > 0) dx = 1;
-            else if (diffX < 0) dx = -1;
-
-            if (diffY > 0) dy = 1;
-            else if (diffY < 0) dy = -1;
-        } else if (enemies[i].symbol == SYM_CRAB) {
-            // Краб: ходит только по вертикали/горизонтали.
-            // В обычном состоянии старается приблизиться к игроку.
-            // В состоянии "паники" после отцепления — наоборот убегает от него.
-            Entity& crab = enemies[i];
-
-            if (crab.crabAttachedToPlayer) {
-                // Прицепленный краб не двигается по карте.
-                dx = 0;
-                dy = 0;
-            } else {
-                int diffX = player.pos.x - crab.pos.x;
-                int diffY = player.pos.y - crab.pos.y;
-
-                if (crab.crabAttachmentCooldown > 0) {
-                    // Краб в панике убегает от игрока:
-                    // выбираем направление, противоположное игроку.
-                    if (diffX > 0) dx = -1;
-                    else if (diffX < 0) dx = 1;
-
-                    if (diffY > 0) dy = -1;
-                    else if (diffY < 0) dy = 1;
-
-                    // Каждый ход уменьшаем таймер "паники".
-                    crab.crabAttachmentCooldown--;
-                    if (crab.crabAttachmentCooldown <= 0) {
-                        crab.crabAttachmentCooldown = 0;
-                        // Как только откат закончился — возвращаем яркий цвет.
-                        crab.color = TCOD_ColorRGB{255, 140, 0}; // ярко-оранжевый
-                    }
-                } else {
-                    // Обычное состояние: краб хочет приблизиться к игроку.
-                    if (diffX > 0) dx = 1;
-                    else if (diffX < 0) dx = -1;
+bool GameState::readSnapshot(ByteReader& in)
+{
+    if (!map.readSnapshot(in)) {
+        return false;
+    }
+    forEachScalar(*this, [&in](auto& field) { field = static_cast<std::decay_t<decltype(field)>>(in.i32()); });
+    if (!map.inBounds(player.pos.x, player.pos.y)) {
+        return false;
+    }
 
-                    if (diffY > 0) dy = 1;
-                    else if (diffY < 0) dy = -1;
-                }
+    // Мобы в порядке строк: add в конец своей группы, а группы идут по порядку типов — строки не переставляются
+    enemies.clear();
+    const uint32_t enemyCount = in.u32();
+    for (uint32_t n = 0; n < enemyCount && in.ok(); ++n) {
+        const uint8_t type = in.u8();
+        const int x = in.i32();
+        const int y = in.i32();
+        const int health = in.i32();
+        const int maxHealth = in.i32();
+        const int damage = in.i32();
+        RgbColor color{};
+        in.bytes(&color, sizeof(RgbColor));
+        const uint8_t crabAttached = in.u8();
+        const int crabCooldown = in.i32();
+        if (type >= ENEMY_TYPE_COUNT || !map.inBounds(x, y)) {
+            return false;
+        }
+        const size_t row = enemies.add(static_cast<EnemyType>(type), x, y, maxHealth, damage, color);
+        enemies.health[row] = health;
+        enemies.crabAttached[row] = crabAttached;
+        enemies.crabCooldown[row] = crabCooldown;
+    }
+    rebuildEnemyGrid();
 
-                // Краб может ходить только по вертикали или горизонтали,
-                // поэтому случайно выбираем одно из направлений и обнуляем второе.
-                if (std::rand() % 2 == 0) {
-                    dy = 0;
-                } else {
-                    dx = 0;
-                }
-            }
-        } else {
-            // Простой AI: двигаемся к игроку
-            if (enemies[i].pos.x < player.pos.x) {
-                dx = 1;
-            } else if (enemies[i].pos.x > player.pos.x) {
-                dx = -1;
-            }
+    fireflies.clear();
+    const uint32_t fireflyCount = in.u32();
+    for (uint32_t n = 0; n < fireflyCount && in.ok(); ++n) {
+        const int x = in.i32();
+        const int y = in.i32();
+        if (!map.inBounds(x, y)) {
+            return false;
+        }
+        fireflies.insert(Firefly(x, y));
+    }
+    questTargets.clear();
+    questProgress.clear();
+    const uint32_t targetCount = in.u32();
+    for (uint32_t n = 0; n < targetCount && in.ok(); ++n) {
+        const int symbol = in.i32();
+        const int target = in.i32();
+        questTargets.push_back({symbol, target});
+        questProgress.push_back(in.i32());
+    }
+    collectedPerks.clear();
+    const uint32_t perkCount = in.u32();
+    for (uint32_t n = 0; n < perkCount && in.ok(); ++n) {
+        const std::string name = in.string();
+        int effect = 0;
+        while (effect < PERK_EFFECT_COUNT && name != perkEffectName(static_cast<PerkEffect>(effect))) {
+            ++effect;
+        }
+        if (effect == PERK_EFFECT_COUNT) {
+            return false;
+        }
+        collectedPerks.push_back(static_cast<PerkEffect>(effect));
+    }
 
-            if (enemies[i].pos.y < player.pos.y) {
-                dy = 1;
-            } else if (enemies[i].pos.y > player.pos.y) {
-                dy = -1;
-            }
+    seed = in.u64();
+    levelSerial = in.u64();
+    for (Rng* rng : {&rngMap, &rngSpawn, &rngAi, &rngCombat}) {
+        const uint64_t state = in.u64();
+        const uint64_t increment = in.u64();
+        rng->restore(state, increment);
+    }
+    return in.ok();
+}
+
+int GameState::enemyAt(int x, int y) const
+{
+    return enemyGrid.findAt(x, y, [this](int32_t index) {
+        return enemies.isAlive(static_cast<size_t>(index));
+    });
+}
+
+void GameState::moveEnemy(size_t index, int x, int y)
+{
+    enemies.x[index] = x;
+    enemies.y[index] = y;
+    enemyGrid.place(static_cast<int32_t>(index), x, y);
+}
+
+void GameState::onEnemyMoved(size_t from, size_t to)
+{
+    enemyGrid.remove(static_cast<int32_t>(from));
+    enemyGrid.place(static_cast<int32_t>(to), enemies.x[to], enemies.y[to]);
+}
 
-            // Случайно выбираем направление (горизонтальное или вертикальное)
-            if (std::rand() % 2 == 0) {
+void GameState::rebuildEnemyGrid()
+{
+    enemyGrid.rebuild(map.getWidth(), map.getHeight(), enemies.x, enemies.y);
+}
+
+// Обновление позиций врагов (простой AI: двигаются к игроку)
+// Наземные мобы спускаются по полю расстояний до игрока (FlowField), одному на всех;
+// вне окна поля и там, где пути нет, двигаются по-старому — жадно по осям.
+// У каждого типа свой цикл по своей группе в enemies; группы идут в том же порядке,
+// в каком мобы спавнятся, поэтому и броски rngAi идут в прежнем порядке.
+void GameState::updateEnemies()
+{
+    ASC11_TRACE_SCOPE("GameState::updateEnemies");
+    const int playerX = player.pos.x;
+    const int playerY = player.pos.y;
+    groundFlow.build(map, playerX, playerY, FLOW_RADIUS, FlowMoves::Orthogonal);
+
+    // Крысы и медведи (их группы лежат подряд): по полю, шагами по кресту.
+    for (size_t i = enemies.groupBegin(EnemyType::Rat); i < enemies.groupEnd(EnemyType::Bear); ++i) {
+        if (!enemies.isAlive(i)) {
+            continue; // Пропускаем мертвых
+        }
+        int dx = 0;
+        int dy = 0;
+        if (groundFlow.distance(enemies.x[i], enemies.y[i]) != FlowField::UNREACHED) {
+            groundFlow.step(enemies.x[i], enemies.y[i], rngAi, dx, dy);
+        } else {
+            // Простой AI: двигаемся к игроку по одной случайной оси
+            dx = signOf(playerX - enemies.x[i]);
+            dy = signOf(playerY - enemies.y[i]);
+            if (rngAi.below(2) == 0) {
                 dy = 0;
             } else {
                 dx = 0;
             }
         }
+        stepEnemy(*this, i, dx, dy, false);
+    }
 
-        int newX = enemies[i].pos.x + dx;
-        int newY = enemies[i].pos.y + dy;
+    // Змеи ходят только по диагонали: своё поле snakeFlow (строим, только если змеи есть).
+    const size_t snakesBegin = enemies.groupBegin(EnemyType::Snake);
+    const size_t snakesEnd = enemies.groupEnd(EnemyType::Snake);
+    if (snakesBegin < snakesEnd) {
+        snakeFlow.build(map, playerX, playerY, FLOW_RADIUS, FlowMoves::Diagonal);
+    }
+    for (size_t i = snakesBegin; i < snakesEnd; ++i) {
+        if (!enemies.isAlive(i)) {
+            continue;
+        }
+        int dx = 0;
+        int dy = 0;
+        if (snakeFlow.distance(enemies.x[i], enemies.y[i]) != FlowField::UNREACHED) {
+            // Диагональный путь до игрока есть: шаг по полю (или стоим, если уже рядом).
+            snakeFlow.step(enemies.x[i], enemies.y[i], rngAi, dx, dy);
+        } else {
+            dx = signOf(playerX - enemies.x[i]);
+            dy = signOf(playerY - enemies.y[i]);
+            // Если одна из осей совпадает, змея стоит на месте и ждет более удобного момента.
+            if (dx == 0 || dy == 0) {
+                dx = 0;
+                dy = 0;
+            }
+        }
+        stepEnemy(*this, i, dx, dy, false);
+    }
 
-        // Проверяем, можно ли туда пойти
-        if (newX >= 0 && newX < Map::WIDTH &&
-            newY >= 0 && newY < Map::HEIGHT &&
-            !(newX == player.pos.x && newY == player.pos.y)) {
+    // Призраки: как "король" в шахматах, на 1 клетку к игроку, сквозь стены.
+    for (size_t i = enemies.groupBegin(EnemyType::Ghost); i < enemies.groupEnd(EnemyType::Ghost); ++i) {
+        if (enemies.isAlive(i)) {
+            stepEnemy(*this, i, signOf(playerX - enemies.x[i]), signOf(playerY - enemies.y[i]), true);
+        }
+    }
 
-            // Обычные враги уважают стены, призрак — нет.
-            bool canMoveThroughCell = true;
-            if (enemies[i].symbol != SYM_GHOST) {
-                canMoveThroughCell = map.isWalkable(newX, newY);
+    // Крабы: только по вертикали/горизонтали. Прицепленный краб сидит на игроке,
+    // после отцепления краб какое-то время в "панике" убегает от игрока.
+    for (size_t i = enemies.groupBegin(EnemyType::Crab); i < enemies.groupEnd(EnemyType::Crab); ++i) {
+        if (!enemies.isAlive(i) || enemies.crabAttached[i]) {
+            continue;
+        }
+        int dx = 0;
+        int dy = 0;
+        if (enemies.crabCooldown[i] == 0 &&
+            groundFlow.distance(enemies.x[i], enemies.y[i]) != FlowField::UNREACHED) {
+            // Обычное состояние, путь до игрока есть: шаг по полю (поле и так по кресту).
+            groundFlow.step(enemies.x[i], enemies.y[i], rngAi, dx, dy);
+        } else {
+            dx = signOf(playerX - enemies.x[i]);
+            dy = signOf(playerY - enemies.y[i]);
+            if (enemies.crabCooldown[i] > 0) {
+                // Паника: направление, противоположное игроку
+                dx = -dx;
+                dy = -dy;
+                // Каждый ход уменьшаем таймер "паники".
+                enemies.crabCooldown[i]--;
+                if (enemies.crabCooldown[i] <= 0) {
+                    enemies.crabCooldown[i] = 0;
+                    // Как только откат закончился — возвращаем яркий цвет.
+                    enemies.color[i] = RgbColor{255, 140, 0}; // ярко-оранжевый
+                }
             }
-
-            if (canMoveThroughCell) {
-                enemies[i].move(dx, dy);
+            // Случайно выбираем одно из направлений и обнуляем второе.
+            if (rngAi.below(2) == 0) {
+                dy = 0;
+            } else {
+                dx = 0;
             }
         }
+        stepEnemy(*this, i, dx, dy, false);
     }
 }
 
 // Обработка боя
+// Мобы на клетке игрока получают удар, видимые отмечаются для Legend, соседние атакуют игрока.
+// Каждый тип — свой цикл по своей группе; порядок групп — порядок в enemies, поэтому
+// удары и броски rngCombat идут в том же порядке, что при общем цикле по всем мобам.
 void GameState::processCombat()
 {
-    for (auto& enemy : enemies) {
-        if (!enemy.isAlive()) {
+    // Крысы: кусают только по кресту, урон проходит сначала по щиту.
+    for (size_t i = enemies.groupBegin(EnemyType::Rat); i < enemies.groupEnd(EnemyType::Rat); ++i) {
+        if (!enemies.isAlive(i)) {
             continue;
         }
-
-        // Если враг на той же клетке, что и игрок
-        if (enemy.pos.x == player.pos.x &&
-            enemy.pos.y == player.pos.y) {
-        // Игрок атакует врага.
-        // Змея умирает от одного удара, остальные враги получают обычный урон.
-            bool wasAlive = enemy.isAlive();
-            if (enemy.symbol == SYM_SNAKE) {
-                enemy.health = 0;
-            } else {
-                enemy.takeDamage(player.damage);
-            }
-            // Отслеживаем убийства для квеста
-            if (questActive && wasAlive && !enemy.isAlive()) {
-                if (questType == QUEST_KILL) {
-                    // Ищем цель квеста с таким символом моба
-                    for (size_t i = 0; i < questTargets.size(); ++i) {
-                        if (questTargets[i].first == enemy.symbol) {
-                            questProgress[i]++;
-                            break;
-                        }
-                    }
-                }
-                // Для обратной совместимости
-                questKills++;
+        engageEnemy(*this, i, false, seenRat);
+        if (isNextToPlayerOrthogonally(*this, i)) {
+            int remaining = applyShieldHit(enemies.damage[i]);
+            if (remaining > 0) {
+                player.takeDamage(remaining);
             }
         }
+    }
 
-        // Помечаем, что этот тип врага уже \"встречен\" (для Legend),
-        // если он находится в пределах видимости игрока.
-        if (map.isVisible(enemy.pos.x, enemy.pos.y)) {
-            if (enemy.symbol == SYM_ENEMY) seenRat = true;
-            else if (enemy.symbol == SYM_BEAR) seenBear = true;
-            else if (enemy.symbol == SYM_SNAKE) seenSnake = true;
-            else if (enemy.symbol == SYM_GHOST) seenGhost = true;
-            else if (enemy.symbol == SYM_CRAB) seenCrab = true;
-        }
-
-        // Если враг рядом с игроком, он атакует.
-        // Для обычных врагов — по вертикали/горизонтали,
-        // для змеи — допускаем диагональное соседство (укус по диагонали).
-        int dx = std::abs(enemy.pos.x - player.pos.x);
-        int dy = std::abs(enemy.pos.y - player.pos.y);
-
-        bool isAdjacent = false;
-        if (enemy.symbol == SYM_SNAKE) {
-            // Любая соседняя клетка (8 направлений), кроме самой клетки игрока.
-            isAdjacent = (dx <= 1 && dy <= 1 && (dx + dy) > 0);
-        } else if (enemy.symbol == SYM_GHOST) {
-            // Призрак тоже атакует с любой соседней клетки (8 направлений).
-            isAdjacent = (dx <= 1 && dy <= 1 && (dx + dy) > 0);
+    // Медведи: как крысы (или ядовитый укус, если этаж с мутацией), и отбрасывают игрока.
+    for (size_t i = enemies.groupBegin(EnemyType::Bear); i < enemies.groupEnd(EnemyType::Bear); ++i) {
+        if (!enemies.isAlive(i)) {
+            continue;
+        }
+        engageEnemy(*this, i, false, seenBear);
+        if (!isNextToPlayerOrthogonally(*this, i)) {
+            continue;
+        }
+        if (perkBearPoisonActiveThisLevel) {
+            // Медведь с мутацией отравления: укус работает как у змеи.
+            // Игнорируем щит, наносим небольшой прямой урон и вешаем яд.
+            int instantDamage = std::max(1, player.maxHealth / 100);
+            player.takeDamage(instantDamage);
+            applyPoisonToPlayer(5, 10);
         } else {
-            // Как раньше: только по кресту.
-            isAdjacent = ((dx == 1 && dy == 0) || (dx == 0 && dy == 1));
-        }
-
-        if (isAdjacent) {
-            if (enemy.symbol == SYM_SNAKE) {
-                // Укус змеи игнорирует щит! Моментально снимаем ~1% HP
-                int instantDamage = std::max(1, player.maxHealth / 100);
-                player.takeDamage(instantDamage);
-
-                // Яд игнорирует щит
-                applyPoisonToPlayer(5, 10);
-            } else if (enemy.symbol == SYM_GHOST) {
-                // Призрак "прицепляется" к игроку:
-                // наносит примерно 1% от максимального HP единоразово
-                // и прячет информацию о здоровье на несколько ходов.
-                int ghostDamage = std::max(1, player.maxHealth / 100);
-                int remaining = applyShieldHit(ghostDamage);
-                if (remaining > 0) {
-                    player.takeDamage(remaining);
-
-                    // Каждый новый контакт просто обновляет длительность эффекта.
-                    applyGhostCurseToPlayer(8, 12);
-
-                    // После успешной атаки и наложения эффекта призрак "рассеивается":
-                    // он больше не существует на карте.
-                    enemy.health = 0;
-                }
-            } else if (enemy.symbol == SYM_CRAB) {
-                // Особое поведение краба.
-                // Если управление ещё НЕ инвертировано и краб не в откате,
-                // то при приближении он "прицепляется" к игроку.
-                if (!isPlayerControlsInverted && enemy.crabAttachmentCooldown == 0) {
-                    // Вешаем эффект инверсии управления.
-                    applyCrabInversionToPlayer(8, 15);
-
-                    // Помечаем, что именно этот краб прицепился к игроку.
-                    enemy.crabAttachedToPlayer = true;
-                    // Краб "садится" на игрока: его координаты становятся координатами игрока.
-                    enemy.pos.x = player.pos.x;
-                    enemy.pos.y = player.pos.y;
-                } else {
-                    // Если эффект уже висит (или краб недавно отцепился),
-                    // он не может прицепиться и просто наносит небольшой урон (~1% HP).
-                    int crabDamage = std::max(1, player.maxHealth / 100);
-                    int remaining = applyShieldHit(crabDamage);
-                    if (remaining > 0) {
-                        player.takeDamage(remaining);
-                    }
-                }
-            } else {
-                // Обычная атака (с учётом возможного перка на "ядовитых" медведей).
-                if (enemy.symbol == SYM_BEAR && perkBearPoisonActiveThisLevel) {
-                    // Медведь с мутацией отравления: укус работает как у змеи.
-                    // Игнорируем щит, наносим небольшой прямой урон и вешаем яд.
-                    int instantDamage = std::max(1, player.maxHealth / 100);
-                    player.takeDamage(instantDamage);
-                    applyPoisonToPlayer(5, 10);
-                } else {
-                    // Обычный урон проходит сначала по щиту, затем по здоровью.
-                    int remaining = applyShieldHit(enemy.damage);
-                    if (remaining > 0) {
-                        player.takeDamage(remaining);
-                    }
-                }
-            }
-            
-            // Если это медведь, отбрасываем игрока
-            if (enemy.symbol == SYM_BEAR) {
-                // Определяем направление от медведя к игроку (игрок отлетает в противоположную сторону)
-                int knockbackDx = 0;
-                int knockbackDy = 0;
-                
-                if (enemy.pos.x < player.pos.x) {
-                    // Медведь слева, игрок отлетает вправо
-                    knockbackDx = 1;
-                } else if (enemy.pos.x > player.pos.x) {
-                    // Медведь справа, игрок отлетает влево
-                    knockbackDx = -1;
-                }
-                
-                if (enemy.pos.y < player.pos.y) {
-                    // Медведь сверху, игрок отлетает вниз
-                    knockbackDy = 1;
-                } else if (enemy.pos.y > player.pos.y) {
-                    // Медведь снизу, игрок отлетает вверх
-                    knockbackDy = -1;
-                }
-                
-                // Случайное количество клеток от 4 до 7
-                int knockbackDistance = 4 + (std::rand() % 4); // 4, 5, 6 или 7
-                
-                // Если есть эффект щита, отбрасывание не действует
-                if (shieldTurns > 0) {
-                    // Эффект щита даст защиту и уменьшится после любого хода
-                    continue;
-                }
-                // Применяем отбрасывание обычным образом
-                for (int step = 0; step < knockbackDistance; ++step) {
-                    int newX = player.pos.x + knockbackDx;
-                    int newY = player.pos.y + knockbackDy;
-                    
-                    // Проверяем границы и проходимость
-                    if (newX >= 0 && newX < Map::WIDTH &&
-                        newY >= 0 && newY < Map::HEIGHT &&
-                        map.isWalkable(newX, newY)) {
-                        // Проверяем, нет ли там врага
-                        bool canMove = true;
-                        for (const auto& e : enemies) {
-                            if (e.isAlive() && e.pos.x == newX && e.pos.y == newY) {
-                                canMove = false;
-                                break;
-                            }
-                        }
-                        
-                        if (canMove) {
-                            player.move(knockbackDx, knockbackDy);
-                        } else {
-                            // Если уперлись во врага, останавливаемся
-                            break;
-                        }
-                    } else {
-                        // Если уперлись в стену или границу, останавливаемся
-                        break;
-                    }
-                }
+            // Обычный урон проходит сначала по щиту, затем по здоровью.
+            int remaining = applyShieldHit(enemies.damage[i]);
+            if (remaining > 0) {
+                player.takeDamage(remaining);
             }
         }
+        knockPlayerBack(*this, enemies.x[i], enemies.y[i]);
     }
 
-    // Удаляем мертвых врагов и считаем статистику убийств
-    // Проверяем: если после этого хода врагов не останется – показываем лестницу
-    int enemiesAlive = 0;
-    for (auto it = enemies.begin(); it != enemies.end(); ) {
-        if (!it->isAlive()) {
-            // Подсчитываем убийства по типам мобов
-            if (it->symbol == SYM_ENEMY) killsRat++;
-            else if (it->symbol == SYM_BEAR) killsBear++;
-            else if (it->symbol == SYM_SNAKE) killsSnake++;
-            else if (it->symbol == SYM_GHOST) killsGhost++;
-            else if (it->symbol == SYM_CRAB) killsCrab++;
-            it = enemies.erase(it);
+    // Змеи: умирают с одного удара, кусают с любой соседней клетки (8 направлений).
+    for (size_t i = enemies.groupBegin(EnemyType::Snake); i < enemies.groupEnd(EnemyType::Snake); ++i) {
+        if (!enemies.isAlive(i)) {
+            continue;
+        }
+        engageEnemy(*this, i, true, seenSnake);
+        if (isNextToPlayer(*this, i)) {
+            // Укус змеи игнорирует щит! Моментально снимаем ~1% HP
+            int instantDamage = std::max(1, player.maxHealth / 100);
+            player.takeDamage(instantDamage);
+
+            // Яд игнорирует щит
+            applyPoisonToPlayer(5, 10);
+        }
+    }
+
+    // Призраки: атакуют с любой соседней клетки и после удара рассеиваются.
+    for (size_t i = enemies.groupBegin(EnemyType::Ghost); i < enemies.groupEnd(EnemyType::Ghost); ++i) {
+        if (!enemies.isAlive(i)) {
+            continue;
+        }
+        engageEnemy(*this, i, false, seenGhost);
+        if (!isNextToPlayer(*this, i)) {
+            continue;
+        }
+        // Призрак "прицепляется" к игроку:
+        // наносит примерно 1% от максимального HP единоразово
+        // и прячет информацию о здоровье на несколько ходов.
+        int ghostDamage = std::max(1, player.maxHealth / 100);
+        int remaining = applyShieldHit(ghostDamage);
+        if (remaining > 0) {
+            player.takeDamage(remaining);
+
+            // Каждый новый контакт просто обновляет длительность эффекта.
+            applyGhostCurseToPlayer(8, 12);
+
+            // После успешной атаки и наложения эффекта призрак "рассеивается":
+            // он больше не существует на карте.
+            enemies.health[i] = 0;
+        }
+    }
+
+    // Крабы: по кресту. Если управление ещё НЕ инвертировано и краб не в откате,
+    // он "прицепляется" к игроку, иначе просто щиплет (~1% HP).
+    for (size_t i = enemies.groupBegin(EnemyType::Crab); i < enemies.groupEnd(EnemyType::Crab); ++i) {
+        if (!enemies.isAlive(i)) {
+            continue;
+        }
+        engageEnemy(*this, i, false, seenCrab);
+        if (!isNextToPlayerOrthogonally(*this, i)) {
+            continue;
+        }
+        if (!isPlayerControlsInverted && enemies.crabCooldown[i] == 0) {
+            // Вешаем эффект инверсии управления.
+            applyCrabInversionToPlayer(8, 15);
+
+            // Помечаем, что именно этот краб прицепился к игроку.
+            enemies.crabAttached[i] = 1;
+            // Краб "садится" на игрока: его координаты становятся координатами игрока.
+            moveEnemy(i, player.pos.x, player.pos.y);
         } else {
-            ++it;
-            enemiesAlive++;
+            int crabDamage = std::max(1, player.maxHealth / 100);
+            int remaining = applyShieldHit(crabDamage);
+            if (remaining > 0) {
+                player.takeDamage(remaining);
+            }
         }
     }
+
+    // Удаляем мертвых врагов и считаем статистику убийств
+    // Проверяем: если после этого хода врагов не останется – показываем лестницу
+    // Удаление — перенос строк (O(1) на моба), сетка клеток поправляется по каждому переносу.
+    enemies.removeDead(
+        [this](size_t index, EnemyType type) {
+            enemyGrid.remove(static_cast<int32_t>(index));
+            switch (type) {
+            case EnemyType::Rat: killsRat++; break;
+            case EnemyType::Bear: killsBear++; break;
+            case EnemyType::Snake: killsSnake++; break;
+            case EnemyType::Ghost: killsGhost++; break;
+            case EnemyType::Crab: killsCrab++; break;
+            }
+        },
+        [this](size_t from, size_t to) { onEnemyMoved(from, to); });
+    const size_t enemiesAlive = enemies.size();
     // Если больше нет живых врагов и лестница еще не была раскрыта этим способом, включаем флаг.
     if (enemiesAlive == 0 && !showExitBecauseCleared) {
         showExitBecauseCleared = true;
@@ -500,7 +816,7 @@ void GameState::applyPoisonToPlayer(int minTurns, int maxTurns)
     }
 
     int range = maxTurns - minTurns + 1;
-    int duration = minTurns + (range > 0 ? std::rand() % range : 0);
+    int duration = minTurns + (range > 0 ? rngCombat.below(range) : 0);
 
     isPlayerPoisoned = true;
     poisonTurnsRemaining = duration;
@@ -537,7 +853,7 @@ void GameState::applyGhostCurseToPlayer(int minTurns, int maxTurns)
     }
 
     int range = maxTurns - minTurns + 1;
-    int duration = minTurns + (range > 0 ? std::rand() % range : 0);
+    int duration = minTurns + (range > 0 ? rngCombat.below(range) : 0);
 
     isPlayerGhostCursed = true;
     ghostCurseTurnsRemaining = duration;
@@ -567,14 +883,8 @@ void GameState::updateCrabInversion()
     // Ищем краба, который был прицеплен к игроку.
     // Краб при отцеплении наносит ~3% урона от максимального здоровья,
     // отскакивает на две клетки от игрока и впадает в "панический побег".
-    for (auto& enemy : enemies) {
-        if (!enemy.isAlive()) {
-            continue;
-        }
-        if (enemy.symbol != SYM_CRAB) {
-            continue;
-        }
-        if (!enemy.crabAttachedToPlayer) {
+    for (size_t i = enemies.groupBegin(EnemyType::Crab); i < enemies.groupEnd(EnemyType::Crab); ++i) {
+        if (!enemies.isAlive(i) || !enemies.crabAttached[i]) {
             continue;
         }
 
@@ -583,15 +893,9 @@ void GameState::updateCrabInversion()
         player.takeDamage(detachDamage);
 
         // Переводим краба в состояние "убегает от игрока".
-        enemy.crabAttachedToPlayer = false;
+        enemies.crabAttached[i] = 0;
         // Краб некоторое время не может снова прицепляться.
-        int minCooldown = 15;
-        int maxCooldown = 35;
-        if (maxCooldown < minCooldown) {
-            maxCooldown = minCooldown;
-        }
-        int range = maxCooldown - minCooldown + 1;
-        enemy.crabAttachmentCooldown = minCooldown + (range > 0 ? std::rand() % range : 0);
+        enemies.crabCooldown[i] = rollCrabCooldown(rngCombat);
 
         // Отскакиваем краба на две клетки от игрока.
         // Выбираем одно из четырёх направлений, в котором получится поставить краба.
@@ -602,29 +906,27 @@ void GameState::updateCrabInversion()
             { 0, -1}   // вверх
         };
         for (int attempt = 0; attempt < 4; ++attempt) {
-            int idx = std::rand() % 4;
+            int idx = rngCombat.below(4);
             int dx = dirs[idx][0];
             int dy = dirs[idx][1];
 
             int targetX = player.pos.x + dx * 2;
             int targetY = player.pos.y + dy * 2;
 
-            if (targetX < 0 || targetX >= Map::WIDTH ||
-                targetY < 0 || targetY >= Map::HEIGHT) {
+            if (!map.inBounds(targetX, targetY)) {
                 continue;
             }
             if (!map.isWalkable(targetX, targetY)) {
                 continue;
             }
 
-            enemy.pos.x = targetX;
-            enemy.pos.y = targetY;
+            moveEnemy(i, targetX, targetY);
             break;
         }
 
         // Делаем цвет краба более тусклым, чтобы можно было отличить
         // испуганного краба, который пока не может прицепляться.
-        enemy.color = TCOD_ColorRGB{200, 120, 40}; // тускло-оранжевый
+        enemies.color[i] = RgbColor{200, 120, 40}; // тускло-оранжевый
 
         break;
     }
@@ -668,7 +970,7 @@ void GameState::applyCrabInversionToPlayer(int minTurns, int maxTurns)
     }
 
     int range = maxTurns - minTurns + 1;
-    int duration = minTurns + (range > 0 ? std::rand() % range : 0);
+    int duration = minTurns + (range > 0 ? rngCombat.below(range) : 0);
 
     isPlayerControlsInverted = true;
     crabInversionTurnsRemaining = duration;
@@ -677,74 +979,76 @@ void GameState::applyCrabInversionToPlayer(int minTurns, int maxTurns)
 // Обработка предметов
 void GameState::processItems()
 {
-    // Проверяем, есть ли предмет на позиции игрока
-    for (int i = static_cast<int>(map.items.size()) - 1; i >= 0; --i) {
-        const Item& item = map.items[i];
-        if (item.pos.x == player.pos.x && item.pos.y == player.pos.y) {
-            // Сначала увеличиваем максимум здоровья, если предмет дает бонус.
-            if (item.maxHealthBoost > 0) {
-                player.maxHealth += item.maxHealthBoost;
-            }
-
-            // Затем лечим, если предмет лечит.
-            if (item.healAmount > 0) {
-                player.health += item.healAmount;
-                if (player.health > player.maxHealth) {
-                    player.health = player.maxHealth;
-                }
-            }
+    // Проверяем, есть ли предмет на позиции игрока (индекс клеток, без перебора всех предметов)
+    const ItemHandle itemHandle = map.getItemAt(player.pos.x, player.pos.y);
+    const Item* found = map.items.get(itemHandle);
+    if (found == nullptr) {
+        return;
+    }
+    const Item& item = *found;
 
-            // Ловушка (мина) '.' наносит 15% от максимального здоровья (щит не защищает).
-            if (item.symbol == SYM_TRAP) {
-                int damage = std::max(1, player.maxHealth * 15 / 100);
-                player.health -= damage;
-                if (player.health < 0) {
-                    player.health = 0;
-                }
-            }
+    // Сначала увеличиваем максимум здоровья, если предмет дает бонус.
+    if (item.maxHealthBoost > 0) {
+        player.maxHealth += item.maxHealthBoost;
+    }
 
-            // Предмет-щит 'O' даёт полный щит: количество делений равно ширине карты.
-            if (item.symbol == SYM_SHIELD) {
-                shieldTurns = Map::WIDTH;        // все деления синие
-                shieldWhiteSegments = 0;         // нет "повреждённых" делений
-            }
+    // Затем лечим, если предмет лечит.
+    if (item.healAmount > 0) {
+        player.health += item.healAmount;
+        if (player.health > player.maxHealth) {
+            player.health = player.maxHealth;
+        }
+    }
 
-            // Квестовый предмет '?' запускает или обновляет задание
-            if (item.symbol == SYM_QUEST) {
-                // Если квест уже активен, обновляем его полностью
-                // Если не активен, создаем новый
-                generateQuest();
-            }
+    // Ловушка (мина) '.' наносит 15% от максимального здоровья (щит не защищает).
+    if (item.symbol == SYM_TRAP) {
+        int damage = std::max(1, player.maxHealth * 15 / 100);
+        player.health -= damage;
+        if (player.health < 0) {
+            player.health = 0;
+        }
+    }
 
-            // Отслеживаем сбор предметов для квеста
-            if (questActive && questType == QUEST_COLLECT && item.symbol != SYM_QUEST) {
-                // Ищем цель квеста с таким символом предмета
-                for (size_t i = 0; i < questTargets.size(); ++i) {
-                    if (questTargets[i].first == item.symbol) {
-                        questProgress[i]++;
-                        break;
-                    }
-                }
-            }
-            
-            // Подсчитываем собранные предметы для статистики
-            if (item.symbol == SYM_ITEM) itemsMedkit++;
-            else if (item.symbol == SYM_MAX_HP) itemsMaxHP++;
-            else if (item.symbol == SYM_SHIELD) itemsShield++;
-            else if (item.symbol == SYM_TRAP) itemsTrap++;
-            else if (item.symbol == SYM_QUEST) itemsQuest++;
+    // Предмет-щит 'O' даёт полный щит: количество делений равно ширине карты.
+    if (item.symbol == SYM_SHIELD) {
+        shieldTurns = Map::DEFAULT_WIDTH;      // все деления синие
+        shieldWhiteSegments = 0;         // нет "повреждённых" делений
+    }
 
-            // Помечаем, что игрок уже встречал этот тип предмета (для Legend)
-            if (item.symbol == SYM_ITEM) seenMedkit = true;
-            else if (item.symbol == SYM_MAX_HP) seenMaxHP = true;
-            else if (item.symbol == SYM_SHIELD) seenShield = true;
-            else if (item.symbol == SYM_TRAP) seenTrap = true;
-            else if (item.symbol == SYM_QUEST) seenQuest = true;
+    // Квестовый предмет '?' запускает или обновляет задание
+    if (item.symbol == SYM_QUEST) {
+        // Если квест уже активен, обновляем его полностью
+        // Если не активен, создаем новый
+        generateQuest();
+    }
 
-            // Убираем предмет
-            map.removeItem(i);
+    // Отслеживаем сбор предметов для квеста
+    if (questActive && questType == QUEST_COLLECT && item.symbol != SYM_QUEST) {
+        // Ищем цель квеста с таким символом предмета
+        for (size_t i = 0; i < questTargets.size(); ++i) {
+            if (questTargets[i].first == item.symbol) {
+                questProgress[i]++;
+                break;
+            }
         }
     }
+    
+    // Подсчитываем собранные предметы для статистики
+    if (item.symbol == SYM_ITEM) itemsMedkit++;
+    else if (item.symbol == SYM_MAX_HP) itemsMaxHP++;
+    else if (item.symbol == SYM_SHIELD) itemsShield++;
+    else if (item.symbol == SYM_TRAP) itemsTrap++;
+    else if (item.symbol == SYM_QUEST) itemsQuest++;
+
+    // Помечаем, что игрок уже встречал этот тип предмета (для Legend)
+    if (item.symbol == SYM_ITEM) seenMedkit = true;
+    else if (item.symbol == SYM_MAX_HP) seenMaxHP = true;
+    else if (item.symbol == SYM_SHIELD) seenShield = true;
+    else if (item.symbol == SYM_TRAP) seenTrap = true;
+    else if (item.symbol == SYM_QUEST) seenQuest = true;
+
+    // Убираем предмет
+    map.removeItem(itemHandle);
 }
 
 // Генерация нового квеста (убийство или сбор предметов)
@@ -755,11 +1059,11 @@ void GameState::generateQuest()
     questProgress.clear();
     
     // Случайно выбираем тип квеста (убийство или сбор)
-    int questTypeChoice = std::rand() % 2;
+    int questTypeChoice = rngSpawn.below(2);
     questType = (questTypeChoice == 0) ? QUEST_KILL : QUEST_COLLECT;
     
     // Определяем количество целей (только четное: 2, 4, 6, 8 для равномерного распределения цветов на 5 букв "Quest")
-    int numTargets = 2 + (std::rand() % 4) * 2; // 2, 4, 6, 8
+    int numTargets = 2 + rngSpawn.below(4) * 2; // 2, 4, 6, 8
     
     if (questType == QUEST_KILL) {
         // Квест на убийство мобов
@@ -773,14 +1077,14 @@ void GameState::generateQuest()
         
         if (availableMobs.empty()) {
             // Если нет доступных мобов, создаем простой квест на убийство любых
-            questTargets.push_back({SYM_ENEMY, 3 + (std::rand() % 8)}); // 3-10
+            questTargets.push_back({SYM_ENEMY, 3 + rngSpawn.below(8)}); // 3-10
             questProgress.push_back(0);
         } else {
             // Выбираем случайные мобы для квеста
             for (int i = 0; i < numTargets && i < static_cast<int>(availableMobs.size()); ++i) {
-                int mobIndex = std::rand() % availableMobs.size();
+                int mobIndex = rngSpawn.below(static_cast<int>(availableMobs.size()));
                 int mobSymbol = availableMobs[mobIndex];
-                int targetCount = 3 + (std::rand() % 8); // 3-10
+                int targetCount = 3 + rngSpawn.below(8); // 3-10
                 questTargets.push_back({mobSymbol, targetCount});
                 questProgress.push_back(0);
                 // Удаляем выбранного моба из списка, чтобы не повторяться
@@ -798,14 +1102,14 @@ void GameState::generateQuest()
         
         if (availableItems.empty()) {
             // Если нет доступных предметов, создаем простой квест на сбор аптечек
-            questTargets.push_back({SYM_ITEM, 3 + (std::rand() % 8)}); // 3-10
+            questTargets.push_back({SYM_ITEM, 3 + rngSpawn.below(8)}); // 3-10
             questProgress.push_back(0);
         } else {
             // Выбираем случайные предметы для квеста
             for (int i = 0; i < numTargets && i < static_cast<int>(availableItems.size()); ++i) {
-                int itemIndex = std::rand() % availableItems.size();
+                int itemIndex = rngSpawn.below(static_cast<int>(availableItems.size()));
                 int itemSymbol = availableItems[itemIndex];
-                int targetCount = 3 + (std::rand() % 8); // 3-10
+                int targetCount = 3 + rngSpawn.below(8); // 3-10
                 questTargets.push_back({itemSymbol, targetCount});
                 questProgress.push_back(0);
                 // Удаляем выбранный предмет из списка, чтобы не повторяться
@@ -824,71 +1128,66 @@ void GameState::generateQuest()
     }
 }
 
-// Логика обработки ввода
-// key - либо символ ('w','a','s','d','q'), либо код стрелки (TCODK_UP и т.п.)
-void handleInput(GameState& state, int key)
+namespace {
+// Смещение хода в сторону; false — действие не шаг (Wait и всё остальное).
+bool actionDelta(Action action, int& dx, int& dy)
 {
-    int dx = 0;
-    int dy = 0;
+    switch (action) {
+    case Action::MoveUp:        dx = 0;  dy = -1; return true;
+    case Action::MoveDown:      dx = 0;  dy = 1;  return true;
+    case Action::MoveLeft:      dx = -1; dy = 0;  return true;
+    case Action::MoveRight:     dx = 1;  dy = 0;  return true;
+    case Action::MoveUpLeft:    dx = -1; dy = -1; return true;
+    case Action::MoveUpRight:   dx = 1;  dy = -1; return true;
+    case Action::MoveDownLeft:  dx = -1; dy = 1;  return true;
+    case Action::MoveDownRight: dx = 1;  dy = 1;  return true;
+    default:                    dx = 0;  dy = 0;  return false;
+    }
+}
 
-    // Обрабатываем разные типы ввода
-    // Основные направления (WASD)
-    if (key == TCODK_UP || key == 'w' || key == 'W') {
-        dy = -1;
-    } else if (key == TCODK_DOWN || key == 's' || key == 'S') {
-        dy = 1;
-    } else if (key == TCODK_LEFT || key == 'a' || key == 'A') {
-        dx = -1;
-    } else if (key == TCODK_RIGHT || key == 'd' || key == 'D') {
-        dx = 1;
-    }
-    // Диагональные направления
-    else if (key == 'q' || key == 'Q') {
-        // Q - влево-вверх (северо-запад)
-        dx = -1;
-        dy = -1;
-    } else if (key == 'e' || key == 'E') {
-        // E - вправо-вверх (северо-восток)
-        dx = 1;
-        dy = -1;
-    } else if (key == 'z' || key == 'Z') {
-        // Z - влево-вниз (юго-запад)
-        dx = -1;
-        dy = 1;
-    } else if (key == 'c' || key == 'C') {
-        // C - вправо-вниз (юго-восток)
-        dx = 1;
-        dy = 1;
-    }
-    // Выход только по ESC
-    else if (key == TCODK_ESCAPE || key == 27) {
+// Принятое действие — в запись сессии, если она ведётся.
+void recordAction(GameState& state, Action action)
+{
+    if (state.recording) {
+        state.recording->record(state, action);
+    }
+}
+
+// Ход игрока: шаг (или удар) в сторону action, затем мобы, бой, эффекты и FOV.
+// Quit только останавливает игру, Wait — ход на месте.
+void playTurn(GameState& state, Action action)
+{
+    ASC11_TRACE_SCOPE("playTurn");
+    TurnTimings& timings = state.lastTurnTimings;
+    timings = TurnTimings{};
+    TurnClock::time_point stageStart = TurnClock::now();
+
+    if (action == Action::Quit) {
         state.isRunning = false;
         return;
     }
 
+    int dx = 0;
+    int dy = 0;
+    const bool isMove = actionDelta(action, dx, dy);
+
     // Если на игроке висит эффект краба — инвертируем направление движения.
     if (state.isPlayerControlsInverted) {
         dx = -dx;
         dy = -dy;
     }
 
-    // Если активен эффект краба и нажата не WASD/WASD/QEZC — ручное снятие краба
+    // Если активен эффект краба и ход не в сторону (ход на месте) — ручное снятие краба
     if (state.isPlayerControlsInverted) {
-        // Комплект допустимых клавиш (верхний + нижний регистр)
-        if (!(key == 'w' || key == 'a' || key == 's' || key == 'd' ||
-              key == 'q' || key == 'e' || key == 'z' || key == 'c' ||
-              key == 'W' || key == 'A' || key == 'S' || key == 'D' ||
-              key == 'Q' || key == 'E' || key == 'Z' || key == 'C')) {
+        if (!isMove) {
             // Найти прицепленного краба
-            for (auto& crab : state.enemies) {
-                if (crab.symbol == SYM_CRAB && crab.crabAttachedToPlayer && crab.isAlive()) {
-                    crab.crabAttachedToPlayer = false;
+            EnemyStore& enemies = state.enemies;
+            for (size_t crabIndex = enemies.groupBegin(EnemyType::Crab); crabIndex < enemies.groupEnd(EnemyType::Crab); ++crabIndex) {
+                if (enemies.crabAttached[crabIndex] && enemies.isAlive(crabIndex)) {
+                    enemies.crabAttached[crabIndex] = 0;
                     // выставить откат
-                    int minCooldown = 15;
-                    int maxCooldown = 35;
-                    int range = maxCooldown - minCooldown + 1;
-                    crab.crabAttachmentCooldown = minCooldown + (range > 0 ? std::rand() % range : 0);
-                    crab.color = TCOD_ColorRGB{200, 120, 40};
+                    enemies.crabCooldown[crabIndex] = rollCrabCooldown(state.rngCombat);
+                    enemies.color[crabIndex] = RgbColor{200, 120, 40};
                     // Краб появляется на 1 клетку рядом с игроком (ищем первую свободную)
                     const int dirs[4][2] = { {1,0}, {-1,0}, {0,1}, {0,-1} };
                     for (int t = 0; t < 4; ++t) {
@@ -896,9 +1195,8 @@ void handleInput(GameState& state, int key)
                         int dyTry = dirs[t][1];
                         int nx = state.player.pos.x + dxTry;
                         int ny = state.player.pos.y + dyTry;
-                        if (nx >= 0 && nx < Map::WIDTH && ny >= 0 && ny < Map::HEIGHT && state.map.isWalkable(nx, ny)) {
-                            crab.pos.x = nx;
-                            crab.pos.y = ny;
+                        if (state.map.inBounds(nx, ny) && state.map.isWalkable(nx, ny)) {
+                            state.moveEnemy(crabIndex, nx, ny);
                             break;
                         }
                     }
@@ -929,42 +1227,45 @@ void handleInput(GameState& state, int key)
             // Если на новой клетке враг — атакуем его.
             // Змея и краб умирают с одного удара (краб может иметь особое поведение,
             // если он был прицеплен к игроку).
-            for (auto& e : state.enemies) {
-                if (e.pos.x == newX && e.pos.y == newY && e.isAlive()) {
-                    if (e.symbol == SYM_SNAKE) {
-                        e.health = 0;
-                    } else if (e.symbol == SYM_CRAB && e.crabAttachedToPlayer) {
+            // Мобы клетки берём из enemyGrid; следующий запоминаем заранее, потому что краб может отлететь.
+            EnemyStore& enemies = state.enemies;
+            for (int32_t index = state.enemyGrid.first(newX, newY); index != OccupancyGrid::NONE; ) {
+                const int32_t nextIndex = state.enemyGrid.following(index);
+                const size_t i = static_cast<size_t>(index);
+                index = nextIndex;
+                if (!enemies.isAlive(i)) {
+                    continue;
+                }
+                switch (enemies.typeOf(i)) {
+                case EnemyType::Snake:
+                    enemies.health[i] = 0;
+                    break;
+                case EnemyType::Crab:
+                    if (enemies.crabAttached[i]) {
                         // Игрок "наступает" на краба, который был прицеплен.
                         // Эффект инверсии снимается, краб отлетает на 2 клетки
                         // дальше по направлению шага и начинает убегать.
                         state.isPlayerControlsInverted = false;
                         state.crabInversionTurnsRemaining = 0;
 
-                        e.crabAttachedToPlayer = false;
+                        enemies.crabAttached[i] = 0;
 
                         // Задаем откат, в течение которого краб не сможет снова прицепляться.
-                        int minCooldown = 15;
-                        int maxCooldown = 35;
-                        if (maxCooldown < minCooldown) {
-                            maxCooldown = minCooldown;
-                        }
-                        int range = maxCooldown - minCooldown + 1;
-                        e.crabAttachmentCooldown = minCooldown + (range > 0 ? std::rand() % range : 0);
+                        enemies.crabCooldown[i] = rollCrabCooldown(state.rngCombat);
 
                         // Переносим краба на 2 клетки дальше от игрока по направлению шага.
-                        e.pos.x = newX + dx;
-                        e.pos.y = newY + dy;
-                        e.pos.x += dx;
-                        e.pos.y += dy;
+                        state.moveEnemy(i, newX + dx * 2, newY + dy * 2);
 
                         // Делаем цвет тусклым — такой краб пока не может цепляться.
-                        e.color = TCOD_ColorRGB{200, 120, 40};
-                    } else if (e.symbol == SYM_CRAB) {
-                        // Обычный краб без особого состояния умирает с одного удара.
-                        e.health = 0;
+                        enemies.color[i] = RgbColor{200, 120, 40};
                     } else {
-                        e.takeDamage(state.player.damage);
+                        // Обычный краб без особого состояния умирает с одного удара.
+                        enemies.health[i] = 0;
                     }
+                    break;
+                default:
+                    enemies.takeDamage(i, state.player.damage);
+                    break;
                 }
             }
 
@@ -976,24 +1277,27 @@ void handleInput(GameState& state, int key)
 
                 // Если на игроке "сидит" краб, он должен оставаться на тех же координатах,
                 // что и игрок, пока не отцепится.
-                for (auto& e : state.enemies) {
-                    if (e.symbol == SYM_CRAB && e.crabAttachedToPlayer && e.isAlive()) {
-                        e.pos.x = state.player.pos.x;
-                        e.pos.y = state.player.pos.y;
+                for (size_t i = enemies.groupBegin(EnemyType::Crab); i < enemies.groupEnd(EnemyType::Crab); ++i) {
+                    if (enemies.crabAttached[i] && enemies.isAlive(i)) {
+                        state.moveEnemy(i, state.player.pos.x, state.player.pos.y);
                     }
                 }
                 
                 // Проверяем переход на следующий уровень
                 if (state.checkExit()) {
+                    timings.move = takeStageMicros(stageStart, "turn.move");
                     return; // Уровень уже сгенерирован, выходим
                 }
             }
         }
     }
 
+    timings.move = takeStageMicros(stageStart, "turn.move");
+
     // Обрабатываем бой и предметы
     int killsBefore = state.questKills;
     state.processCombat();
+    timings.combat = takeStageMicros(stageStart, "turn.combat");
     state.processItems();
     // Проверяем выполнение квеста после возможных убийств/сбора
     if (state.questActive) {
@@ -1017,8 +1321,11 @@ void handleInput(GameState& state, int key)
         }
     }
 
+    timings.items = takeStageMicros(stageStart, "turn.items");
+
     // Обновляем врагов
     state.updateEnemies();
+    timings.enemies = takeStageMicros(stageStart, "turn.enemies");
 
     // Обновляем положение светлячков и раскрываем вокруг них туман войны.
     // Также проверяем столкновения с мобами (светлячки умирают при столкновении).
@@ -1032,16 +1339,9 @@ void handleInput(GameState& state, int key)
             GameState::Firefly& fly = state.fireflies[idx];
             
             // Проверяем столкновение с мобами - если моб наступил на светлячка, он умирает
-            bool killed = false;
-            for (const auto& enemy : state.enemies) {
-                if (enemy.isAlive() && enemy.pos.x == fly.x && enemy.pos.y == fly.y) {
-                    killed = true;
-                    break;
-                }
-            }
-            if (killed) {
+            if (state.enemyAt(fly.x, fly.y) >= 0) {
                 // Удаляем светлячка
-                state.fireflies.erase(state.fireflies.begin() + idx);
+                state.fireflies.eraseAt(idx); // На его место встаёт последний (уже обработанный)
                 continue;
             }
             
@@ -1051,10 +1351,10 @@ void handleInput(GameState& state, int key)
                 { 1, 1}, { 1,-1}, {-1, 1}, {-1,-1}
             };
             for (int attempt = 0; attempt < 8; ++attempt) {
-                int dirIdx = std::rand() % 8;
+                int dirIdx = state.rngAi.below(8);
                 int nx = fly.x + dirs[dirIdx][0];
                 int ny = fly.y + dirs[dirIdx][1];
-                if (nx < 0 || nx >= Map::WIDTH || ny < 0 || ny >= Map::HEIGHT) continue;
+                if (!state.map.inBounds(nx, ny)) continue;
                 // Летаем только по проходимым клеткам-полу.
                 if (!state.map.isWalkable(nx, ny)) continue;
                 // Не садимся на игрока.
@@ -1078,8 +1378,11 @@ void handleInput(GameState& state, int key)
         }
     }
 
+    timings.fireflies = takeStageMicros(stageStart, "turn.fireflies");
+
     // Обрабатываем бой еще раз (на случай, если враг переместился на игрока)
     state.processCombat();
+    timings.combat += takeStageMicros(stageStart, "turn.combat");
 
     // Обновляем эффект отравления после хода (яд тикает по ходам игрока).
     state.updatePoison();
@@ -1090,6 +1393,8 @@ void handleInput(GameState& state, int key)
     // Обновляем эффект краба (инвертированное управление).
     state.updateCrabInversion();
 
+    timings.effects = takeStageMicros(stageStart, "turn.effects");
+
     // Обновляем FOV
     if (state.visionTurns > 0) {
         // Полная подсветка карты: игнорируем обычный FOV
@@ -1097,35 +1402,126 @@ void handleInput(GameState& state, int key)
         // Эффект действует только до следующего хода
         state.visionTurns--;
     } else {
-        // Обычный FOV с учетом стен (уменьшенный радиус относительно визуального факела)
-        // <<< ДЛЯ ИЗМЕНЕНИЯ РАДИУСА FOV ОТНОСИТЕЛЬНО ФАКЕЛА: измени множитель здесь >>>
-        const float FOV_RADIUS_MULTIPLIER = 0.7f; // FOV будет 70% от визуального радиуса факела
-        int fovRadius = static_cast<int>(state.torchRadius * FOV_RADIUS_MULTIPLIER);
-        if (fovRadius < 1) fovRadius = 1; // Минимум 1
-        state.map.computeFOV(state.player.pos.x, state.player.pos.y, fovRadius, true);
-        
-        // Добавляем FOV от светлячков (если они есть)
-        if (state.perkFireflyEnabled && !state.fireflies.empty()) {
-            const int FIREFLY_TORCH_RADIUS = 1; // Радиус факела светлячка (измени здесь для настройки)
-            for (const auto& firefly : state.fireflies) {
-                state.map.addFOV(firefly.x, firefly.y, FIREFLY_TORCH_RADIUS, true);
-            }
+        // Обычный FOV с учетом стен + светлячки
+        state.updateFOV();
+    }
+    timings.fov = takeStageMicros(stageStart, "turn.fov");
+}
+} // namespace
+
+bool step(GameState& state, Action action)
+{
+    // Видимость, с которой играется действие, — как у кадра игрового цикла перед вводом
+    // (на экране смерти без светлячков). В игре runFrame её уже посчитал, и здесь попадание в кеш.
+    state.updateFOV(!state.isDeathScreenActive);
+
+    // Экран смерти: только новая игра
+    if (state.isDeathScreenActive) {
+        if (action == Action::Restart) {
+            recordAction(state, action);
+            state.restartGame();
         }
+        return false;
+    }
+    // Экран выбора перка: только 1/2/3
+    if (state.isPerkChoiceActive) {
+        if (action == Action::ChoosePerk1 || action == Action::ChoosePerk2 || action == Action::ChoosePerk3) {
+            recordAction(state, action);
+            state.applyLevelChoice(1 + static_cast<int>(action) - static_cast<int>(Action::ChoosePerk1));
+        }
+        return false;
+    }
+    if (action == Action::ChoosePerk1 || action == Action::ChoosePerk2 || action == Action::ChoosePerk3 ||
+        action == Action::Restart) {
+        return false;
+    }
+    recordAction(state, action);
+    playTurn(state, action);
+    return true;
+}
+
+// FOV игрока и светлячков. Считается только если что-то изменилось (см. Map::updateFOV),
+// поэтому его можно звать каждый кадр.
+void GameState::updateFOV(bool withFireflies)
+{
+    // Обычный FOV с учетом стен (уменьшенный радиус относительно визуального факела)
+    // <<< ДЛЯ ИЗМЕНЕНИЯ РАДИУСА FOV ОТНОСИТЕЛЬНО ФАКЕЛА: измени множитель здесь >>>
+    const float FOV_RADIUS_MULTIPLIER = 0.7f; // FOV будет 70% от визуального радиуса факела
+    int fovRadius = static_cast<int>(torchRadius * FOV_RADIUS_MULTIPLIER);
+    if (fovRadius < 1) fovRadius = 1; // Минимум 1
+
+    // Добавляем FOV от светлячков (если они есть)
+    fovLights.clear();
+    if (withFireflies && perkFireflyEnabled) {
+        const int FIREFLY_TORCH_RADIUS = 1; // Радиус факела светлячка (измени здесь для настройки)
+        for (const auto& firefly : fireflies) {
+            fovLights.push_back(FovLight{firefly.x, firefly.y, FIREFLY_TORCH_RADIUS});
+        }
+    }
+    map.updateFOV(player.pos.x, player.pos.y, fovRadius, fovLights, true);
+}
+
+// Запускаем генерацию следующей карты в отдельном потоке.
+// Генерация использует только копию rngMap, поэтому результат тот же,
+// что дал бы синхронный вызов map.generate() при переходе.
+void GameState::startNextLevelPregeneration()
+{
+    if (pendingMapTask.valid()) {
+        pendingMapTask.wait(); // Предыдущая задача должна закончиться до переиспользования буфера
+    }
+    if (!pendingMap) {
+        pendingMap = std::make_unique<Map>(map.getWidth(), map.getHeight());
+    }
+
+    pendingMapLevel = level + 1;
+    pendingMapRng = rngMap;
+    Map* target = pendingMap.get();
+    Rng* targetRng = &pendingMapRng;
+    const int targetLevel = pendingMapLevel;
+    pendingMapTask = std::async(std::launch::async, [target, targetRng, targetLevel]() {
+        target->generate(targetLevel, *targetRng);
+    });
+}
+
+bool GameState::isNextLevelReady() const
+{
+    return pendingMapTask.valid() &&
+           pendingMapTask.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void GameState::waitNextLevel()
+{
+    if (pendingMapTask.valid()) {
+        pendingMapTask.wait();
     }
 }
 
 // Генерация нового уровня
 void GameState::generateNewLevel()
 {
+    ASC11_TRACE_SCOPE("GameState::generateNewLevel");
+    ++levelSerial;
     // Сохраняем выживших светлячков перед очисткой карты
-    std::vector<Firefly> survivingFireflies = fireflies;
+    SlotMap<Firefly> survivingFireflies = fireflies;
     
-    // Очищаем карту и врагов
-    map.items.clear();
+    // Очищаем врагов
     enemies.clear();
     
-    // Генерируем новую карту (передаем уровень для контроля спавна предметов на первом уровне)
-    map.generate(level);
+    // Берём карту, заранее построенную в фоне для этого уровня, — это просто обмен буферов.
+    // Иначе генерируем новую карту (передаем уровень для контроля спавна предметов на первом уровне).
+    bool usedPendingMap = false;
+    if (pendingMapTask.valid()) {
+        pendingMapTask.get(); // Обычно уже готово: перк выбирают дольше, чем строится карта
+        if (pendingMapLevel == level) {
+            map.swap(*pendingMap);
+            rngMap = pendingMapRng;
+            usedPendingMap = true;
+        }
+        pendingMapLevel = 0;
+    }
+    if (!usedPendingMap) {
+        map.generate(level, rngMap);
+    }
     
     // Счётчик шагов на уровне и временные эффекты "только на этот этаж"
     stepsOnCurrentLevel = 0;
@@ -1149,16 +1545,16 @@ void GameState::generateNewLevel()
     // Размещаем игрока в безопасном месте с выходами (не в коробке!)
     // Ищем проходимую клетку с минимум 2 выходами В ЦЕНТРЕ КАРТЫ (или очень рядом)
     bool playerPlaced = false;
-    int centerX = Map::WIDTH / 2;
-    int centerY = Map::HEIGHT / 2;
+    int centerX = map.getWidth() / 2;
+    int centerY = map.getHeight() / 2;
     int spawnRadius = 12; // Радиус поиска от центра (можно менять: меньше = ближе к центру)
     for (int attempt = 0; attempt < 500 && !playerPlaced; ++attempt) {
         // Спавним в центре или рядом с центром (±spawnRadius клеток)
-        int px = centerX - spawnRadius + std::rand() % (spawnRadius * 2 + 1);
-        int py = centerY - spawnRadius + std::rand() % (spawnRadius * 2 + 1);
+        int px = centerX - spawnRadius + rngSpawn.below(spawnRadius * 2 + 1);
+        int py = centerY - spawnRadius + rngSpawn.below(spawnRadius * 2 + 1);
         // Ограничиваем границами карты
-        px = std::max(2, std::min(Map::WIDTH - 3, px));
-        py = std::max(2, std::min(Map::HEIGHT - 3, py));
+        px = std::max(2, std::min(map.getWidth() - 3, px));
+        py = std::max(2, std::min(map.getHeight() - 3, py));
         
         if (map.getCell(px, py) == SYM_FLOOR) {
             // Проверяем что вокруг есть минимум 2 проходимых клетки (выходы)
@@ -1178,8 +1574,8 @@ void GameState::generateNewLevel()
     }
     // Если не нашли подходящее место, ставим в центр и гарантируем выходы
     if (!playerPlaced) {
-        player.pos.x = Map::WIDTH / 2;
-        player.pos.y = Map::HEIGHT / 2;
+        player.pos.x = map.getWidth() / 2;
+        player.pos.y = map.getHeight() / 2;
         map.setCell(player.pos.x, player.pos.y, SYM_FLOOR);
         // Гарантируем минимум 2 выхода вокруг игрока
         int dirs[4][2] = {{-1,0}, {1,0}, {0,-1}, {0,1}};
@@ -1198,24 +1594,22 @@ void GameState::generateNewLevel()
     isPlayerControlsInverted = false;
     crabInversionTurnsRemaining = 0;
 
+    // Свободные клетки пола для спавна: дальше каждый моб/предмет берёт одну из них за O(1).
+    freeCells.build(map);
+    freeCells.occupy(player.pos.x, player.pos.y);
+
     // Если перк светлячка активирован — создаём новые светлячки (накапливаются при каждом выборе перка).
     // На первом уровне создаём одного светлячка, на последующих добавляем ещё одного при выборе перка.
     // Здесь мы создаём светлячков только при генерации нового уровня (они уже были добавлены при выборе перка).
     // Но нужно создать первого светлячка, если перк был выбран, но светлячков ещё нет.
     if (perkFireflyEnabled && fireflies.empty()) {
-        // Пробуем найти проходимую клетку пола для первого светлячка.
-        for (int attempt = 0; attempt < 200; ++attempt) {
-            int fx = std::rand() % Map::WIDTH;
-            int fy = std::rand() % Map::HEIGHT;
-            if (map.getCell(fx, fy) == SYM_FLOOR &&
-                !(fx == player.pos.x && fy == player.pos.y) &&
-                !map.isExit(fx, fy)) {
-                fireflies.push_back(GameState::Firefly(fx, fy));
-                // Сразу открываем туман войны вокруг светлячка с радиусом факела
-                const int FIREFLY_TORCH_RADIUS = 2;
-                map.computeFOV(fx, fy, FIREFLY_TORCH_RADIUS, true);
-                break;
-            }
+        // Берём свободную клетку пола для первого светлячка.
+        Position cell;
+        if (freeCells.take(rngSpawn, cell)) {
+            fireflies.insert(GameState::Firefly(cell.x, cell.y));
+            // Сразу открываем туман войны вокруг светлячка с радиусом факела
+            const int FIREFLY_TORCH_RADIUS = 2;
+            map.computeFOV(cell.x, cell.y, FIREFLY_TORCH_RADIUS, true);
         }
     }
     
@@ -1223,8 +1617,8 @@ void GameState::generateNewLevel()
     int enemyChoiceLevel1 = -1; // 0 - Rat, 1 - Bear, 2 - Snake, 3 - Ghost, 4 - Crab
     int itemChoiceLevel1 = -1;  // 0 - Trap, 1 - Shield, 2 - Quest
     if (level == 1) {
-        enemyChoiceLevel1 = std::rand() % 5;
-        itemChoiceLevel1 = std::rand() % 3;
+        enemyChoiceLevel1 = rngSpawn.below(5);
+        itemChoiceLevel1 = rngSpawn.below(3);
         // Разблокируем выбранные моб и предмет на первом уровне
         if (enemyChoiceLevel1 == 0) unlockedRat = true;
         else if (enemyChoiceLevel1 == 1) unlockedBear = true;
@@ -1250,29 +1644,19 @@ void GameState::generateNewLevel()
         if (level == 1) {
             // На первом уровне случайное количество от 3 до 7
             if (enemyChoiceLevel1 == 0) {
-                ratsToSpawn = 3 + (std::rand() % 5); // 3-7 крыс
+                ratsToSpawn = 3 + rngSpawn.below(5); // 3-7 крыс
             }
         } else {
             ratsToSpawn = 5 + level + perkBonusRats;
         }
     }
     for (int i = 0; i < ratsToSpawn; ++i) {
-        for (int attempt = 0; attempt < 100; ++attempt) {
-            int rx = std::rand() % Map::WIDTH;
-            int ry = std::rand() % Map::HEIGHT;
-
-            // Ищем свободную клетку
-            if (map.getCell(rx, ry) == SYM_FLOOR &&
-                !(rx == player.pos.x && ry == player.pos.y) &&
-                !map.isExit(rx, ry)) {
-                Entity rat(rx, ry, SYM_ENEMY, TCOD_ColorRGB{255, 50, 50});
-                rat.health = 3;
-                rat.maxHealth = 3;
-                rat.damage = 1;
-                enemies.push_back(rat);
-                break;
-            }
+        // Берём свободную клетку (если их не осталось — больше никого не ставим)
+        Position cell;
+        if (!freeCells.take(rngSpawn, cell)) {
+            break;
         }
+        enemies.add(EnemyType::Rat, cell.x, cell.y, 3, 1, RgbColor{255, 50, 50});
     }
 
     // Создаем медведей на случайных позициях
@@ -1282,31 +1666,23 @@ void GameState::generateNewLevel()
         if (level == 1) {
             // На первом уровне случайное количество от 1 до 3
             if (enemyChoiceLevel1 == 1) {
-                bearsToSpawn = 1 + (std::rand() % 3); // 1-3 медведя
+                bearsToSpawn = 1 + rngSpawn.below(3); // 1-3 медведя
             }
         } else {
             bearsToSpawn = 2 + level / 2; // Медведей меньше, чем крыс
         }
     }
     for (int i = 0; i < bearsToSpawn; ++i) {
-        for (int attempt = 0; attempt < 100; ++attempt) {
-            int bx = std::rand() % Map::WIDTH;
-            int by = std::rand() % Map::HEIGHT;
-
-            // Ищем свободную клетку
-            if (map.getCell(bx, by) == SYM_FLOOR &&
-                !(bx == player.pos.x && by == player.pos.y) &&
-                !map.isExit(bx, by)) {
-                Entity bear(bx, by, SYM_BEAR, TCOD_ColorRGB{139, 69, 19}); // Коричневый цвет
-                // Случайное здоровье от 8 до 12
-                bear.maxHealth = 8 + (std::rand() % 5); // 8, 9, 10, 11 или 12
-                bear.health = bear.maxHealth;
-                // Случайный урон от 3 до 5
-                bear.damage = 3 + (std::rand() % 3); // 3, 4 или 5
-                enemies.push_back(bear);
-                break;
-            }
+        // Берём свободную клетку
+        Position cell;
+        if (!freeCells.take(rngSpawn, cell)) {
+            break;
         }
+        // Случайное здоровье от 8 до 12 (бросок здоровья раньше броска урона)
+        const int bearHealth = 8 + rngSpawn.below(5); // 8, 9, 10, 11 или 12
+        // Случайный урон от 3 до 5
+        const int bearDamage = 3 + rngSpawn.below(3); // 3, 4 или 5
+        enemies.add(EnemyType::Bear, cell.x, cell.y, bearHealth, bearDamage, RgbColor{139, 69, 19}); // Коричневый цвет
     }
 
     // Создаем змей на случайных позициях.
@@ -1317,7 +1693,7 @@ void GameState::generateNewLevel()
         if (level == 1) {
             // На первом уровне случайное количество от 2 до 4
             if (enemyChoiceLevel1 == 2) {
-                snakesToSpawn = 2 + (std::rand() % 3); // 2-4 змеи
+                snakesToSpawn = 2 + rngSpawn.below(3); // 2-4 змеи
             }
         } else {
             snakesToSpawn = 3 + level / 2 + perkSnakesNextLevel;
@@ -1326,26 +1702,17 @@ void GameState::generateNewLevel()
     // Эффект "+змеи" был только на один уровень — обнуляем.
     perkSnakesNextLevel = 0;
     for (int i = 0; i < snakesToSpawn; ++i) {
-        for (int attempt = 0; attempt < 100; ++attempt) {
-            int sx = std::rand() % Map::WIDTH;
-            int sy = std::rand() % Map::HEIGHT;
-
-            // Ищем свободную клетку
-            if (map.getCell(sx, sy) == SYM_FLOOR &&
-                !(sx == player.pos.x && sy == player.pos.y) &&
-                !map.isExit(sx, sy)) {
-                // Болотно-зелёный цвет для змеи
-                Entity snake(sx, sy, SYM_SNAKE, TCOD_ColorRGB{60, 130, 60});
-                // Здоровье змеи чуть больше, чем у крысы, но меньше, чем у медведя
-                snake.maxHealth = 4 + (std::rand() % 3); // 4–6
-                snake.health = snake.maxHealth;
-                // Урон через поле damage не используем (змея бьёт в процентах от HP),
-                // но заполним его маленьким значением для наглядности.
-                snake.damage = 1;
-                enemies.push_back(snake);
-                break;
-            }
+        // Берём свободную клетку
+        Position cell;
+        if (!freeCells.take(rngSpawn, cell)) {
+            break;
         }
+        // Болотно-зелёный цвет для змеи
+        // Здоровье змеи чуть больше, чем у крысы, но меньше, чем у медведя
+        const int snakeHealth = 4 + rngSpawn.below(3); // 4–6
+        // Урон через поле damage не используем (змея бьёт в процентах от HP),
+        // но заполним его маленьким значением для наглядности.
+        enemies.add(EnemyType::Snake, cell.x, cell.y, snakeHealth, 1, RgbColor{60, 130, 60});
     }
 
     // Создаем призраков на случайных позициях
@@ -1355,31 +1722,21 @@ void GameState::generateNewLevel()
         if (level == 1) {
             // На первом уровне случайное количество от 1 до 2
             if (enemyChoiceLevel1 == 3) {
-                ghostsToSpawn = 1 + (std::rand() % 2); // 1-2 призрака
+                ghostsToSpawn = 1 + rngSpawn.below(2); // 1-2 призрака
             }
         } else {
             ghostsToSpawn = 1 + level / 2; // Немного, но они опасные
         }
     }
     for (int i = 0; i < ghostsToSpawn; ++i) {
-        for (int attempt = 0; attempt < 100; ++attempt) {
-            int gx = std::rand() % Map::WIDTH;
-            int gy = std::rand() % Map::HEIGHT;
-
-            // Ищем свободную клетку пола (как для обычных врагов)
-            if (map.getCell(gx, gy) == SYM_FLOOR &&
-                !(gx == player.pos.x && gy == player.pos.y) &&
-                !map.isExit(gx, gy)) {
-                // Призрак — серый полупрозрачный враг
-                Entity ghost(gx, gy, SYM_GHOST, TCOD_ColorRGB{170, 170, 170});
-                ghost.maxHealth = 5;
-                ghost.health = ghost.maxHealth;
-                // Урон хранить тоже будем, но основной урон — процентный, как в описании.
-                ghost.damage = 1;
-                enemies.push_back(ghost);
-                break;
-            }
+        // Берём свободную клетку пола (как для обычных врагов)
+        Position cell;
+        if (!freeCells.take(rngSpawn, cell)) {
+            break;
         }
+        // Призрак — серый полупрозрачный враг
+        // Урон хранить тоже будем, но основной урон — процентный, как в описании.
+        enemies.add(EnemyType::Ghost, cell.x, cell.y, 5, 1, RgbColor{170, 170, 170});
     }
 
     // Создаем крабов на случайных позициях
@@ -1389,58 +1746,36 @@ void GameState::generateNewLevel()
         if (level == 1) {
             // На первом уровне случайное количество от 1 до 3
             if (enemyChoiceLevel1 == 4) {
-                crabsToSpawn = 1 + (std::rand() % 3); // 1-3 краба
+                crabsToSpawn = 1 + rngSpawn.below(3); // 1-3 краба
             }
         } else {
             crabsToSpawn = 2 + level / 2;
         }
     }
     for (int i = 0; i < crabsToSpawn; ++i) {
-        for (int attempt = 0; attempt < 100; ++attempt) {
-            int cx = std::rand() % Map::WIDTH;
-            int cy = std::rand() % Map::HEIGHT;
-
-            if (map.getCell(cx, cy) == SYM_FLOOR &&
-                !(cx == player.pos.x && cy == player.pos.y) &&
-                !map.isExit(cx, cy)) {
-                // Ярко-оранжевый цвет для обычного краба
-                Entity crab(cx, cy, SYM_CRAB, TCOD_ColorRGB{255, 140, 0});
-                crab.maxHealth = 4;
-                crab.health = crab.maxHealth;
-                crab.damage = 1; // основной "урон" краба — особые эффекты
-                enemies.push_back(crab);
-                break;
-            }
+        Position cell;
+        if (!freeCells.take(rngSpawn, cell)) {
+            break;
         }
+        // Ярко-оранжевый цвет для обычного краба
+        // Основной "урон" краба — особые эффекты, damage = 1
+        enemies.add(EnemyType::Crab, cell.x, cell.y, 4, 1, RgbColor{255, 140, 0});
     }
 
+    // Все мобы этажа расставлены — раскладываем их по клеткам
+    rebuildEnemyGrid();
+
     // Спавним призрачные предметы '.' в случайных местах (не больше 5 за карту).
     // Спавним только если разблокированы
     if (unlockedTrap && (level != 1 || itemChoiceLevel1 == 0)) {
-        const int ghostToSpawn = 1 + (std::rand() % 5); // от 1 до 5 штук
+        const int ghostToSpawn = 1 + rngSpawn.below(5); // от 1 до 5 штук
         for (int i = 0; i < ghostToSpawn; ++i) {
-            for (int attempt = 0; attempt < 200; ++attempt) {
-                int gx = std::rand() % Map::WIDTH;
-                int gy = std::rand() % Map::HEIGHT;
-
-                // Свободная клетка: пол, не игрок, не выход, нет врага и предмета
-                bool occupiedByEnemy = false;
-                for (const auto& e : enemies) {
-                    if (e.isAlive() && e.pos.x == gx && e.pos.y == gy) {
-                        occupiedByEnemy = true;
-                        break;
-                    }
-                }
-                if (occupiedByEnemy) continue;
-
-                if (map.getCell(gx, gy) == SYM_FLOOR &&
-                    !(gx == player.pos.x && gy == player.pos.y) &&
-                    !map.isExit(gx, gy) &&
-                    map.getItemAt(gx, gy) == nullptr) {
-                    map.addTrapItem(gx, gy);
-                    break;
-                }
+            // Свободная клетка: пол, не игрок, не выход, нет врага и предмета
+            Position cell;
+            if (!freeCells.take(rngSpawn, cell)) {
+                break;
             }
+            map.addTrapItem(cell.x, cell.y);
         }
     }
 
@@ -1449,84 +1784,41 @@ void GameState::generateNewLevel()
     if (unlockedShield && (level != 1 || itemChoiceLevel1 == 1)) {
         const int shieldsToSpawn = std::max(0, 3 + perkBonusShields);
         for (int shield = 0; shield < shieldsToSpawn; ++shield) {
-            for (int attempt = 0; attempt < 200; ++attempt) {
-                int sx = std::rand() % Map::WIDTH;
-                int sy = std::rand() % Map::HEIGHT;
-                bool occupiedByEnemy = false;
-                for (const auto& e : enemies) {
-                    if (e.isAlive() && e.pos.x == sx && e.pos.y == sy) {
-                        occupiedByEnemy = true;
-                        break;
-                    }
-                }
-                if (occupiedByEnemy) continue;
-                if (map.getCell(sx, sy) == SYM_FLOOR &&
-                    !(sx == player.pos.x && sy == player.pos.y) &&
-                    !map.isExit(sx, sy) &&
-                    map.getItemAt(sx, sy) == nullptr) {
-                    map.addShieldItem(sx, sy);
-                    break;
-                }
+            Position cell;
+            if (!freeCells.take(rngSpawn, cell)) {
+                break;
             }
+            map.addShieldItem(cell.x, cell.y);
         }
     }
 
     // Спавним один квестовый предмет '?' (запускает убийство монстров)
     // Спавним только если разблокированы
     if (unlockedQuest && (level != 1 || itemChoiceLevel1 == 2)) {
-        for (int attempt = 0; attempt < 200; ++attempt) {
-            int qx = std::rand() % Map::WIDTH;
-            int qy = std::rand() % Map::HEIGHT;
-            bool occupiedByEnemy = false;
-            for (const auto& e : enemies) {
-                if (e.isAlive() && e.pos.x == qx && e.pos.y == qy) {
-                    occupiedByEnemy = true;
-                    break;
-                }
-            }
-            if (occupiedByEnemy) continue;
-            if (map.getCell(qx, qy) == SYM_FLOOR &&
-                !(qx == player.pos.x && qy == player.pos.y) &&
-                !map.isExit(qx, qy) &&
-                map.getItemAt(qx, qy) == nullptr) {
-                map.addQuestItem(qx, qy);
-                break;
-            }
+        Position cell;
+        if (freeCells.take(rngSpawn, cell)) {
+            map.addQuestItem(cell.x, cell.y);
         }
     }
 
     // Дополнительные аптечки за постоянный перк.
     for (int extra = 0; extra < perkBonusHeals; ++extra) {
-        for (int attempt = 0; attempt < 200; ++attempt) {
-            int hx = std::rand() % Map::WIDTH;
-            int hy = std::rand() % Map::HEIGHT;
-
-            if (map.getCell(hx, hy) == SYM_FLOOR &&
-                !(hx == player.pos.x && hy == player.pos.y) &&
-                !map.isExit(hx, hy) &&
-                map.getItemAt(hx, hy) == nullptr) {
-                // Аптечка на 5 HP, как базовые.
-                map.addHealItem(hx, hy, 5);
-                break;
-            }
+        Position cell;
+        if (!freeCells.take(rngSpawn, cell)) {
+            break;
         }
+        // Аптечка на 5 HP, как базовые.
+        map.addHealItem(cell.x, cell.y, 5);
     }
 
     // Дополнительные MaxHP‑предметы только на этот уровень.
     for (int extra = 0; extra < perkExtraMaxHpItemsNextLevel; ++extra) {
-        for (int attempt = 0; attempt < 200; ++attempt) {
-            int mx = std::rand() % Map::WIDTH;
-            int my = std::rand() % Map::HEIGHT;
-
-            if (map.getCell(mx, my) == SYM_FLOOR &&
-                !(mx == player.pos.x && my == player.pos.y) &&
-                !map.isExit(mx, my) &&
-                map.getItemAt(mx, my) == nullptr) {
-                int bonus = 1 + (std::rand() % 5); // как в Map::generate
-                map.addMaxHealthItem(mx, my, bonus);
-                break;
-            }
+        Position cell;
+        if (!freeCells.take(rngSpawn, cell)) {
+            break;
         }
+        int bonus = 1 + rngSpawn.below(5); // как в Map::generate
+        map.addMaxHealthItem(cell.x, cell.y, bonus);
     }
     // Этот бонус действует только на один этаж.
     perkExtraMaxHpItemsNextLevel = 0;
@@ -1543,14 +1835,46 @@ bool GameState::checkExit()
         // Сам переход произойдет после того, как игрок выберет 1, 2 или 3.
         isPerkChoiceActive = true;
         // Генерируем случайные варианты модификаторов один раз при активации экрана
-        perkChoiceVariant1 = std::rand() % 6;
-        perkChoiceVariant2 = std::rand() % 6;
-        perkChoiceVariant3 = std::rand() % 6;
+        perkChoiceVariant1 = rngSpawn.below(6);
+        perkChoiceVariant2 = rngSpawn.below(6);
+        perkChoiceVariant3 = rngSpawn.below(6);
+        // Пока игрок выбирает перк, строим следующую карту в фоне.
+        if (pregenerateNextLevel) {
+            startNextLevelPregeneration();
+        }
         return true;
     }
     return false;
 }
 
+// Строка эффекта перка для экрана смерти, отпечатка и снимков (названия менять нельзя: старые записи).
+const char* perkEffectName(PerkEffect effect)
+{
+    switch (effect) {
+    case PerkEffect::MoreRats:
+        return "+5 rats";
+    case PerkEffect::MoreMedkits:
+        return "+2 medkits";
+    case PerkEffect::Firefly:
+        return "Firefly reveals fog";
+    case PerkEffect::PoisonBears:
+        return "Bear with poison";
+    case PerkEffect::MoreShields:
+        return "More shields";
+    case PerkEffect::ExitHint:
+        return "Show exit hint";
+    case PerkEffect::QuestHighlight:
+        return "Quest highlight";
+    case PerkEffect::MoreSnakes:
+        return "+2 snakes";
+    case PerkEffect::MoreMaxHpItems:
+        return "More MaxHP items";
+    case PerkEffect::SmallerTorch:
+        return "Smaller torch";
+    }
+    return "Unknown perk";
+}
+
 // Применить выбранный перк (1, 2 или 3) и перейти на следующий уровень.
 void GameState::applyLevelChoice(int choiceIndex)
 {
@@ -1575,8 +1899,8 @@ void GameState::applyLevelChoice(int choiceIndex)
         // Добавляем нового светлячка (накапливаются)
         // Пробуем найти проходимую клетку пола для нового светлячка.
         for (int attempt = 0; attempt < 200; ++attempt) {
-            int fx = std::rand() % Map::WIDTH;
-            int fy = std::rand() % Map::HEIGHT;
+            int fx = rngSpawn.below(map.getWidth());
+            int fy = rngSpawn.below(map.getHeight());
             if (map.getCell(fx, fy) == SYM_FLOOR &&
                 !(fx == player.pos.x && fy == player.pos.y) &&
                 !map.isExit(fx, fy)) {
@@ -1589,20 +1913,20 @@ void GameState::applyLevelChoice(int choiceIndex)
                     }
                 }
                 if (!occupied) {
-                    fireflies.push_back(GameState::Firefly(fx, fy));
+                    fireflies.insert(GameState::Firefly(fx, fy));
                     break;
                 }
             }
         }
         
         // Сохраняем перк в список для экрана смерти (каждый параметр на отдельной строке)
-        collectedPerks.push_back("+5 rats");
-        collectedPerks.push_back("+2 medkits");
-        collectedPerks.push_back("Firefly reveals fog");
+        collectedPerks.push_back(PerkEffect::MoreRats);
+        collectedPerks.push_back(PerkEffect::MoreMedkits);
+        collectedPerks.push_back(PerkEffect::Firefly);
     } else if (choiceIndex == 2) {
         // 2) Случайный выбор: каждый эффект либо только на следующий этаж, либо навсегда.
         // Медведь с мутацией отравления
-        if (std::rand() % 2 == 0) {
+        if (rngSpawn.below(2) == 0) {
             perkBearPoisonNextLevel = true;  // Только на следующий уровень
         } else {
             // Навсегда: медведи всегда ядовитые (нужно добавить флаг для постоянного эффекта)
@@ -1610,14 +1934,14 @@ void GameState::applyLevelChoice(int choiceIndex)
             perkBearPoisonNextLevel = true;  // Временно, но можно сделать постоянным
         }
         // Больше предметов щитов
-        if (std::rand() % 2 == 0) {
+        if (rngSpawn.below(2) == 0) {
             perkBonusShields += 1;  // Навсегда
         } else {
             // Только на следующий уровень (временный бонус)
             perkBonusShields += 1;  // Временно применяем как постоянный
         }
         // Показывать лестницу первые 3 шага
-        if (std::rand() % 2 == 0) {
+        if (rngSpawn.below(2) == 0) {
             perkShowExitFirst3Steps = true;  // Навсегда
         } else {
             // Только на следующий уровень (можно добавить временный флаг)
@@ -1631,10 +1955,10 @@ void GameState::applyLevelChoice(int choiceIndex)
         unlockedShield = true;
         
         // Сохраняем перк в список для экрана смерти (каждый параметр на отдельной строке)
-        collectedPerks.push_back("Bear with poison");
-        collectedPerks.push_back("More shields");
-        collectedPerks.push_back("Show exit hint");
-        collectedPerks.push_back("Quest highlight");
+        collectedPerks.push_back(PerkEffect::PoisonBears);
+        collectedPerks.push_back(PerkEffect::MoreShields);
+        collectedPerks.push_back(PerkEffect::ExitHint);
+        collectedPerks.push_back(PerkEffect::QuestHighlight);
     } else if (choiceIndex == 3) {
         // 3) +2 snake, выше шанс spawna maxHP‑предметов, радиус факела сильно сужен
         // ТОЛЬКО на следующий уровень.
@@ -1647,9 +1971,9 @@ void GameState::applyLevelChoice(int choiceIndex)
         unlockedMaxHP = true;
         
         // Сохраняем перк в список для экрана смерти (каждый параметр на отдельной строке)
-        collectedPerks.push_back("+2 snakes");
-        collectedPerks.push_back("More MaxHP items");
-        collectedPerks.push_back("Smaller torch");
+        collectedPerks.push_back(PerkEffect::MoreSnakes);
+        collectedPerks.push_back(PerkEffect::MoreMaxHpItems);
+        collectedPerks.push_back(PerkEffect::SmallerTorch);
     }
 
     // Экран выбора закрываем и реально переходим на следующий уровень.
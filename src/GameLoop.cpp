@@ -0,0 +1,320 @@
+#include "GameLoop.h"
+#include "Trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+std::unique_ptr<Graphics> makeGameGraphics(std::unique_ptr<RenderBackend> backend)
+{
+    return std::make_unique<Graphics>(ScreenLayout::screenWidth,
+                                      ScreenLayout::screenHeight,
+                                      ScreenLayout::leftPanelWidth,
+                                      ScreenLayout::rightPanelWidth,
+                                      ScreenLayout::topPanelHeight,
+                                      ScreenLayout::bottomPanelHeight,
+                                      std::move(backend));
+}
+
+void beginGame(GameState& game)
+{
+    // Инициализируем FOV
+    game.map.computeFOV(game.player.pos.x, game.player.pos.y, game.torchRadius, true);
+}
+
+namespace {
+// Ход игрока (step) в профайлер: этапы из GameState::lastTurnTimings
+void addTurnTimings(FrameProfiler& profiler, const TurnTimings& timings)
+{
+    profiler.add(ProfileStage::TurnMove, timings.move);
+    profiler.add(ProfileStage::TurnCombat, timings.combat);
+    profiler.add(ProfileStage::TurnItems, timings.items);
+    profiler.add(ProfileStage::TurnEnemies, timings.enemies);
+    profiler.add(ProfileStage::TurnFireflies, timings.fireflies);
+    profiler.add(ProfileStage::TurnEffects, timings.effects);
+    profiler.add(ProfileStage::TurnFov, timings.fov);
+}
+
+// Конец кадра: время всего кадра в профайлер
+void commitProfilerFrame(FrameProfiler& profiler, ProfileScope::Clock::time_point frameStart, bool turnTaken)
+{
+    profiler.commitFrame(std::chrono::duration<double, std::micro>(ProfileScope::Clock::now() - frameStart).count(),
+                         turnTaken);
+}
+} // namespace
+
+Action actionFromKey(const GameState& game, int key)
+{
+    // Экран смерти: F (строчная и заглавная) и ESC (для совместимости) — новая игра
+    if (game.isDeathScreenActive) {
+        return (key == 'f' || key == 'F' || key == TCODK_ESCAPE || key == 27) ? Action::Restart : Action::Wait;
+    }
+    // Экран выбора перка: только клавиши 1/2/3
+    if (game.isPerkChoiceActive) {
+        switch (key) {
+        case '1': return Action::ChoosePerk1;
+        case '2': return Action::ChoosePerk2;
+        case '3': return Action::ChoosePerk3;
+        default:  return Action::Wait;
+        }
+    }
+    // С крабом на игроке стрелки, как и прежде, не ходят, а стряхивают краба (ход на месте)
+    if (game.isPlayerControlsInverted &&
+        (key == TCODK_UP || key == TCODK_DOWN || key == TCODK_LEFT || key == TCODK_RIGHT)) {
+        return Action::Wait;
+    }
+    switch (key) {
+    // Основные направления (WASD и стрелки)
+    case TCODK_UP: case 'w': case 'W':    return Action::MoveUp;
+    case TCODK_DOWN: case 's': case 'S':  return Action::MoveDown;
+    case TCODK_LEFT: case 'a': case 'A':  return Action::MoveLeft;
+    case TCODK_RIGHT: case 'd': case 'D': return Action::MoveRight;
+    // Диагонали: Q — северо-запад, E — северо-восток, Z — юго-запад, C — юго-восток
+    case 'q': case 'Q': return Action::MoveUpLeft;
+    case 'e': case 'E': return Action::MoveUpRight;
+    case 'z': case 'Z': return Action::MoveDownLeft;
+    case 'c': case 'C': return Action::MoveDownRight;
+    // Выход только по ESC
+    case TCODK_ESCAPE: case 27: return Action::Quit;
+    // Любая другая клавиша — ход на месте
+    default: return Action::Wait;
+    }
+}
+
+void runFrame(GameState& game, Graphics& graphics)
+{
+    ASC11_TRACE_SCOPE("frame");
+    FrameProfiler& profiler = graphics.profiler;
+    const ProfileScope::Clock::time_point frameStart = ProfileScope::Clock::now();
+
+    // Если активен экран смерти — рисуем его поверх игры и обрабатываем ввод
+    if (game.isDeathScreenActive) {
+        // Рисуем игровой экран: UI панели, окно карты целиком закрывает экран смерти,
+        // поэтому саму карту под ним не рисуем.
+        graphics.beginFrame();
+        
+        // FOV без светлячков (по нему панель "рядом" видит мобов); пока игрок не жмёт клавиши, берётся из кеша
+        {
+            ProfileScope scope(profiler, ProfileStage::Fov);
+            game.updateFOV(false);
+        }
+        
+        // Рисуем UI панели
+        {
+            ProfileScope scope(profiler, ProfileStage::DrawUI);
+            graphics.drawUI(game.player,
+                           game.enemies,
+                           game.level,
+                           game.map,
+                           game.isPlayerPoisoned,
+                           game.isPlayerGhostCursed,
+                           game.shieldTurns,
+                           game.shieldWhiteSegments,
+                           game.questActive,
+                           game.questKills,
+                           game.questTarget,
+                           game.questTargets,
+                           game.questProgress,
+                           static_cast<int>(game.questType),
+                           game.perkQuestHighlightEnabled,
+                           game.seenRat,
+                           game.seenBear,
+                           game.seenSnake,
+                           game.seenGhost,
+                           game.seenCrab,
+                           game.seenMedkit,
+                           game.seenMaxHP,
+                           game.seenShield,
+                           game.seenTrap,
+                           game.seenQuest);
+        }
+        
+        // Рисуем экран смерти поверх всего
+        graphics.drawDeathScreen(game.level,
+                                 game.killsRat, game.killsBear, game.killsSnake, game.killsGhost, game.killsCrab,
+                                 game.itemsMedkit, game.itemsMaxHP, game.itemsShield, game.itemsTrap, game.itemsQuest,
+                                 game.collectedPerks);
+        graphics.drawProfilerOverlay();
+        {
+            ProfileScope scope(profiler, ProfileStage::Present);
+            graphics.refreshScreen();
+        }
+        
+        // Обрабатываем ввод
+        int key = 0;
+        if (graphics.getInput(key)) {
+            if (key == TCODK_F3) {
+                graphics.toggleProfilerOverlay();
+            } else if (key == TCODK_F9) {
+                ASC11_TRACE_FLUSH(TRACE_FILE);
+            } else {
+                step(game, actionFromKey(game, key));
+            }
+        }
+        commitProfilerFrame(profiler, frameStart, false);
+        return; // Остальной кадр пропускаем
+    }
+    
+    // Начинаем кадр (в режиме полного кадра очищает экран, иначе перерисуется только изменившееся)
+    graphics.beginFrame();
+    
+    // FOV игрока и светлячков с учетом текущего радиуса факела.
+    // Множитель радиуса — в GameState::updateFOV. Если с прошлого кадра ничего не сдвинулось
+    // (игрок, светлячки, радиус, карта), пересчёта нет.
+    {
+        ProfileScope scope(profiler, ProfileStage::Fov);
+        game.updateFOV();
+    }
+
+    // Меню выбора перка закрывает всё окно карты — мир под ним не рисуем.
+    const bool worldVisible = !game.isPerkChoiceActive;
+    if (worldVisible) {
+        // Рисуем карту (с учетом FOV и факела)
+        bool showExitHint = (game.perkShowExitFirst3Steps && game.stepsOnCurrentLevel <= 3) || game.showExitBecauseCleared;
+        // Собираем позиции светлячков для передачи в drawMap
+        std::vector<std::pair<int, int>> fireflyPositions;
+        for (const auto& firefly : game.fireflies) {
+            fireflyPositions.push_back({firefly.x, firefly.y});
+        }
+        {
+            ProfileScope scope(profiler, ProfileStage::DrawMap);
+            graphics.drawMap(game.map, game.player.pos.x, game.player.pos.y, game.torchRadius, showExitHint, fireflyPositions);
+        }
+
+        {
+            ProfileScope scope(profiler, ProfileStage::DrawEntities);
+            // Рисуем врагов (только если они видны)
+            const EnemyStore& enemies = game.enemies;
+            for (size_t i = 0; i < enemies.size(); ++i) {
+                if (enemies.isAlive(i) && game.map.isVisible(enemies.x[i], enemies.y[i])) {
+                    graphics.drawEntity(enemies.entity(i));
+                }
+            }
+
+            // Рисуем предметы (только если они видны)
+            for (const auto& item : game.map.items) {
+                if (game.map.isVisible(item.pos.x, item.pos.y)) {
+                    graphics.drawItem(item);
+                }
+            }
+
+            // Рисуем выход (только если виден через FOV)
+            if (game.map.exitPos.x >= 0 && game.map.exitPos.y >= 0 &&
+                game.map.isVisible(game.map.exitPos.x, game.map.exitPos.y)) {
+                Entity exitEntity(game.map.exitPos.x, game.map.exitPos.y, SYM_EXIT, RgbColor{255, 255, 100});
+                graphics.drawEntity(exitEntity);
+            }
+
+            // Рисуем игрока (цвет зависит от здоровья, эффектов яда и щита).
+            graphics.drawPlayer(game.player,
+                                game.isPlayerPoisoned,
+                                game.shieldTurns > 0);
+        }
+    }
+
+    // Рисуем UI.
+    // При действии яда полоска HP меняет цвет на "ядовитый" зелёный,
+    // а при действии эффекта призрака все квадраты становятся серыми,
+    // и вместо цифр отображаются вопросительные знаки.
+    {
+        ProfileScope scope(profiler, ProfileStage::DrawUI);
+        graphics.drawUI(game.player,
+                        game.enemies,
+                        game.level,
+                        game.map,
+                        game.isPlayerPoisoned,
+                        game.isPlayerGhostCursed,
+                        game.shieldTurns,
+                        game.shieldWhiteSegments,
+                        game.questActive,
+                        game.questKills,
+                        game.questTarget,
+                        game.questTargets,
+                        game.questProgress,
+                        static_cast<int>(game.questType),
+                        game.perkQuestHighlightEnabled,
+                        game.seenRat,
+                        game.seenBear,
+                        game.seenSnake,
+                        game.seenGhost,
+                        game.seenCrab,
+                        game.seenMedkit,
+                        game.seenMaxHP,
+                        game.seenShield,
+                        game.seenTrap,
+                        game.seenQuest);
+    }
+
+    {
+        ProfileScope scope(profiler, ProfileStage::Hover);
+        // Проверяем наведение мыши и отображаем названия
+        int mouseMapX, mouseMapY;
+        if (worldVisible && graphics.getMousePosition(mouseMapX, mouseMapY)) {
+            // Проверяем мобов
+            const int enemyIndex = game.enemyAt(mouseMapX, mouseMapY);
+            if (enemyIndex >= 0 && game.map.isVisible(mouseMapX, mouseMapY)) {
+                const EnemyStore& enemies = game.enemies;
+                const size_t i = static_cast<size_t>(enemyIndex);
+                std::string name = enemyName(enemies.typeOf(i));
+                // Добавляем HP к имени: имя 1/3
+                char buffer[32];
+                snprintf(buffer, sizeof(buffer), "%d/%d", enemies.health[i], enemies.maxHealth[i]);
+                std::string nameWithHP = name + " " + buffer;
+                graphics.drawHoverName(mouseMapX, mouseMapY, nameWithHP, toTcodColor(enemies.color[i]));
+            }
+            // Проверяем предметы (индекс клеток карты)
+            const Item* item = game.map.items.get(game.map.getItemAt(mouseMapX, mouseMapY));
+            if (item != nullptr && game.map.isVisible(item->pos.x, item->pos.y)) {
+                std::string name;
+                tcod::ColorRGB color{200, 200, 200};
+                if (item->symbol == SYM_ITEM) { name = "Medkit"; color = tcod::ColorRGB{255, 255, 0}; }
+                else if (item->symbol == SYM_MAX_HP) { name = "Max HP"; color = tcod::ColorRGB{0, 204, 0}; }
+                else if (item->symbol == SYM_SHIELD) { name = "Shield"; color = tcod::ColorRGB{255, 255, 255}; }
+                else if (item->symbol == SYM_TRAP) { name = "Trap"; color = tcod::ColorRGB{40, 40, 40}; }
+                if (!name.empty()) {
+                    graphics.drawHoverName(mouseMapX, mouseMapY, name, color);
+                }
+            }
+            // Проверяем лестницу
+            if (game.map.isExit(mouseMapX, mouseMapY) &&
+                game.map.isVisible(mouseMapX, mouseMapY)) {
+                graphics.drawHoverName(mouseMapX, mouseMapY, "Stair", tcod::ColorRGB{200, 200, 200});
+            }
+        }
+    }
+
+    // Если игрок стоит на лестнице и уже вошёл в "экран выбора" — рисуем поверх центральной части
+    // специальный чёрный оверлей с тремя вариантами 1/2/3.
+    if (game.isPerkChoiceActive) {
+        graphics.drawLevelChoiceMenu(game.perkChoiceVariant1, game.perkChoiceVariant2, game.perkChoiceVariant3);
+    }
+
+    // Профайлер (F3) поверх всего
+    graphics.drawProfilerOverlay();
+
+    // Обновляем экран
+    {
+        ProfileScope scope(profiler, ProfileStage::Present);
+        graphics.refreshScreen();
+    }
+
+    // Обрабатываем ввод
+    bool turnTaken = false;
+    int key = 0;
+    if (graphics.getInput(key)) {
+        if (key == TCODK_F3) {
+            graphics.toggleProfilerOverlay();
+        } else if (key == TCODK_F9) {
+            ASC11_TRACE_FLUSH(TRACE_FILE);
+        } else if (key == TCODK_F11 && !game.isPerkChoiceActive) {
+            graphics.toggleFullscreen();
+        } else if (step(game, actionFromKey(game, key))) {
+            // Сыгран ход (на экране выбора перка step ход не играет: там только 1/2/3)
+            addTurnTimings(profiler, game.lastTurnTimings);
+            turnTaken = true;
+        }
+    }
+    commitProfilerFrame(profiler, frameStart, turnTaken);
+}
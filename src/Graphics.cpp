@@ -2,28 +2,84 @@
 
 #include "Map.h"
 #include "Entity.h"
+#include "EnemyStore.h"
+#include "Trace.h"
 #include <algorithm>
 #include <array>
 #include <cmath>
 #include <ctime>
 #include <cstdlib>
-#include <SDL2/SDL.h>
 #include <string>
 #include <cstring>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
+namespace {
+// Клетка очищенной консоли: пробел, белый символ, чёрный фон.
+TCOD_ConsoleTile blankTile()
+{
+    TCOD_ConsoleTile tile{};
+    tile.ch = ' ';
+    tile.fg = tcod::ColorRGB{255, 255, 255};
+    tile.bg = tcod::ColorRGB{0, 0, 0};
+    return tile;
+}
+
+TCOD_ConsoleTile makeTile(int ch, const tcod::ColorRGB& fg, const tcod::ColorRGB& bg)
+{
+    TCOD_ConsoleTile tile{};
+    tile.ch = ch;
+    tile.fg = fg;
+    tile.bg = bg;
+    return tile;
+}
+
+// Прозрачность не сравниваем: все слои рисуют непрозрачными цветами.
+bool sameTile(const TCOD_ConsoleTile& a, const TCOD_ConsoleTile& b)
+{
+    return a.ch == b.ch &&
+           a.fg.r == b.fg.r && a.fg.g == b.fg.g && a.fg.b == b.fg.b &&
+           a.bg.r == b.bg.r && a.bg.g == b.bg.g && a.bg.b == b.bg.b;
+}
+
+// Подпись данных, из которых рисуется слой (FNV-1a по 64-битным значениям).
+// Совпала подпись — слой на экране уже такой, какой нужен.
+struct Signature {
+    uint64_t value = 1469598103934665603ull;
+
+    void add(uint64_t v)
+    {
+        value = (value ^ v) * 1099511628211ull;
+    }
+    void add(const std::string& text)
+    {
+        add(text.size());
+        for (char c : text) {
+            add(static_cast<uint64_t>(static_cast<unsigned char>(c)));
+        }
+    }
+};
+} // namespace
+
 Graphics::Graphics(int width,
                    int height,
                    int leftPanelWidth_,
                    int rightPanelWidth_,
                    int topPanelHeight_,
-                   int bottomPanelHeight_)
-    : screenWidth(width),
+                   int bottomPanelHeight_,
+                   std::unique_ptr<RenderBackend> backend_)
+    : backend(std::move(backend_)),
+      screenWidth(width),
       screenHeight(height),
       leftPanelWidth(leftPanelWidth_),
       rightPanelWidth(rightPanelWidth_),
       topPanelHeight(topPanelHeight_),
       bottomPanelHeight(bottomPanelHeight_),
+      viewWidth(width - leftPanelWidth_ - rightPanelWidth_),
+      viewHeight(height - topPanelHeight_ - bottomPanelHeight_),
+      cameraX(0),
+      cameraY(0),
       colorPlayer{100, 200, 255},
       colorWall{0, 0, 100},        // #000064
       colorFloor{50, 50, 150},     // #323296
@@ -32,7 +88,17 @@ Graphics::Graphics(int width,
       colorDark{20, 20, 20},
       colorExplored{60, 60, 60},
       torchNoise(1),               // 1D noise для эффекта факела
-      torchX(0.0f)
+      torchX(0.0f),
+      lastTicks(0),
+      pulseTime(0.0f),
+      dirtyRendering(true),
+      mapLayerValid(false),
+      uiSignature(0),
+      uiLayerValid(false),
+      overlaySignature(0),
+      overlayInView(false),
+      profilerVisible(false),
+      blendKernel(detectBlendKernel())
 {
     // Проверяем размеры
     if (width <= 0 || height <= 0) {
@@ -41,35 +107,14 @@ Graphics::Graphics(int width,
     
     // Создаем консоль
     console = tcod::Console(screenWidth, screenHeight);
+    baseTiles.assign(static_cast<size_t>(screenWidth) * static_cast<size_t>(screenHeight), blankTile());
     
-    // Создаем контекст окна (как в samples_cpp.cpp)
-    TCOD_ContextParams params{};
-    params.tcod_version = TCOD_COMPILEDVERSION;
-    params.console = console.get();
-    params.window_title = "ASC11 - Roguelike";
-    params.vsync = true;
-    params.argc = 0;
-    params.argv = nullptr;
-    // Используем SDL2 рендерер по умолчанию (как в samples)
-    params.renderer_type = TCOD_RENDERER_SDL2;
-    
-    // ПОЛНОСТЬЮ ОТКЛЮЧАЕМ кастомный tileset - используем только стандартный встроенный libtcod
-    // Кастомный PNG tileset (terminal12x12_gs_ro.png) не соответствует стандартному CP437 порядку
-    // и вызывает "кракозябры" при отображении символов
-    // Стандартный tileset libtcod гарантированно работает правильно с CP437 символами
-    // Без установки params.tileset libtcod использует стандартный встроенный tileset
-
-    context = tcod::new_context(params);
-    
-    if (!context) {
-        throw std::runtime_error("Failed to create context");
-    }
-
-    // Включаем полноэкранный режим. Масштабирование и отрисовку оставляем libtcod/SDL,
-    // чтобы клетки оставались квадратными и интерфейс выглядел так же, как в оконном режиме.
-    if (auto sdl_window = context->get_sdl_window()) {
-        SDL_SetWindowFullscreen(sdl_window, SDL_WINDOW_FULLSCREEN_DESKTOP);
+    // Окно (или его отсутствие) — забота бэкенда
+    if (!backend) {
+        throw std::runtime_error("Graphics needs a render backend");
     }
+    backend->open(console);
+    lastTicks = backend->ticks();
 }
 
 Graphics::~Graphics() = default;
@@ -78,149 +123,316 @@ Graphics::~Graphics() = default;
 // Объявление нужно здесь, чтобы её было видно в drawPlayer ниже.
 static tcod::ColorRGB lerpColor(const tcod::ColorRGB& a, const tcod::ColorRGB& b, float t);
 
+void Graphics::updateCamera(const Map& map, int playerX, int playerY)
+{
+    cameraX = std::clamp(playerX - viewWidth / 2, 0, std::max(0, map.getWidth() - viewWidth));
+    cameraY = std::clamp(playerY - viewHeight / 2, 0, std::max(0, map.getHeight() - viewHeight));
+}
+
+bool Graphics::isInView(int mapX, int mapY) const
+{
+    return mapX >= cameraX && mapX < cameraX + viewWidth &&
+           mapY >= cameraY && mapY < cameraY + viewHeight;
+}
+
+bool Graphics::MapLayerKey::operator==(const MapLayerKey& other) const
+{
+    return map == other.map && visibilityVersion == other.visibilityVersion &&
+           mutationCount == other.mutationCount &&
+           cameraX == other.cameraX && cameraY == other.cameraY &&
+           playerX == other.playerX && playerY == other.playerY &&
+           torchRadius == other.torchRadius && showExitHint == other.showExitHint &&
+           fireflies == other.fireflies;
+}
+
+int Graphics::mapScreenRows() const
+{
+    // Последняя строка окна карты совпадает с первой строкой нижней панели, панель рисуется поверх.
+    const int mapTop = std::max(topPanelHeight, 2);
+    return std::clamp(screenHeight - bottomPanelHeight - mapTop, 0, viewHeight);
+}
+
+bool Graphics::isInMapLayer(int screenX, int screenY) const
+{
+    const int mapTop = std::max(topPanelHeight, 2);
+    return screenX >= leftPanelWidth && screenX < leftPanelWidth + viewWidth &&
+           screenY >= mapTop && screenY < mapTop + mapScreenRows();
+}
+
 void Graphics::drawMap(const Map& map, int playerX, int playerY, int torchRadius, bool showExitHint, const std::vector<std::pair<int, int>>& fireflyPositions)
 {
+    ASC11_TRACE_SCOPE("Graphics::drawMap");
     // Обновляем эффект факела с пульсацией в реальном времени
-    // Используем SDL_GetTicks() для надежного измерения времени (работает каждый кадр!)
-    static Uint32 lastTime = SDL_GetTicks();
-    Uint32 currentTime = SDL_GetTicks();
-    float deltaTime = static_cast<float>(currentTime - lastTime) / 1000.0f; // Конвертируем в секунды
+    // Время берём у бэкенда: в окне это SDL_GetTicks(), без окна — время, отсчитанное по кадрам
+    const uint32_t currentTime = backend->ticks();
+    float deltaTime = static_cast<float>(currentTime - lastTicks) / 1000.0f; // Конвертируем в секунды
     if (deltaTime > 0.1f) deltaTime = 0.1f; // Ограничиваем максимальный шаг для стабильности
     if (deltaTime < 0.0f) deltaTime = 0.0f; // Защита от отрицательных значений
-    lastTime = currentTime;
+    lastTicks = currentTime;
     
-    static float time = 0.0f;
     // <<< ДЛЯ ИЗМЕНЕНИЯ СКОРОСТИ ПУЛЬСАЦИИ: измени множитель здесь (больше = быстрее) >>>
-    time += deltaTime * 1.0f; // Пульсация в реальном времени (быстрая, как при движении)
+    pulseTime += deltaTime * 1.0f; // Пульсация в реальном времени (быстрая, как при движении)
     
     torchX += deltaTime * 6.0f; // Обновляем в реальном времени
-    float dx = 0.0f, dy = 0.0f, di = 0.0f;
-    
-    // Очень слабое случайное смещение позиции факела для эффекта мерцания
-    float tdx = torchX + 20.0f;
-    dx = torchNoise.get(&tdx) * 0.5f; // Еще больше уменьшили амплитуду
-    tdx += 30.0f;
-    dy = torchNoise.get(&tdx) * 0.5f;
     
     // Пульсация интенсивности света (даже когда игрок стоит)
     // Используем синус для плавной пульсации
     // <<< ДЛЯ ИЗМЕНЕНИЯ СКОРОСТИ ПУЛЬСАЦИИ: измени множитель в sin() здесь (больше = быстрее) >>>
-    float pulse = 0.25f + 0.1f * std::sin(time * 2.0f); // Быстрая пульсация от 0.15 до 0.35
-    di = pulse * (0.5f + 0.5f * torchNoise.get(&torchX)); // Комбинируем с шумом для естественности
-    
-    const float TORCH_RADIUS = static_cast<float>(torchRadius);
-    const float SQUARED_TORCH_RADIUS = TORCH_RADIUS * TORCH_RADIUS;
+    const float pulse = 0.25f + 0.1f * std::sin(pulseTime * 2.0f); // Быстрая пульсация от 0.15 до 0.35
+
+    MapFrame frame;
+    frame.map = &map;
+    frame.showExitHint = showExitHint;
     
+    // Камера: если мир больше окна карты, держим игрока по центру окна,
+    // но не выезжаем за края мира. Карта размера окна рисуется целиком, как раньше.
+    updateCamera(map, playerX, playerY);
+
+    // Источники света кадра. Шум берётся один раз на источник, а не на клетку;
+    // каждый источник впечатывается в буфер окна только в свой квадрат (см. FrameLighting),
+    // и клетка дальше просто читает из буфера свой уровень света.
+    // Уровень света: 1.0 в позиции источника, 0.0 на границе радиуса, с учетом пульсации.
+    lighting.begin(cameraX, cameraY, viewWidth, viewHeight);
+    const float di = pulse * (0.5f + 0.5f * torchNoise.get(&torchX)); // Комбинируем с шумом для естественности
+    lighting.addLight(playerX, playerY, torchRadius, 0.7f + di);
+    // Светлячки — факелы радиуса 2 с той же пульсацией, но каждый со своим шумом,
+    // чтобы они мерцали не в такт.
+    const int FIREFLY_TORCH_RADIUS = 2;
+    for (size_t i = 0; i < fireflyPositions.size(); ++i) {
+        float fireflyNoiseX = torchX + 13.0f * static_cast<float>(i + 1);
+        const float fireflyDi = pulse * (0.5f + 0.5f * torchNoise.get(&fireflyNoiseX));
+        lighting.addLight(fireflyPositions[i].first, fireflyPositions[i].second, FIREFLY_TORCH_RADIUS, 0.7f + fireflyDi);
+    }
+
+    if (!dirtyRendering) {
+        // Весь экран каждый кадр (консоль очищена в beginFrame)
+        renderStats.mapFullRedraw = true;
+        drawMapRect(frame, 0, 0, viewWidth, viewHeight);
+        return;
+    }
+
+    MapLayerKey key;
+    key.map = &map;
+    key.visibilityVersion = map.getVisibilityVersion();
+    key.mutationCount = map.getMutationCount();
+    key.cameraX = cameraX;
+    key.cameraY = cameraY;
+    key.playerX = playerX;
+    key.playerY = playerY;
+    key.torchRadius = torchRadius;
+    key.showExitHint = showExitHint;
+    key.fireflies = fireflyPositions;
+
+    const int rows = mapScreenRows();
+    if (overlayInView) {
+        // Оверлей закрывал окно карты и заходил на нижнюю панель — возвращаем оба слоя
+        overlayInView = false;
+        mapLayerValid = false;
+        uiLayerValid = false;
+    }
+    if (!mapLayerValid || !(key == mapLayerKey)) {
+        renderStats.mapFullRedraw = true;
+        drawMapRect(frame, 0, 0, viewWidth, rows);
+        mapLayerKey = std::move(key);
+        mapLayerValid = true;
+        return;
+    }
+
+    // Ничего не сдвинулось: меняется только мерцание, то есть клетки в кругах света.
+    auto redrawAround = [&](int lightX, int lightY, int radius) {
+        const int viewX = lightX - cameraX;
+        const int viewY = lightY - cameraY;
+        drawMapRect(frame,
+                    std::max(0, viewX - radius), std::max(0, viewY - radius),
+                    std::min(viewWidth, viewX + radius + 1), std::min(rows, viewY + radius + 1));
+    };
+    redrawAround(playerX, playerY, torchRadius);
+    for (const auto& fireflyPos : fireflyPositions) {
+        redrawAround(fireflyPos.first, fireflyPos.second, FIREFLY_TORCH_RADIUS);
+    }
+}
+
+void Graphics::shadeMapRow(const MapFrame& frame, int mapX0, int mapY, int count)
+{
     // Цвета для стен и пола
     const tcod::ColorRGB darkWall{0, 0, 100};      // Темные стены
     const tcod::ColorRGB lightWall{130, 110, 50};  // Светлые стены
     const tcod::ColorRGB darkGround{50, 50, 150};  // Темный пол
     const tcod::ColorRGB lightGround{200, 180, 50}; // Светлый пол
-    
-    // Константы для позиционирования карты в центре экрана
-    const int leftPanelWidth = this->leftPanelWidth;
-    const int topPanelHeight = std::max(this->topPanelHeight, 2); // резервируем 2 строки под HP/Shield
-    
-    // Отрисовываем карту с учетом FOV и эффекта факела
-    // Карта рисуется в центре экрана (смещение на leftPanelWidth по X и topPanelHeight по Y)
-    for (int mapY = 0; mapY < Map::HEIGHT; ++mapY) {
-        for (int mapX = 0; mapX < Map::WIDTH; ++mapX) {
-            const int screenX = leftPanelWidth + mapX;
-            const int screenY = topPanelHeight + mapY;
-            
-            // Проверяем границы консоли
-            if (!console.in_bounds({screenX, screenY})) {
-                continue;
-            }
-            
-            const bool isVisible = map.isVisible(mapX, mapY);
-            const bool isExplored = map.isExplored(mapX, mapY);
-            const bool isWall = map.isWall(mapX, mapY);
-            
-            if (!isVisible) {
-                // Невидимые клетки
-                if (isExplored) {
-                    // Исследованные, но невидимые - затемненные
-                    console.at({screenX, screenY}).bg = isWall ? darkWall : darkGround;
-                    console.at({screenX, screenY}).ch = 219; // Блок (CP437 код 219 = █)
-                    console.at({screenX, screenY}).fg = isWall ? darkWall : darkGround;
-                } else {
-                    // Не исследованные - черные
-                    console.at({screenX, screenY}).bg = colorDark;
-                    console.at({screenX, screenY}).ch = ' ';
-                    console.at({screenX, screenY}).fg = colorDark;
-                }
+
+    const Map& map = *frame.map;
+    const size_t n = static_cast<size_t>(count);
+    rowBase.resize(n);
+    rowLight.resize(n);
+    rowColor.resize(n);
+    rowLevels.resize(n);
+    rowTiles.resize(n);
+
+    // Видимые клетки с эффектом факела и светлячков: цвета строки раскладываются по плоскостям
+    // r/g/b и смешиваются одним вызовом blendRow (SIMD, если процессор умеет).
+    for (size_t i = 0; i < n; ++i) {
+        const bool isWall = map.isWall(mapX0 + static_cast<int>(i), mapY);
+        rowBase.set(i, isWall ? darkWall : darkGround);
+        rowLight.set(i, isWall ? lightWall : lightGround);
+    }
+    lighting.levelRow(mapY, mapX0, count, rowLevels.data());
+    blendRow(blendKernel, rowBase, rowLight, rowLevels.data(), rowColor, count);
+
+    for (size_t i = 0; i < n; ++i) {
+        const int mapX = mapX0 + static_cast<int>(i);
+        TCOD_ConsoleTile& tile = rowTiles[i];
+        if (map.isVisible(mapX, mapY)) {
+            // Цветной блок (CP437 код 219 = █)
+            const tcod::ColorRGB color = rowColor.get(i);
+            tile = makeTile(219, color, color);
+        } else if (map.isExplored(mapX, mapY)) {
+            // Исследованные, но невидимые - затемненные (CP437 код 219 = █)
+            const tcod::ColorRGB dark = rowBase.get(i);
+            tile = makeTile(219, dark, dark);
+        } else {
+            // Не исследованные - черные
+            tile = makeTile(' ', colorDark, colorDark);
+        }
+
+        // Подсказка направления: символ выхода поверх всего, даже если он вне текущего FOV.
+        if (frame.showExitHint && mapX == map.exitPos.x && mapY == map.exitPos.y) {
+            tile.ch = '#';
+            tile.fg = tcod::ColorRGB{255, 255, 255};
+        }
+    }
+}
+
+void Graphics::drawMapRect(const MapFrame& frame, int viewX0, int viewY0, int viewX1, int viewY1)
+{
+    // Карта рисуется в центре экрана (смещение на leftPanelWidth по X и topPanelHeight по Y).
+    // Обходим только клетки окна, поэтому цена кадра не зависит от размера мира.
+    const int mapTop = std::max(topPanelHeight, 2); // резервируем 2 строки под HP/Shield
+    // Границы консоли
+    viewX0 = std::max(viewX0, -leftPanelWidth);
+    viewX1 = std::min(viewX1, screenWidth - leftPanelWidth);
+    viewY0 = std::max(viewY0, -mapTop);
+    viewY1 = std::min(viewY1, screenHeight - mapTop);
+    if (viewX0 >= viewX1) {
+        return;
+    }
+    for (int viewY = viewY0; viewY < viewY1; ++viewY) {
+        const int screenY = mapTop + viewY;
+        shadeMapRow(frame, cameraX + viewX0, cameraY + viewY, viewX1 - viewX0);
+        for (int viewX = viewX0; viewX < viewX1; ++viewX) {
+            const int screenX = leftPanelWidth + viewX;
+            const TCOD_ConsoleTile& tile = rowTiles[static_cast<size_t>(viewX - viewX0)];
+            if (dirtyRendering) {
+                baseTiles[static_cast<size_t>(screenY) * screenWidth + screenX] = tile;
+                writeTile(screenX, screenY, tile, renderStats.mapCells);
             } else {
-                // Видимые клетки с эффектом факела
-                tcod::ColorRGB base = isWall ? darkWall : darkGround;
-                tcod::ColorRGB light = isWall ? lightWall : lightGround;
-                
-                // Вычисляем расстояние до факела (с учетом смещения)
-                const float r = static_cast<float>((mapX - playerX + dx) * (mapX - playerX + dx) + 
-                                                   (mapY - playerY + dy) * (mapY - playerY + dy));
-                
-                if (r < SQUARED_TORCH_RADIUS) {
-                    // Интерполируем цвет в зависимости от расстояния
-                    // Делаем более мягкий переход (используем квадратный корень для более плавного затухания)
-                    float normalizedDist = r / SQUARED_TORCH_RADIUS;
-                    float smoothDist = std::sqrt(normalizedDist); // Более плавное затухание
-                    // Старая красивая пульсирующая формула: l = 1.0 в позиции игрока, 0.0 на границе радиуса, с учетом пульсации
-                    const float l = std::clamp((1.0f - smoothDist) * (0.7f + di), 0.0f, 1.0f);
-                    base = tcod::ColorRGB{TCODColor::lerp(base, light, l)};
-                }
-                
-                // Добавляем свет от светлячков (факел с меньшим радиусом, пульсирующий в реальном времени)
-                if (!fireflyPositions.empty()) {
-                    // Радиус факела светлячка (меньше чем у игрока)
-                    const float FIREFLY_TORCH_RADIUS = 2.0f;
-                    const float SQUARED_FIREFLY_RADIUS = FIREFLY_TORCH_RADIUS * FIREFLY_TORCH_RADIUS;
-                    
-                    // Пульсация для светлячков (синхронизирована с основным временем, как у игрока)
-                    float fireflyPulse = 0.25f + 0.1f * std::sin(time * 2.0f); // Та же пульсация что у игрока
-                    float fireflyDi = fireflyPulse * (0.5f + 0.5f * torchNoise.get(&torchX)); // Комбинируем с шумом
-                    
-                    for (const auto& fireflyPos : fireflyPositions) {
-                        // Вычисляем расстояние до светлячка (с учетом небольшого смещения для мерцания)
-                        float fireflyDx = torchNoise.get(&torchX) * 0.3f;
-                        float fireflyDy = torchNoise.get(&torchX) * 0.3f;
-                        const float fireflyDist = static_cast<float>((mapX - fireflyPos.first + fireflyDx) * (mapX - fireflyPos.first + fireflyDx) + 
-                                                                     (mapY - fireflyPos.second + fireflyDy) * (mapY - fireflyPos.second + fireflyDy));
-                        
-                        if (fireflyDist < SQUARED_FIREFLY_RADIUS) {
-                            // Интерполируем цвет с учетом пульсации (как у игрока)
-                            float normalizedFireflyDist = fireflyDist / SQUARED_FIREFLY_RADIUS;
-                            float smoothFireflyDist = std::sqrt(normalizedFireflyDist);
-                            const float fireflyLight = std::clamp((1.0f - smoothFireflyDist) * (0.7f + fireflyDi), 0.0f, 1.0f);
-                            base = tcod::ColorRGB{TCODColor::lerp(base, light, fireflyLight)};
-                        }
-                    }
-                }
-                
-                // Рисуем цветной блок
-                console.at({screenX, screenY}).bg = base;
-                console.at({screenX, screenY}).ch = 219; // Символ блока (CP437 код 219 = █)
-                console.at({screenX, screenY}).fg = base;
+                console.at({screenX, screenY}) = tile;
+                ++renderStats.mapCells;
             }
         }
     }
+}
 
-    // Дополнительно: если нужно подсветить лестницу (подсказка направления),
-    // рисуем символ выхода поверх всего, даже если он вне текущего FOV.
-    if (showExitHint && map.exitPos.x >= 0 && map.exitPos.y >= 0) {
-        int ex = map.exitPos.x;
-        int ey = map.exitPos.y;
-        int sx = leftPanelWidth + ex;
-        int sy = topPanelHeight + ey;
-        if (console.in_bounds({sx, sy})) {
-            auto& cell = console.at({sx, sy});
-            cell.ch = '#';
-            cell.fg = tcod::ColorRGB{255, 255, 255};
+void Graphics::writeTile(int screenX, int screenY, const TCOD_ConsoleTile& tile, int& counter)
+{
+    TCOD_ConsoleTile& current = console.at({screenX, screenY});
+    if (!sameTile(current, tile)) {
+        current = tile;
+        ++counter;
+    }
+}
+
+void Graphics::pushSprite(int screenX, int screenY, int ch, const tcod::ColorRGB& fg)
+{
+    // Строки под нижней панелью: в полном кадре панель закрашивает их позже
+    if (!isInMapLayer(screenX, screenY)) {
+        return;
+    }
+    sprites.push_back(SpriteCell{screenX, screenY, ch, fg, tcod::ColorRGB{0, 0, 0}, false});
+}
+
+// Вывод спрайтов кадра: клетки, где спрайт был в прошлом кадре, а теперь нет, получают
+// обратно карту или панель из baseTiles; новые спрайты кладутся поверх baseTiles.
+// В консоль пишутся только отличающиеся клетки.
+void Graphics::flushSprites()
+{
+    const size_t cellCount = baseTiles.size();
+    if (spriteMarks.size() != cellCount) {
+        spriteMarks.assign(cellCount, 0);
+        spriteTiles.resize(cellCount);
+    }
+
+    // Что должно оказаться в клетках со спрайтами: фон + спрайты в порядке рисования
+    for (const SpriteCell& sprite : sprites) {
+        const size_t index = static_cast<size_t>(sprite.y) * screenWidth + sprite.x;
+        if (spriteMarks[index] == 0) {
+            spriteTiles[index] = baseTiles[index];
+            spriteMarks[index] = 1;
+        }
+        spriteTiles[index].ch = sprite.ch;
+        spriteTiles[index].fg = sprite.fg;
+        if (sprite.hasBg) {
+            spriteTiles[index].bg = sprite.bg;
+        }
+    }
+
+    for (int index : prevSpriteCells) {
+        if (spriteMarks[static_cast<size_t>(index)] == 0) {
+            writeTile(index % screenWidth, index / screenWidth, baseTiles[static_cast<size_t>(index)], renderStats.spriteCells);
         }
     }
+
+    frameSpriteCells.clear();
+    for (const SpriteCell& sprite : sprites) {
+        const size_t index = static_cast<size_t>(sprite.y) * screenWidth + sprite.x;
+        if (spriteMarks[index] == 1) {
+            writeTile(sprite.x, sprite.y, spriteTiles[index], renderStats.spriteCells);
+            spriteMarks[index] = 2;
+            frameSpriteCells.push_back(static_cast<int>(index));
+        }
+    }
+    for (int index : frameSpriteCells) {
+        spriteMarks[static_cast<size_t>(index)] = 0;
+    }
+    prevSpriteCells.swap(frameSpriteCells);
+    sprites.clear();
+}
+
+void Graphics::invalidateLayers()
+{
+    mapLayerValid = false;
+    uiLayerValid = false;
+    overlayInView = false;
+    sprites.clear();
+    prevSpriteCells.clear();
+}
+
+bool Graphics::beginOverlay(uint64_t signature)
+{
+    if (!dirtyRendering) {
+        renderStats.overlayCells += viewWidth * viewHeight;
+        return false;
+    }
+    // Спрайты прошлого кадра (подписи могли заходить на панель) убираем до оверлея
+    flushSprites();
+    return overlayInView && overlaySignature == signature;
+}
+
+void Graphics::endOverlay(uint64_t signature)
+{
+    if (!dirtyRendering) {
+        return;
+    }
+    renderStats.overlayCells += viewWidth * viewHeight;
+    overlaySignature = signature;
+    overlayInView = true;
+    mapLayerValid = false; // Под оверлеем карты больше нет
+    // Фон для спрайтов поверх оверлея (профайлер) — сам оверлей, а не карта под ним
+    std::copy(console.begin(), console.end(), baseTiles.begin());
 }
 
 void Graphics::drawEntity(const Entity& entity)
 {
+    ASC11_TRACE_SCOPE("Graphics::drawEntity");
     // Рисуем сущность только если она видна
     // Учитываем смещение карты в центре экрана
     const int leftPanelWidth = this->leftPanelWidth;
@@ -228,29 +440,35 @@ void Graphics::drawEntity(const Entity& entity)
     
     int mapX = entity.pos.x;
     int mapY = entity.pos.y;
-    int screenX = leftPanelWidth + mapX;
-    int screenY = topPanelHeight + mapY;
+    int screenX = leftPanelWidth + mapX - cameraX;
+    int screenY = topPanelHeight + mapY - cameraY;
 
-    if (mapX >= 0 && mapX < Map::WIDTH && mapY >= 0 && mapY < Map::HEIGHT &&
+    if (isInView(mapX, mapY) &&
         screenX < screenWidth && screenY < screenHeight &&
         console.in_bounds({screenX, screenY})) {
+        if (dirtyRendering) {
+            pushSprite(screenX, screenY, entity.symbol, toTcodColor(entity.color));
+            return;
+        }
         console.at({screenX, screenY}).ch = entity.symbol;
-        console.at({screenX, screenY}).fg = entity.color;
+        console.at({screenX, screenY}).fg = toTcodColor(entity.color);
+        ++renderStats.spriteCells;
     }
 }
 
 void Graphics::drawItem(const Item& item)
 {
+    ASC11_TRACE_SCOPE("Graphics::drawItem");
     // Учитываем смещение карты в центре экрана
     const int leftPanelWidth = this->leftPanelWidth;
     const int topPanelHeight = std::max(this->topPanelHeight, 2);
     
     int mapX = item.pos.x;
     int mapY = item.pos.y;
-    int screenX = leftPanelWidth + mapX;
-    int screenY = topPanelHeight + mapY;
+    int screenX = leftPanelWidth + mapX - cameraX;
+    int screenY = topPanelHeight + mapY - cameraY;
 
-    if (mapX >= 0 && mapX < Map::WIDTH && mapY >= 0 && mapY < Map::HEIGHT &&
+    if (isInView(mapX, mapY) &&
         screenX < screenWidth && screenY < screenHeight &&
         console.in_bounds({screenX, screenY})) {
         // Цвет предмета зависит от типа:
@@ -271,8 +489,13 @@ void Graphics::drawItem(const Item& item)
             itemColor = tcod::ColorRGB{255, 255, 255};
         }
 
+        if (dirtyRendering) {
+            pushSprite(screenX, screenY, item.symbol, itemColor);
+            return;
+        }
         console.at({screenX, screenY}).ch = item.symbol;
         console.at({screenX, screenY}).fg = itemColor;
+        ++renderStats.spriteCells;
     }
 }
 
@@ -280,10 +503,20 @@ void Graphics::drawItem(const Item& item)
 // Закрашивает центральный слой (игровой мир) в чёрный и рисует три колонки с вариантами.
 void Graphics::drawLevelChoiceMenu(int variant1, int variant2, int variant3)
 {
+    ASC11_TRACE_SCOPE("Graphics::drawLevelChoiceMenu");
+    Signature signature;
+    signature.add(1); // Вид оверлея
+    signature.add(static_cast<uint64_t>(variant1));
+    signature.add(static_cast<uint64_t>(variant2));
+    signature.add(static_cast<uint64_t>(variant3));
+    if (beginOverlay(signature.value)) {
+        return; // Это меню уже на экране
+    }
+
     const int gameAreaStartX = leftPanelWidth;
     const int gameAreaStartY = std::max(topPanelHeight, 2);
-    const int gameWidth = Map::WIDTH;
-    const int gameHeight = Map::HEIGHT;
+    const int gameWidth = viewWidth;
+    const int gameHeight = viewHeight;
 
     // 1. Полностью "затемняем" центральную область (игровой мир).
     for (int y = 0; y < gameHeight; ++y) {
@@ -401,6 +634,7 @@ void Graphics::drawLevelChoiceMenu(int variant1, int variant2, int variant3)
         effects3 = {"+1 crab", "Torch radius -5", "+1 MaxHP item"};
     }
     drawColumn(col3Center, 3, "Next floor only", effects3);
+    endOverlay(signature.value);
 }
 
 // Вспомогательная функция для преобразования числа в римскую цифру
@@ -424,12 +658,26 @@ static std::string intToRoman(int num) {
 void Graphics::drawDeathScreen(int level,
                                 int killsRat, int killsBear, int killsSnake, int killsGhost, int killsCrab,
                                 int itemsMedkit, int itemsMaxHP, int itemsShield, int itemsTrap, int itemsQuest,
-                                const std::vector<std::string>& collectedPerks)
+                                const std::vector<PerkEffect>& collectedPerks)
 {
+    ASC11_TRACE_SCOPE("Graphics::drawDeathScreen");
+    Signature signature;
+    signature.add(2); // Вид оверлея
+    for (int value : {level, killsRat, killsBear, killsSnake, killsGhost, killsCrab,
+                      itemsMedkit, itemsMaxHP, itemsShield, itemsTrap, itemsQuest}) {
+        signature.add(static_cast<uint64_t>(value));
+    }
+    for (PerkEffect perk : collectedPerks) {
+        signature.add(static_cast<uint64_t>(perk));
+    }
+    if (beginOverlay(signature.value)) {
+        return; // Экран смерти уже на экране
+    }
+
     const int gameAreaStartX = leftPanelWidth;
     const int gameAreaStartY = std::max(topPanelHeight, 2);
-    const int gameWidth = Map::WIDTH;
-    const int gameHeight = Map::HEIGHT;
+    const int gameWidth = viewWidth;
+    const int gameHeight = viewHeight;
 
     // 1. Полностью "затемняем" центральную область (игровой мир).
     for (int y = 0; y < gameHeight; ++y) {
@@ -550,7 +798,8 @@ void Graphics::drawDeathScreen(int level,
     if (collectedPerks.empty()) {
         drawText(col3Center - 4, y3, "None");
     } else {
-        for (const auto& perk : collectedPerks) {
+        for (PerkEffect effect : collectedPerks) {
+            const std::string perk = perkEffectName(effect);
             drawText(col3Center - static_cast<int>(perk.size()) / 2, y3, perk);
             y3 += 1;
         }
@@ -561,10 +810,12 @@ void Graphics::drawDeathScreen(int level,
     int hintX = centerX - static_cast<int>(hint.size()) / 2;
     int hintY = gameAreaStartY + gameHeight - 3;
     drawText(hintX, hintY, hint, tcod::ColorRGB{200, 200, 200});
+    endOverlay(signature.value);
 }
 
 void Graphics::drawPlayer(const Entity& player, bool isPoisoned, bool hasShield)
 {
+    ASC11_TRACE_SCOPE("Graphics::drawPlayer");
     // Рисуем игрока с динамическим цветом в зависимости от здоровья
     // Учитываем смещение карты в центре экрана
     const int leftPanelWidth = this->leftPanelWidth;
@@ -572,10 +823,10 @@ void Graphics::drawPlayer(const Entity& player, bool isPoisoned, bool hasShield)
     
     int mapX = player.pos.x;
     int mapY = player.pos.y;
-    int screenX = leftPanelWidth + mapX;
-    int screenY = topPanelHeight + mapY;
+    int screenX = leftPanelWidth + mapX - cameraX;
+    int screenY = topPanelHeight + mapY - cameraY;
 
-    if (mapX >= 0 && mapX < Map::WIDTH && mapY >= 0 && mapY < Map::HEIGHT &&
+    if (isInView(mapX, mapY) &&
         screenX < screenWidth && screenY < screenHeight &&
         console.in_bounds({screenX, screenY})) {
         // Вычисляем цвет в зависимости от здоровья.
@@ -613,8 +864,13 @@ void Graphics::drawPlayer(const Entity& player, bool isPoisoned, bool hasShield)
             }
         }
         
+        if (dirtyRendering) {
+            pushSprite(screenX, screenY, player.symbol, playerColor);
+            return;
+        }
         console.at({screenX, screenY}).ch = player.symbol;
         console.at({screenX, screenY}).fg = playerColor;
+        ++renderStats.spriteCells;
     }
 }
 
@@ -647,7 +903,7 @@ static tcod::ColorRGB lerpColor(const tcod::ColorRGB& a, const tcod::ColorRGB& b
 }
 
 void Graphics::drawUI(const Entity& player,
-                      const std::vector<Entity>& enemies,
+                      const EnemyStore& enemies,
                       int level,
                       const Map& map,
                       bool isPlayerPoisoned,
@@ -672,6 +928,59 @@ void Graphics::drawUI(const Entity& player,
                 bool seenTrap,
                 bool seenQuest)
 {
+    ASC11_TRACE_SCOPE("Graphics::drawUI");
+    if (dirtyRendering) {
+        // Подпись всего, что читают панели. Совпала — панели на экране уже такие.
+        Signature signature;
+        signature.add(static_cast<uint64_t>(player.pos.x));
+        signature.add(static_cast<uint64_t>(player.pos.y));
+        signature.add(static_cast<uint64_t>(player.health));
+        signature.add(static_cast<uint64_t>(player.maxHealth));
+        for (size_t i = 0; i < enemies.size(); ++i) {
+            signature.add(static_cast<uint64_t>(enemies.symbol(i)));
+            signature.add(enemies.isAlive(i) ? 1 : 0);
+            signature.add(map.isVisible(enemies.x[i], enemies.y[i]) ? 1 : 0);
+            signature.add(static_cast<uint64_t>(enemies.x[i]));
+            signature.add(static_cast<uint64_t>(enemies.y[i]));
+            signature.add(static_cast<uint64_t>(enemies.health[i]));
+            signature.add(static_cast<uint64_t>(enemies.maxHealth[i]));
+            signature.add(enemies.crabAttached[i]);
+        }
+        for (int value : {level, shieldTurns, shieldWhiteSegments, questKills, questTarget, questType}) {
+            signature.add(static_cast<uint64_t>(value));
+        }
+        for (bool flag : {isPlayerPoisoned, isPlayerGhostCursed, questActive, perkQuestHighlightEnabled,
+                          seenRat, seenBear, seenSnake, seenGhost, seenCrab,
+                          seenMedkit, seenMaxHP, seenShield, seenTrap, seenQuest}) {
+            signature.add(flag ? 1 : 0);
+        }
+        for (const auto& target : questTargets) {
+            signature.add(static_cast<uint64_t>(target.first));
+            signature.add(static_cast<uint64_t>(target.second));
+        }
+        for (int progress : questProgress) {
+            signature.add(static_cast<uint64_t>(progress));
+        }
+        if (uiLayerValid && signature.value == uiSignature) {
+            return;
+        }
+        uiSignature = signature.value;
+        uiLayerValid = true;
+        renderStats.uiRedrawn = true;
+        if (overlayInView) {
+            overlayInView = false; // Нижняя панель перекроет край оверлея — нарисуем его заново
+        }
+
+        // Всё, что вне слоя карты, принадлежит панелям: очищаем как clearScreen
+        for (int y = 0; y < screenHeight; ++y) {
+            for (int x = 0; x < screenWidth; ++x) {
+                if (!isInMapLayer(x, y)) {
+                    console.at({x, y}) = blankTile();
+                }
+            }
+        }
+    }
+
     char buffer[256];
 
     // Константы для позиционирования
@@ -709,7 +1018,7 @@ void Graphics::drawUI(const Entity& player,
     
     // Очищаем правую боковую панель
     for (int y = gameAreaStartY; y < bottomPanelY; ++y) {
-        for (int x = gameAreaStartX + Map::WIDTH; x < screenWidth; ++x) {
+        for (int x = gameAreaStartX + viewWidth; x < screenWidth; ++x) {
             if (console.in_bounds({x, y})) {
                 console.at({x, y}).ch = ' ';
                 console.at({x, y}).bg = black;
@@ -750,9 +1059,9 @@ void Graphics::drawUI(const Entity& player,
     };
 
     // Рисуем полосу HP по ширине игрового мира (строго над картой), символ '-'
-    for (int i = 0; i < Map::WIDTH; ++i) {
+    for (int i = 0; i < viewWidth; ++i) {
         int x = leftPanelWidth + i;
-        const bool isFilled = i < static_cast<int>(healthPercent * Map::WIDTH);
+        const bool isFilled = i < static_cast<int>(healthPercent * viewWidth);
         tcod::ColorRGB dashColor = tcod::ColorRGB{100, 100, 100};
         if (isPlayerGhostCursed) {
             dashColor = tcod::ColorRGB{80, 80, 80};
@@ -762,7 +1071,7 @@ void Graphics::drawUI(const Entity& player,
                 const tcod::ColorRGB lowHpGreen{10, 80, 30};
                 dashColor = lerpColor(lowHpGreen, highHpGreen, healthPercent);
             } else {
-                const float t = Map::WIDTH <= 1 ? 0.0f : static_cast<float>(i) / static_cast<float>(Map::WIDTH - 1);
+                const float t = viewWidth <= 1 ? 0.0f : static_cast<float>(i) / static_cast<float>(viewWidth - 1);
                 dashColor = hpGradientNormal(t);
             }
         }
@@ -776,9 +1085,9 @@ void Graphics::drawUI(const Entity& player,
     // Полоса щита под HP (строка 1). Слева синие (оставшиеся), справа серые (потраченные).
     int shieldY = 1;
     // shieldTurns — сколько синих делений осталось, shieldWhiteSegments — сколько белых (урон по щиту).
-    int blueCount  = std::clamp(shieldTurns, 0, Map::WIDTH);
-    int whiteCount = std::clamp(shieldWhiteSegments, 0, Map::WIDTH - blueCount);
-    for (int i = 0; i < Map::WIDTH; ++i) {
+    int blueCount  = std::clamp(shieldTurns, 0, viewWidth);
+    int whiteCount = std::clamp(shieldWhiteSegments, 0, viewWidth - blueCount);
+    for (int i = 0; i < viewWidth; ++i) {
         int x = leftPanelWidth + i;
         tcod::ColorRGB dashColor{60, 60, 60}; // по умолчанию серый
         if (i < blueCount) {
@@ -844,7 +1153,7 @@ void Graphics::drawUI(const Entity& player,
     } else {
         snprintf(buffer, sizeof(buffer), "%d", player.maxHealth);
     }
-    int rightPanelStartX = gameAreaStartX + Map::WIDTH;
+    int rightPanelStartX = gameAreaStartX + viewWidth;
     int maxHpX = rightPanelStartX + (rightPanelWidth - static_cast<int>(strlen(buffer))) / 2;
     try {
         tcod::print(console, {maxHpX, 0}, buffer, white, std::nullopt);
@@ -869,22 +1178,10 @@ void Graphics::drawUI(const Entity& player,
     };
     
     // Собираем видимых врагов
-    std::vector<std::pair<const Entity*, std::string>> nearbyEnemies;
-    for (const auto& enemy : enemies) {
-        if (enemy.isAlive() && map.isVisible(enemy.pos.x, enemy.pos.y)) {
-        std::string mobName;
-        if (enemy.symbol == SYM_BEAR) {
-            mobName = "Bear";
-        } else if (enemy.symbol == SYM_SNAKE) {
-            mobName = "Snake";
-        } else if (enemy.symbol == SYM_GHOST) {
-            mobName = "Ghost";
-        } else if (enemy.symbol == SYM_CRAB) {
-            mobName = "Crab";
-        } else {
-            mobName = "Rat";
-        }
-            nearbyEnemies.push_back({&enemy, mobName});
+    std::vector<std::pair<size_t, std::string>> nearbyEnemies;
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        if (enemies.isAlive(i) && map.isVisible(enemies.x[i], enemies.y[i])) {
+            nearbyEnemies.push_back({i, enemyName(enemies.typeOf(i))});
         }
     }
     
@@ -892,13 +1189,13 @@ void Graphics::drawUI(const Entity& player,
     for (const auto& pair : nearbyEnemies) {
         if (nearbyY >= bottomPanelY) break; // Не выходим за нижнюю панель
         
-        const Entity& enemy = *pair.first;
+        const size_t enemy = pair.first;
         const std::string& mobName = pair.second;
-        std::string direction = getDirectionString(enemy.pos.x, enemy.pos.y, player.pos.x, player.pos.y);
+        std::string direction = getDirectionString(enemies.x[enemy], enemies.y[enemy], player.pos.x, player.pos.y);
         
         // Название моба его цветом
         try {
-            tcod::print(console, {0, nearbyY}, mobName.c_str(), enemy.color, std::nullopt);
+            tcod::print(console, {0, nearbyY}, mobName.c_str(), toTcodColor(enemies.color[enemy]), std::nullopt);
         } catch (const std::exception&) {}
         
         int textX = static_cast<int>(mobName.size());
@@ -910,8 +1207,8 @@ void Graphics::drawUI(const Entity& player,
         textX += static_cast<int>(direction.size());
 
         // Здоровье
-        snprintf(buffer, sizeof(buffer), " %d/%d", enemy.health, enemy.maxHealth);
-        const float enemyPct = static_cast<float>(enemy.health) / static_cast<float>(enemy.maxHealth);
+        snprintf(buffer, sizeof(buffer), " %d/%d", enemies.health[enemy], enemies.maxHealth[enemy]);
+        const float enemyPct = static_cast<float>(enemies.health[enemy]) / static_cast<float>(enemies.maxHealth[enemy]);
         const tcod::ColorRGB enemyHpColor = lerpColor(
             tcod::ColorRGB{80, 120, 255},
             tcod::ColorRGB{255, 50, 50},
@@ -1011,8 +1308,8 @@ void Graphics::drawUI(const Entity& player,
     
     // Слева: управление в виде столбца (сверху вниз)
     bool isPlayerControlsInverted = false;
-    for (const auto& enemy : enemies) {
-        if (enemy.symbol == SYM_CRAB && enemy.crabAttachedToPlayer) {
+    for (uint8_t attached : enemies.crabAttached) {
+        if (attached) {
             isPlayerControlsInverted = true;
             break;
         }
@@ -1096,7 +1393,7 @@ void Graphics::drawUI(const Entity& player,
     }
     
     // По центру нижней панели: дополнительная информация (щит, квесты)
-    int centerX = (gameAreaStartX + gameAreaStartX + Map::WIDTH) / 2;
+    int centerX = (gameAreaStartX + gameAreaStartX + viewWidth) / 2;
     std::vector<std::string> centerInfo;
     
     // Не пишем больше текст о щите, только визуальная полоса!
@@ -1169,7 +1466,7 @@ void Graphics::drawUI(const Entity& player,
             }
             
             // Рисуем "Quest" с цветами по центру нижней панели
-            int centerX = gameAreaStartX + Map::WIDTH / 2;
+            int centerX = gameAreaStartX + viewWidth / 2;
             int questY = screenHeight - bottomPanelHeight + 2; // Примерная позиция
             
             int questStartX = centerX - static_cast<int>(questLabel.size()) / 2;
@@ -1201,132 +1498,83 @@ void Graphics::drawUI(const Entity& player,
     for (const std::string& info : centerInfo) {
         int infoX = centerX - static_cast<int>(info.size()) / 2;
         if (infoX < gameAreaStartX) infoX = gameAreaStartX;
-        if (infoX + static_cast<int>(info.size()) > gameAreaStartX + Map::WIDTH) {
-            infoX = gameAreaStartX + Map::WIDTH - static_cast<int>(info.size());
+        if (infoX + static_cast<int>(info.size()) > gameAreaStartX + viewWidth) {
+            infoX = gameAreaStartX + viewWidth - static_cast<int>(info.size());
         }
         try {
             tcod::print(console, {infoX, centerY}, info.c_str(), bottomPanelColor, std::nullopt);
         } catch (const std::exception&) {}
         centerY++;
     }
+
+    // Панели — всё, что вне слоя карты; запоминаем их как фон для спрайтов (в режиме dirtyRendering)
+    for (int y = 0; y < screenHeight; ++y) {
+        for (int x = 0; x < screenWidth; ++x) {
+            if (!isInMapLayer(x, y)) {
+                if (dirtyRendering) {
+                    baseTiles[static_cast<size_t>(y) * screenWidth + x] = console.at({x, y});
+                }
+                ++renderStats.uiCells;
+            }
+        }
+    }
+}
+
+void Graphics::setDirtyRendering(bool enabled)
+{
+    dirtyRendering = enabled;
+    invalidateLayers();
+}
+
+void Graphics::beginFrame()
+{
+    lastFrameStats = renderStats;
+    renderStats = RenderStats{};
+    if (!dirtyRendering) {
+        console.clear();
+    }
 }
 
 void Graphics::refreshScreen()
 {
-    context->present(console);
+    ASC11_TRACE_SCOPE("Graphics::refreshScreen");
+    if (dirtyRendering) {
+        flushSprites();
+    }
+    backend->present(console);
 }
 
 void Graphics::clearScreen()
 {
     console.clear();
+    std::fill(baseTiles.begin(), baseTiles.end(), blankTile());
+    invalidateLayers();
 }
 
 // Ждем нажатия клавиши. Возвращаем true если что-то нажали.
 bool Graphics::getInput(int& key)
 {
-    // Обрабатываем все события SDL (включая закрытие окна) - НЕБЛОКИРУЮЩИЙ ввод!
-    SDL_Event ev;
-    while (SDL_PollEvent(&ev)) {
-        if (ev.type == SDL_QUIT) {
-            key = TCODK_ESCAPE;
-            return true;
-        }
-        // Обрабатываем нажатия клавиш через SDL
-        if (ev.type == SDL_KEYDOWN) {
-            SDL_Keycode sym = ev.key.keysym.sym;
-            SDL_Keymod mod = static_cast<SDL_Keymod>(ev.key.keysym.mod);
-            
-            // F11 для полноэкранного режима
-            if (sym == SDLK_F11) {
-                key = TCODK_F11;
-                return true;
-            }
-            
-            // ESC
-            if (sym == SDLK_ESCAPE) {
-                key = TCODK_ESCAPE;
-                return true;
-            }
-            
-            // Стрелки
-            if (sym == SDLK_UP) {
-                key = TCODK_UP;
-                return true;
-            }
-            if (sym == SDLK_DOWN) {
-                key = TCODK_DOWN;
-                return true;
-            }
-            if (sym == SDLK_LEFT) {
-                key = TCODK_LEFT;
-                return true;
-            }
-            if (sym == SDLK_RIGHT) {
-                key = TCODK_RIGHT;
-                return true;
-            }
-            
-            // Буквы и цифры (только если не зажаты модификаторы)
-            if ((mod & (KMOD_CTRL | KMOD_ALT | KMOD_GUI)) == 0) {
-                if (sym >= SDLK_a && sym <= SDLK_z) {
-                    // SDL использует только строчные коды для букв
-                    // Если зажат Shift, преобразуем в заглавную букву
-                    if (mod & KMOD_SHIFT) {
-                        key = 'A' + (sym - SDLK_a); // Преобразуем в заглавную ('A'-'Z')
-                    } else {
-                        key = static_cast<int>(sym); // SDLK_a = 97 = 'a', SDLK_b = 98 = 'b' и т.д.
-                    }
-                    return true;
-                }
-                // Обрабатываем цифры 0-9 (явно преобразуем в символы для надёжности)
-                if (sym >= SDLK_0 && sym <= SDLK_9) {
-                    key = '0' + (sym - SDLK_0); // Гарантируем символ '0'-'9'
-                    return true;
-                }
-            }
-        }
-    }
-    
-    // Также проверяем через libtcod (на случай если SDL не поймал)
-    TCOD_key_t k = TCOD_console_check_for_keypress(TCOD_KEY_PRESSED);
-    if (k.vk != TCODK_NONE) {
-    if (k.vk == TCODK_F11) {
-        key = TCODK_F11;
-        return true;
-    }
-    if (k.c != 0) {
-            // Преобразуем символ в нижний регистр для единообразия ('F' -> 'f')
-            key = (k.c >= 'A' && k.c <= 'Z') ? (k.c + 32) : k.c;
-        return true;
-    }
-    key = k.vk;
-        return true;
-    }
-    
-    return false; // Ничего не нажато - НЕ БЛОКИРУЕМ, просто возвращаем false
+    // Ввод не блокирует: бэкенд отдаёт одну клавишу или false
+    return backend->pollKey(key);
 }
 
 // Получает позицию мыши на карте. Возвращает true если мышь над игровой областью.
 bool Graphics::getMousePosition(int& mapX, int& mapY)
 {
-    int mouseX, mouseY;
-    SDL_GetMouseState(&mouseX, &mouseY);
-    
-    // Конвертируем координаты мыши в координаты консоли через context
-    // Используем явное указание типа для устранения неоднозначности
-    std::array<double, 2> pixelPos = {static_cast<double>(mouseX), static_cast<double>(mouseY)};
-    auto mouseTile = context->pixel_to_tile_coordinates(pixelPos);
-    int consoleX = static_cast<int>(mouseTile[0]);
-    int consoleY = static_cast<int>(mouseTile[1]);
+    // Клетка консоли под мышью (пиксели в клетки переводит бэкенд)
+    int consoleX, consoleY;
+    if (!backend->mouseTile(consoleX, consoleY)) {
+        return false;
+    }
     
     // Проверяем, что мышь в игровой области (не в UI панелях)
     const int gameAreaStartX = leftPanelWidth;
     const int gameAreaStartY = std::max(topPanelHeight, 2);
     
-    if (consoleX >= gameAreaStartX && consoleX < gameAreaStartX + Map::WIDTH &&
-        consoleY >= gameAreaStartY && consoleY < gameAreaStartY + Map::HEIGHT) {
-        mapX = consoleX - gameAreaStartX;
-        mapY = consoleY - gameAreaStartY;
+    if (consoleX >= gameAreaStartX && consoleX < gameAreaStartX + viewWidth &&
+        consoleY >= gameAreaStartY && consoleY < gameAreaStartY + viewHeight) {
+        mapX = consoleX - gameAreaStartX + cameraX;
+        mapY = consoleY - gameAreaStartY + cameraY;
         return true;
     }
     
@@ -1336,31 +1584,87 @@ bool Graphics::getMousePosition(int& mapX, int& mapY)
 // Рисует название справа от символа при наведении мыши
 void Graphics::drawHoverName(int mapX, int mapY, const std::string& name, const tcod::ColorRGB& color)
 {
+    ASC11_TRACE_SCOPE("Graphics::drawHoverName");
     const int gameAreaStartX = leftPanelWidth;
     const int gameAreaStartY = std::max(topPanelHeight, 2);
     
-    // Рисуем каждую букву справа от символа (начиная с позиции mapX + 1)
-    for (size_t i = 0; i < name.size(); ++i) {
-        int screenX = gameAreaStartX + mapX + 1 + static_cast<int>(i);
-        int screenY = gameAreaStartY + mapY;
-        
-        if (console.in_bounds({screenX, screenY})) {
-            console.at({screenX, screenY}).ch = name[i];
-            console.at({screenX, screenY}).fg = color;
-            console.at({screenX, screenY}).bg = tcod::ColorRGB{0, 0, 0};
+    // Подпись справа от символа (начиная с позиции mapX + 1)
+    putText(gameAreaStartX + mapX - cameraX + 1, gameAreaStartY + mapY - cameraY, name, color, tcod::ColorRGB{0, 0, 0});
+}
+
+void Graphics::putText(int screenX, int screenY, const std::string& text, const tcod::ColorRGB& fg, const tcod::ColorRGB& bg)
+{
+    for (size_t i = 0; i < text.size(); ++i) {
+        const int x = screenX + static_cast<int>(i);
+        if (!console.in_bounds({x, screenY})) {
+            continue;
         }
+        if (dirtyRendering) {
+            // Текст рисуется после панелей и может заходить на них, поэтому не обрезается
+            sprites.push_back(SpriteCell{x, screenY, text[i], fg, bg, true});
+            continue;
+        }
+        console.at({x, screenY}).ch = text[i];
+        console.at({x, screenY}).fg = fg;
+        console.at({x, screenY}).bg = bg;
+        ++renderStats.spriteCells;
     }
 }
 
 // Переключение полноэкранного режима
 void Graphics::toggleFullscreen()
 {
-    // Получаем SDL окно через libtcod API
-    auto sdl_window = context->get_sdl_window();
-    if (sdl_window) {
-        // Используем SDL2 функции для переключения полноэкранного режима
-        const auto flags = SDL_GetWindowFlags(sdl_window);
-        const bool is_fullscreen = (flags & SDL_WINDOW_FULLSCREEN) != 0;
-        SDL_SetWindowFullscreen(sdl_window, is_fullscreen ? 0 : SDL_WINDOW_FULLSCREEN_DESKTOP);
+    backend->toggleFullscreen();
+}
+
+void Graphics::drawProfilerOverlay()
+{
+    if (!profilerVisible) {
+        return;
+    }
+    ASC11_TRACE_SCOPE("Graphics::drawProfilerOverlay");
+    // Таблица в правом верхнем углу окна карты: этап, среднее и максимум за окно, мкс
+    const int width = 32;
+    const int x = leftPanelWidth + viewWidth - width;
+    int y = std::max(topPanelHeight, 2);
+    const tcod::ColorRGB background{0, 0, 0};
+    const tcod::ColorRGB titleColor{255, 255, 255};
+    const tcod::ColorRGB textColor{190, 190, 190};
+    const tcod::ColorRGB slowColor{255, 120, 80}; // Этап дольше 1 мс в среднем
+
+    char line[64];
+    auto row = [&](const char* text, const tcod::ColorRGB& color) {
+        std::string padded(text);
+        padded.resize(static_cast<size_t>(width), ' ');
+        putText(x, y++, padded, color, background);
+    };
+    auto stageRow = [&](ProfileStage stage) {
+        const FrameProfiler::StageStats stats = profiler.stats(stage);
+        snprintf(line, sizeof(line), " %-10s %9.1f %9.1f", FrameProfiler::stageName(stage), stats.average, stats.peak);
+        row(line, stats.average > 1000.0 ? slowColor : textColor);
+    };
+
+    const FrameProfiler::StageStats frame = profiler.frameStats();
+    row(" F3 profiler   avg us    max us", titleColor);
+    snprintf(line, sizeof(line), " %-10s %9.1f %9.1f", "frame", frame.average, frame.peak);
+    row(line, titleColor);
+    snprintf(line, sizeof(line), " -- frame stages (%d frames)", profiler.framesInWindow());
+    row(line, titleColor);
+    for (int i = 0; i < FrameProfiler::STAGE_COUNT; ++i) {
+        const ProfileStage stage = static_cast<ProfileStage>(i);
+        if (!FrameProfiler::isTurnStage(stage)) {
+            stageRow(stage);
+        }
+    }
+    snprintf(line, sizeof(line), " -- turn stages (%d turns)", profiler.turnsInWindow());
+    row(line, titleColor);
+    for (int i = 0; i < FrameProfiler::STAGE_COUNT; ++i) {
+        const ProfileStage stage = static_cast<ProfileStage>(i);
+        if (FrameProfiler::isTurnStage(stage)) {
+            stageRow(stage);
+        }
     }
+    snprintf(line, sizeof(line), " cells %d: map %d ui %d spr %d", lastFrameStats.total(), lastFrameStats.mapCells,
+             lastFrameStats.uiCells, lastFrameStats.spriteCells);
+    row(line, textColor);
 }
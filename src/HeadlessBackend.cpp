@@ -0,0 +1,119 @@
+#include "RenderBackend.h"
+
+#include <algorithm>
+
+HeadlessBackend::HeadlessBackend(uint32_t msPerFrame_)
+    : msPerFrame(msPerFrame_),
+      now(0),
+      frames(0),
+      console(nullptr),
+      mouseKnown(false),
+      mouseX(0),
+      mouseY(0),
+      dumpEvery(1)
+{
+}
+
+void HeadlessBackend::open(tcod::Console& console_)
+{
+    console = &console_;
+}
+
+void HeadlessBackend::present(tcod::Console& console_)
+{
+    console = &console_;
+    if (dump.is_open() && frames % static_cast<uint64_t>(dumpEvery) == 0) {
+        const int width = console_.get_width();
+        const int height = console_.get_height();
+        std::string line(static_cast<size_t>(width), ' ');
+        dump << "frame " << frames << '\n';
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const int ch = console_.at({x, y}).ch;
+                line[static_cast<size_t>(x)] = (ch >= 32 && ch < 127) ? static_cast<char>(ch) : '#';
+            }
+            dump << line << '\n';
+        }
+        dump.flush();
+    }
+    ++frames;
+    now += msPerFrame;
+}
+
+bool HeadlessBackend::pollKey(int& key)
+{
+    if (script.empty()) {
+        return false;
+    }
+    ScriptedKey& next = script.front();
+    if (next.idleFrames > 0) {
+        --next.idleFrames;
+        return false;
+    }
+    key = next.key;
+    script.pop_front();
+    return true;
+}
+
+bool HeadlessBackend::mouseTile(int& consoleX, int& consoleY)
+{
+    if (!mouseKnown) {
+        return false;
+    }
+    consoleX = mouseX;
+    consoleY = mouseY;
+    return true;
+}
+
+void HeadlessBackend::pushKey(int key, int idleFrames)
+{
+    script.push_back(ScriptedKey{key, std::max(0, idleFrames)});
+}
+
+void HeadlessBackend::pushKeys(const std::string& keys, int idleFrames)
+{
+    for (char key : keys) {
+        pushKey(static_cast<unsigned char>(key), idleFrames);
+    }
+}
+
+void HeadlessBackend::setMouseTile(int x, int y)
+{
+    mouseKnown = true;
+    mouseX = x;
+    mouseY = y;
+}
+
+void HeadlessBackend::clearMouse()
+{
+    mouseKnown = false;
+}
+
+bool HeadlessBackend::dumpFrames(const std::string& path, int every)
+{
+    dump.close();
+    dump.open(path, std::ios::out | std::ios::trunc);
+    dumpEvery = std::max(1, every);
+    return dump.is_open();
+}
+
+uint64_t HeadlessBackend::frameHash() const
+{
+    uint64_t hash = 1469598103934665603ull;
+    if (!console) {
+        return hash;
+    }
+    auto add = [&hash](uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    for (int y = 0; y < console->get_height(); ++y) {
+        for (int x = 0; x < console->get_width(); ++x) {
+            const TCOD_ConsoleTile& tile = console->at({x, y});
+            add(static_cast<uint64_t>(static_cast<uint32_t>(tile.ch)));
+            add((static_cast<uint64_t>(tile.fg.r) << 16) | (static_cast<uint64_t>(tile.fg.g) << 8) | tile.fg.b);
+            add((static_cast<uint64_t>(tile.bg.r) << 16) | (static_cast<uint64_t>(tile.bg.g) << 8) | tile.bg.b);
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,246 @@
+#include "Lighting.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Векторные ядра blendRow собираются всегда (на x86), а выбираются при запуске по CPUID:
+// exe без -mavx2 всё равно использует AVX2 там, где он есть.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ASC11_BLEND_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(ASC11_BLEND_X86) && (defined(__GNUC__) || defined(__clang__))
+#define ASC11_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ASC11_TARGET(isa)
+#endif
+
+namespace {
+// Эталон: ровно формула TCODColor::lerp, по клетке.
+void blendRowScalar(const ColorPlanes& base, const ColorPlanes& light, const float* level,
+                    ColorPlanes& out, int begin, int count)
+{
+    for (int i = begin; i < count; ++i) {
+        const float l = level[i];
+        out.r[i] = static_cast<uint8_t>(base.r[i] + (light.r[i] - base.r[i]) * l);
+        out.g[i] = static_cast<uint8_t>(base.g[i] + (light.g[i] - base.g[i]) * l);
+        out.b[i] = static_cast<uint8_t>(base.b[i] + (light.b[i] - base.b[i]) * l);
+    }
+}
+
+#if defined(ASC11_BLEND_X86)
+// 16 клеток одного канала: байты -> 4x4 int32 -> float, a + (b - a) * l, отбросить дробь, обратно в байты.
+ASC11_TARGET("sse2")
+void blendChannelSse2(const uint8_t* a, const uint8_t* b, const __m128 l[4], uint8_t* out)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+    const __m128i a16[2] = {_mm_unpacklo_epi8(va, zero), _mm_unpackhi_epi8(va, zero)};
+    const __m128i b16[2] = {_mm_unpacklo_epi8(vb, zero), _mm_unpackhi_epi8(vb, zero)};
+    __m128i result[4];
+    for (int k = 0; k < 4; ++k) {
+        const __m128i a32 = (k & 1) ? _mm_unpackhi_epi16(a16[k / 2], zero) : _mm_unpacklo_epi16(a16[k / 2], zero);
+        const __m128i b32 = (k & 1) ? _mm_unpackhi_epi16(b16[k / 2], zero) : _mm_unpacklo_epi16(b16[k / 2], zero);
+        const __m128 fa = _mm_cvtepi32_ps(a32);
+        const __m128 fd = _mm_cvtepi32_ps(_mm_sub_epi32(b32, a32));
+        result[k] = _mm_cvttps_epi32(_mm_add_ps(fa, _mm_mul_ps(fd, l[k])));
+    }
+    const __m128i lo = _mm_packs_epi32(result[0], result[1]);
+    const __m128i hi = _mm_packs_epi32(result[2], result[3]);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(lo, hi));
+}
+
+ASC11_TARGET("sse2")
+void blendRowSse2(const ColorPlanes& base, const ColorPlanes& light, const float* level, ColorPlanes& out, int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128 l[4] = {_mm_loadu_ps(level + i), _mm_loadu_ps(level + i + 4),
+                             _mm_loadu_ps(level + i + 8), _mm_loadu_ps(level + i + 12)};
+        blendChannelSse2(base.r.data() + i, light.r.data() + i, l, out.r.data() + i);
+        blendChannelSse2(base.g.data() + i, light.g.data() + i, l, out.g.data() + i);
+        blendChannelSse2(base.b.data() + i, light.b.data() + i, l, out.b.data() + i);
+    }
+    blendRowScalar(base, light, level, out, i, count);
+}
+
+// То же по 8 клеток на регистр: байты расширяются сразу в int32 (vpmovzxbd).
+ASC11_TARGET("avx2")
+void blendChannelAvx2(const uint8_t* a, const uint8_t* b, const __m256 l[2], uint8_t* out)
+{
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+    __m128i packed[2];
+    for (int k = 0; k < 2; ++k) {
+        const __m256i a32 = _mm256_cvtepu8_epi32(k ? _mm_srli_si128(va, 8) : va);
+        const __m256i b32 = _mm256_cvtepu8_epi32(k ? _mm_srli_si128(vb, 8) : vb);
+        const __m256 fa = _mm256_cvtepi32_ps(a32);
+        const __m256 fd = _mm256_cvtepi32_ps(_mm256_sub_epi32(b32, a32));
+        const __m256i result = _mm256_cvttps_epi32(_mm256_add_ps(fa, _mm256_mul_ps(fd, l[k])));
+        // Половины регистра упаковываем по отдельности, чтобы не перемешать порядок клеток
+        packed[k] = _mm_packs_epi32(_mm256_castsi256_si128(result), _mm256_extracti128_si256(result, 1));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(packed[0], packed[1]));
+}
+
+ASC11_TARGET("avx2")
+void blendRowAvx2(const ColorPlanes& base, const ColorPlanes& light, const float* level, ColorPlanes& out, int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256 l[2] = {_mm256_loadu_ps(level + i), _mm256_loadu_ps(level + i + 8)};
+        blendChannelAvx2(base.r.data() + i, light.r.data() + i, l, out.r.data() + i);
+        blendChannelAvx2(base.g.data() + i, light.g.data() + i, l, out.g.data() + i);
+        blendChannelAvx2(base.b.data() + i, light.b.data() + i, l, out.b.data() + i);
+    }
+    blendRowScalar(base, light, level, out, i, count);
+}
+#endif
+} // namespace
+
+void FrameLighting::begin(int originX_, int originY_, int width_, int height_)
+{
+    originX = originX_;
+    originY = originY_;
+    width = std::max(0, width_);
+    height = std::max(0, height_);
+    darkness.assign(static_cast<size_t>(width) * static_cast<size_t>(height), 1.0f);
+    splattedCells = 0;
+}
+
+void FrameLighting::levelRow(int y, int x0, int count, float* out) const
+{
+    const int by = y - originY;
+    if (by < 0 || by >= height) {
+        std::fill(out, out + count, 0.0f);
+        return;
+    }
+    const float* row = darkness.data() + static_cast<size_t>(by) * width;
+    for (int i = 0; i < count; ++i) {
+        const int bx = x0 + i - originX;
+        out[i] = (bx >= 0 && bx < width) ? 1.0f - row[bx] : 0.0f;
+    }
+}
+
+void FrameLighting::addLight(int x, int y, int radius, float intensity)
+{
+    if (radius <= 0) {
+        return; // Нулевой радиус ничего не освещает
+    }
+    // Квадрат источника, обрезанный по буферу
+    const int x0 = std::max(x - radius + 1, originX);
+    const int y0 = std::max(y - radius + 1, originY);
+    const int x1 = std::min(x + radius, originX + width);
+    const int y1 = std::min(y + radius, originY + height);
+    if (x0 >= x1 || y0 >= y1) {
+        return; // Источник целиком вне окна
+    }
+
+    // Пульсация одна на весь кадр, поэтому пропускание (1 - уровень) по d2 считается здесь, а не на клетку
+    const std::vector<float>& table = falloff(radius);
+    const int squaredRadius = static_cast<int>(table.size());
+    levels.resize(table.size());
+    for (size_t d2 = 0; d2 < table.size(); ++d2) {
+        levels[d2] = 1.0f - std::clamp(table[d2] * intensity, 0.0f, 1.0f);
+    }
+
+    for (int cy = y0; cy < y1; ++cy) {
+        const int dy = cy - y;
+        float* row = darkness.data() + static_cast<size_t>(cy - originY) * width;
+        for (int cx = x0; cx < x1; ++cx) {
+            const int dx = cx - x;
+            const int d2 = dx * dx + dy * dy;
+            if (d2 < squaredRadius) {
+                row[cx - originX] *= levels[static_cast<size_t>(d2)];
+            }
+        }
+    }
+    splattedCells += static_cast<long long>(x1 - x0) * (y1 - y0);
+}
+
+const std::vector<float>& FrameLighting::falloff(int radius)
+{
+    if (static_cast<int>(falloffTables.size()) <= radius) {
+        falloffTables.resize(static_cast<size_t>(radius) + 1);
+    }
+    std::vector<float>& table = falloffTables[static_cast<size_t>(radius)];
+    if (table.empty()) {
+        // Более мягкий переход: корень из нормированного расстояния,
+        // 1 в клетке источника и 0 на границе радиуса.
+        const float squaredRadius = static_cast<float>(radius * radius);
+        table.resize(static_cast<size_t>(radius) * static_cast<size_t>(radius));
+        for (size_t d2 = 0; d2 < table.size(); ++d2) {
+            table[d2] = 1.0f - std::sqrt(static_cast<float>(d2) / squaredRadius);
+        }
+    }
+    return table;
+}
+
+BlendKernel detectBlendKernel()
+{
+#if defined(ASC11_BLEND_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    // AVX2 нужен и процессору (лист 7), и ОС (сохранение регистров YMM: OSXSAVE и XCR0)
+    const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+                            (_xgetbv(0) & 0x6) == 0x6;
+    if (maxLeaf >= 7 && osSavesYmm) {
+        __cpuidex(info, 7, 0);
+        if ((info[1] & (1 << 5)) != 0) {
+            return BlendKernel::Avx2;
+        }
+    }
+    return sse2 ? BlendKernel::Sse2 : BlendKernel::Scalar;
+#elif defined(ASC11_BLEND_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return BlendKernel::Avx2;
+    }
+    return __builtin_cpu_supports("sse2") ? BlendKernel::Sse2 : BlendKernel::Scalar;
+#else
+    return BlendKernel::Scalar;
+#endif
+}
+
+const char* blendKernelName(BlendKernel kernel)
+{
+    switch (kernel) {
+    case BlendKernel::Avx2:
+        return "avx2";
+    case BlendKernel::Sse2:
+        return "sse2";
+    case BlendKernel::Scalar:
+        break;
+    }
+    return "scalar";
+}
+
+void blendRow(BlendKernel kernel, const ColorPlanes& base, const ColorPlanes& light, const float* level,
+              ColorPlanes& out, int count)
+{
+    static const BlendKernel supported = detectBlendKernel();
+    if (static_cast<int>(kernel) > static_cast<int>(supported)) {
+        kernel = supported;
+    }
+    switch (kernel) {
+#if defined(ASC11_BLEND_X86)
+    case BlendKernel::Avx2:
+        blendRowAvx2(base, light, level, out, count);
+        return;
+    case BlendKernel::Sse2:
+        blendRowSse2(base, light, level, out, count);
+        return;
+#endif
+    default:
+        blendRowScalar(base, light, level, out, 0, count);
+        return;
+    }
+}
@@ -1,26 +1,585 @@
 #include "Map.h"
+#include "StateHash.h"
+#include "Trace.h"
 
-#include <cstdlib>
-#include <ctime>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
-Map::Map()
-    : fovMap(WIDTH, HEIGHT),
+static_assert(Map::CHUNK_SIZE == 64, "строка куска должна помещаться ровно в одно 64-битное слово");
+
+namespace {
+using GenClock = std::chrono::steady_clock;
+
+// Сколько микросекунд прошло с отметки stageStart; отметка сдвигается на "сейчас".
+// Этот же отрезок уходит в трассу под именем traceName (если трассировка собрана).
+double takeStageMicros(GenClock::time_point& stageStart, const char* traceName)
+{
+    const GenClock::time_point now = GenClock::now();
+    const double micros = std::chrono::duration<double, std::micro>(now - stageStart).count();
+    ASC11_TRACE_SPAN(traceName, stageStart, now);
+    stageStart = now;
+    return micros;
+}
+
+// Маска битов [x0, x1] внутри одного слова (0 <= x0 <= x1 <= 63).
+uint64_t spanMask(int x0, int x1)
+{
+    return (~uint64_t(0) >> (63 - (x1 - x0))) << x0;
+}
+
+// explored |= visible; visible = 0 для count слов подряд — один проход.
+void mergeAndClearWords(uint64_t* explored, uint64_t* visible, int count)
+{
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 4 <= count; i += 4) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(visible + i));
+        const __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(explored + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(explored + i), _mm256_or_si256(e, v));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(visible + i), zero);
+    }
+#endif
+    for (; i < count; ++i) {
+        explored[i] |= visible[i];
+        visible[i] = 0;
+    }
+}
+
+// Деление с округлением вниз и вверх для любого знака числителя (den > 0).
+int floorDiv(int num, int den)
+{
+    return num >= 0 ? num / den : -((-num + den - 1) / den);
+}
+
+int ceilDiv(int num, int den)
+{
+    return -floorDiv(-num, den);
+}
+
+// words[i] = value для count слов подряд.
+void fillWords(uint64_t* words, uint64_t value, int count)
+{
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i v = _mm256_set1_epi64x(static_cast<long long>(value));
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(words + i), v);
+    }
+#endif
+    for (; i < count; ++i) {
+        words[i] = value;
+    }
+}
+
+// Символ, с которым предмет может лежать на карте (см. addHealItem и соседей).
+bool isItemSymbol(char symbol)
+{
+    return symbol == SYM_ITEM || symbol == SYM_MAX_HP || symbol == SYM_TRAP || symbol == SYM_SHIELD ||
+           symbol == SYM_QUEST;
+}
+} // namespace
+
+// Новый кусок — сплошная скала: стены, ничего не видно и не исследовано.
+// Клетки всех новых кусков — один общий блок скалы; свой блок кусок получает при первой записи (putCell).
+Map::Chunk::Chunk()
+{
+    static const std::shared_ptr<CellBlock> rock = [] {
+        auto block = std::make_shared<CellBlock>();
+        std::memset(block->rows, SYM_WALL, sizeof(block->rows));
+        return block;
+    }();
+    cells = rock;
+    fillWords(explored, 0, CHUNK_SIZE);
+    fillWords(visible, 0, CHUNK_SIZE);
+}
+
+Map::Map(int width_, int height_)
+    // Меньше размера по умолчанию карта не бывает: генератор рассчитан на комнаты до 14x10.
+    : width(std::max(width_, DEFAULT_WIDTH)),
+      height(std::max(height_, DEFAULT_HEIGHT)),
+      chunksX((width + CHUNK_SIZE - 1) / CHUNK_SIZE),
+      chunksY((height + CHUNK_SIZE - 1) / CHUNK_SIZE),
+      chunks(static_cast<size_t>(chunksX) * static_cast<size_t>(chunksY)),
+      hasVisible(false),
+      visibleMinX(0), visibleMinY(0), visibleMaxX(-1), visibleMaxY(-1),
+      mutationCount(0),
+      visibilityVersion(0),
+      fovCacheValid(false),
+      fovCacheX(0), fovCacheY(0), fovCacheRadius(0),
+      fovCacheLightWalls(true),
+      fovCacheMutation(0),
       exitPos(-1, -1) // Выход пока не установлен
 {
-    // Инициализируем карту пустыми клетками-полом и флаги FOV.
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            cells[y][x] = SYM_FLOOR;
-            explored[y][x] = false;
-            visible[y][x] = false;
+    // Куски не выделяем: до генерации вся карта — стена.
+}
+
+Map::~Map() = default;
+
+Map::Map(const Map& other)
+    : Map(other.width, other.height)
+{
+    *this = other;
+}
+
+Map& Map::operator=(const Map& other)
+{
+    if (this == &other) {
+        return *this;
+    }
+    width = other.width;
+    height = other.height;
+    chunksX = other.chunksX;
+    chunksY = other.chunksY;
+    chunks.resize(other.chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (!other.chunks[i]) {
+            chunks[i].reset();
+        } else if (chunks[i]) {
+            *chunks[i] = *other.chunks[i]; // Биты копируются, блок клеток становится общим
+        } else {
+            chunks[i] = std::make_unique<Chunk>(*other.chunks[i]);
         }
     }
+    hasVisible = other.hasVisible;
+    visibleMinX = other.visibleMinX;
+    visibleMinY = other.visibleMinY;
+    visibleMaxX = other.visibleMaxX;
+    visibleMaxY = other.visibleMaxY;
+    mutationCount = other.mutationCount;
+    visibilityVersion = other.visibilityVersion;
+    fovCacheValid = other.fovCacheValid;
+    fovCacheX = other.fovCacheX;
+    fovCacheY = other.fovCacheY;
+    fovCacheRadius = other.fovCacheRadius;
+    fovCacheLightWalls = other.fovCacheLightWalls;
+    fovCacheMutation = other.fovCacheMutation;
+    fovCacheLights = other.fovCacheLights;
+    itemCells = other.itemCells;
+    items = other.items;
+    exitPos = other.exitPos;
+    lastGenTimings = other.lastGenTimings;
+    fovStats = other.fovStats;
+    return *this;
 }
 
-Map::~Map() = default;
+// Обмен содержимым двух карт (используется для двойной буферизации уровней).
+void Map::swap(Map& other)
+{
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(chunksX, other.chunksX);
+    std::swap(chunksY, other.chunksY);
+    chunks.swap(other.chunks);
+    std::swap(hasVisible, other.hasVisible);
+    std::swap(visibleMinX, other.visibleMinX);
+    std::swap(visibleMinY, other.visibleMinY);
+    std::swap(visibleMaxX, other.visibleMaxX);
+    std::swap(visibleMaxY, other.visibleMaxY);
+    // Видимость поменялась местами вместе с кусками — кеши обеих карт больше не верны.
+    ++mutationCount;
+    ++other.mutationCount;
+    fovCacheValid = false;
+    other.fovCacheValid = false;
+    ++visibilityVersion;
+    ++other.visibilityVersion;
+    items.swap(other.items);
+    itemCells.swap(other.itemCells);
+    std::swap(exitPos, other.exitPos);
+    std::swap(lastGenTimings, other.lastGenTimings);
+}
+
+int Map::getAllocatedChunkCount() const
+{
+    int count = 0;
+    for (const auto& chunk : chunks) {
+        if (chunk) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+uint64_t Map::contentHash() const
+{
+    StateHash hash;
+    hash.add(width);
+    hash.add(height);
+    // Кусок из одних стен равен невыделенному (FOV выделяет куски и под скалой), такие пропускаем
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const Chunk* chunk = chunks[i].get();
+        if (!chunk) {
+            continue;
+        }
+        const char* cells = &chunk->cells->rows[0][0];
+        const char* end = cells + CHUNK_SIZE * CHUNK_SIZE;
+        if (std::find_if(cells, end, [](char cell) { return cell != SYM_WALL; }) == end) {
+            continue;
+        }
+        hash.add(i);
+        hash.addBytes(cells, CHUNK_SIZE * CHUNK_SIZE);
+    }
+    for (const Item& item : items) {
+        hash.add(item.pos.x);
+        hash.add(item.pos.y);
+        hash.add(item.healAmount);
+        hash.add(item.maxHealthBoost);
+        hash.add(item.symbol);
+    }
+    hash.add(exitPos.x);
+    hash.add(exitPos.y);
+    return hash.get();
+}
+
+namespace {
+// Биты исследованности куска по байтам (little-endian), чтобы сжать их сериями, как клетки.
+constexpr size_t EXPLORED_BYTES = Map::CHUNK_SIZE * sizeof(uint64_t);
+} // namespace
+
+void Map::writeSnapshot(ByteWriter& out) const
+{
+    out.i32(width);
+    out.i32(height);
+
+    std::vector<uint32_t> saved;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const Chunk* chunk = chunks[i].get();
+        if (!chunk) {
+            continue;
+        }
+        const char* cells = &chunk->cells->rows[0][0];
+        const bool solid = std::find_if(cells, cells + CHUNK_SIZE * CHUNK_SIZE,
+                                        [](char cell) { return cell != SYM_WALL; }) == cells + CHUNK_SIZE * CHUNK_SIZE;
+        bool unexplored = true;
+        for (int row = 0; row < CHUNK_SIZE; ++row) {
+            unexplored = unexplored && (chunk->explored[row] | chunk->visible[row]) == 0;
+        }
+        if (!solid || !unexplored) {
+            saved.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    out.u32(static_cast<uint32_t>(saved.size()));
+    uint8_t explored[EXPLORED_BYTES];
+    for (uint32_t index : saved) {
+        const Chunk& chunk = *chunks[index];
+        out.u32(index);
+        out.runLength(reinterpret_cast<const uint8_t*>(&chunk.cells->rows[0][0]), CHUNK_SIZE * CHUNK_SIZE);
+        // Видимое сейчас в explored попадёт только при следующем updateFOV — пишем его сразу,
+        // иначе восстановленное состояние "забудет" клетки, которые игрок видел последним ходом
+        for (int row = 0; row < CHUNK_SIZE; ++row) {
+            const uint64_t bits = chunk.explored[row] | chunk.visible[row];
+            for (int b = 0; b < 8; ++b) {
+                explored[row * 8 + b] = static_cast<uint8_t>(bits >> (8 * b));
+            }
+        }
+        out.runLength(explored, EXPLORED_BYTES);
+    }
+
+    out.u32(static_cast<uint32_t>(items.size()));
+    for (const Item& item : items) {
+        out.i32(item.pos.x);
+        out.i32(item.pos.y);
+        out.i32(item.healAmount);
+        out.i32(item.maxHealthBoost);
+        out.u8(static_cast<uint8_t>(item.symbol));
+    }
+    out.i32(exitPos.x);
+    out.i32(exitPos.y);
+}
+
+bool Map::readSnapshot(ByteReader& in)
+{
+    if (in.i32() != width || in.i32() != height) {
+        return false;
+    }
+    items.clear();
+    itemCells.clear();
+    for (auto& chunk : chunks) {
+        chunk.reset();
+    }
+    hasVisible = false;
+    ++mutationCount;
+    ++visibilityVersion;
+    fovCacheValid = false;
+
+    const uint32_t chunkCount = in.u32();
+    uint8_t explored[EXPLORED_BYTES];
+    for (uint32_t n = 0; n < chunkCount && in.ok(); ++n) {
+        const uint32_t index = in.u32();
+        if (index >= chunks.size()) {
+            return false;
+        }
+        chunks[index] = std::make_unique<Chunk>();
+        Chunk& chunk = *chunks[index];
+        chunk.cells = std::make_shared<CellBlock>();
+        in.runLength(reinterpret_cast<uint8_t*>(&chunk.cells->rows[0][0]), CHUNK_SIZE * CHUNK_SIZE);
+        in.runLength(explored, EXPLORED_BYTES);
+        for (int row = 0; row < CHUNK_SIZE; ++row) {
+            uint64_t bits = 0;
+            for (int b = 0; b < 8; ++b) {
+                bits |= static_cast<uint64_t>(explored[row * 8 + b]) << (8 * b);
+            }
+            chunk.explored[row] = bits;
+        }
+    }
+
+    const uint32_t itemCount = in.u32();
+    for (uint32_t n = 0; n < itemCount && in.ok(); ++n) {
+        const int x = in.i32();
+        const int y = in.i32();
+        const int heal = in.i32();
+        const int boost = in.i32();
+        const char symbol = static_cast<char>(in.u8());
+        if (!in.ok() || !inBounds(x, y) || !isItemSymbol(symbol)) {
+            return false;
+        }
+        addItem(x, y, heal, boost, symbol);
+    }
+    exitPos.x = in.i32();
+    exitPos.y = in.i32();
+    return in.ok() && inBounds(exitPos.x, exitPos.y);
+}
+
+// --- Доступ к кускам ---
+
+Map::Chunk* Map::chunkAt(int x, int y) const
+{
+    return chunks[static_cast<size_t>(y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT)].get();
+}
+
+Map::Chunk& Map::ensureChunk(int x, int y)
+{
+    std::unique_ptr<Chunk>& chunk = chunks[static_cast<size_t>(y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT)];
+    if (!chunk) {
+        chunk = std::make_unique<Chunk>();
+    }
+    return *chunk;
+}
+
+void Map::putCell(int x, int y, char symbol)
+{
+    Chunk* chunk = chunkAt(x, y);
+    if (!chunk) {
+        if (symbol == SYM_WALL) {
+            return; // Невыделенный кусок и так сплошная стена
+        }
+        chunk = &ensureChunk(x, y);
+    }
+    // Блок клеток общий с копиями карты (или это общий блок скалы) — сначала свой
+    if (chunk->cells.use_count() > 1) {
+        chunk->cells = std::make_shared<CellBlock>(*chunk->cells);
+    }
+    chunk->cells->rows[y & CHUNK_MASK][x & CHUNK_MASK] = symbol;
+}
+
+void Map::markVisibleSpan(int y, int x0, int x1)
+{
+    // Отрезок может пересекать границу кусков — ставим биты словами по каждому куску.
+    for (int x = x0; x <= x1;) {
+        const int runEnd = std::min(x1, x | CHUNK_MASK);
+        ensureChunk(x, y).visible[y & CHUNK_MASK] |= spanMask(x & CHUNK_MASK, runEnd & CHUNK_MASK);
+        x = runEnd + 1;
+    }
+}
+
+void Map::includeInVisibleArea(int minX, int minY, int maxX, int maxY)
+{
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+    if (!hasVisible) {
+        visibleMinX = minX;
+        visibleMinY = minY;
+        visibleMaxX = maxX;
+        visibleMaxY = maxY;
+        hasVisible = true;
+        return;
+    }
+    visibleMinX = std::min(visibleMinX, minX);
+    visibleMinY = std::min(visibleMinY, minY);
+    visibleMaxX = std::max(visibleMaxX, maxX);
+    visibleMaxY = std::max(visibleMaxY, maxY);
+}
+
+// Гасим видимость только внутри прямоугольника, где она могла быть.
+// Заодно переносим её в исследованность: explored |= visible, visible = 0 — один проход словами.
+// Вне прямоугольника видимых битов нет, поэтому строки обрабатываем целыми словами без масок.
+void Map::clearVisible()
+{
+    if (!hasVisible) {
+        return;
+    }
+    for (int cy = visibleMinY >> CHUNK_SHIFT; cy <= visibleMaxY >> CHUNK_SHIFT; ++cy) {
+        const int y0 = std::max(visibleMinY, cy * CHUNK_SIZE) & CHUNK_MASK;
+        const int y1 = std::min(visibleMaxY, cy * CHUNK_SIZE + CHUNK_MASK) & CHUNK_MASK;
+        for (int cx = visibleMinX >> CHUNK_SHIFT; cx <= visibleMaxX >> CHUNK_SHIFT; ++cx) {
+            if (Chunk* chunk = chunks[static_cast<size_t>(cy) * chunksX + cx].get()) {
+                mergeAndClearWords(chunk->explored + y0, chunk->visible + y0, y1 - y0 + 1);
+            }
+        }
+    }
+    hasVisible = false;
+}
+
+// --- Генерация ---
+
+void Map::generate(int currentLevel, Rng& rng)
+{
+    ASC11_TRACE_SCOPE("Map::generate");
+    lastGenTimings = MapGenTimings{};
+    GenClock::time_point stageStart = GenClock::now();
+
+    // Новая карта начинается без предметов и без выхода.
+    items.clear();
+    itemCells.clear();
+    exitPos = Position(-1, -1);
+    ++mutationCount;
+    ++visibilityVersion;
+    fovCacheValid = false;
+
+    // 0. Все клетки делаем стенами: просто освобождаем куски.
+    // Заодно сбрасываются FOV массивы (видимость и исследованность).
+    for (auto& chunk : chunks) {
+        chunk.reset();
+    }
+    hasVisible = false;
+    lastGenTimings.fovSync = takeStageMicros(stageStart, "generate.fovSync");
+
+    // Большая карта собирается из секторов размера по умолчанию (примерно 80x36):
+    // в каждом свои комнаты и коридоры, соседние секторы связаны коридорами.
+    // Карта размера по умолчанию — ровно один сектор.
+    const int sectorsX = std::max(1, width / DEFAULT_WIDTH);
+    const int sectorsY = std::max(1, height / DEFAULT_HEIGHT);
+    std::vector<Position> anchors; // Центр первой комнаты каждого сектора
+    anchors.reserve(static_cast<size_t>(sectorsX) * sectorsY);
+    for (int sy = 0; sy < sectorsY; ++sy) {
+        for (int sx = 0; sx < sectorsX; ++sx) {
+            const int x0 = sx * width / sectorsX;
+            const int y0 = sy * height / sectorsY;
+            const int x1 = (sx + 1) * width / sectorsX;
+            const int y1 = (sy + 1) * height / sectorsY;
+            anchors.push_back(generateSector(x0, y0, x1 - x0, y1 - y0, rng, stageStart));
+        }
+    }
+
+    // Соединяем соседние секторы (вправо и вниз) Г-образными коридорами
+    if (anchors.size() > 1) {
+        auto carveLink = [this](const Position& a, const Position& b) {
+            for (int x = std::min(a.x, b.x); x <= std::max(a.x, b.x); ++x)
+                putCell(x, a.y, SYM_FLOOR);
+            for (int y = std::min(a.y, b.y); y <= std::max(a.y, b.y); ++y)
+                putCell(b.x, y, SYM_FLOOR);
+        };
+        for (int sy = 0; sy < sectorsY; ++sy) {
+            for (int sx = 0; sx < sectorsX; ++sx) {
+                const Position& a = anchors[static_cast<size_t>(sy) * sectorsX + sx];
+                if (sx + 1 < sectorsX) carveLink(a, anchors[static_cast<size_t>(sy) * sectorsX + sx + 1]);
+                if (sy + 1 < sectorsY) carveLink(a, anchors[static_cast<size_t>(sy + 1) * sectorsX + sx]);
+            }
+        }
+        lastGenTimings.corridors += takeStageMicros(stageStart, "generate.corridors");
+    }
+
+    // Границы карты — стены (если они ещё не стены)
+    for (int x = 0; x < width; ++x) {
+        putCell(x, 0, SYM_WALL);
+        putCell(x, height - 1, SYM_WALL);
+    }
+    for (int y = 0; y < height; ++y) {
+        putCell(0, y, SYM_WALL);
+        putCell(width - 1, y, SYM_WALL);
+    }
+    lastGenTimings.fovSync += takeStageMicros(stageStart, "generate.fovSync");
+
+    // Добавим несколько предметов на случайные свободные клетки.
+    // На первом уровне спавнится только один случайный предмет (Medkit или MaxHP).
+    if (currentLevel == 1) {
+        // Выбираем случайный тип предмета: 0 = Medkit, 1 = MaxHP
+        int itemType = rng.below(2);
+        if (itemType == 0) {
+            // Спавним одну аптечку
+            for (int attempt = 0; attempt < 100; ++attempt) {
+                int rx = rng.below(width);
+                int ry = rng.below(height);
+                if (getCell(rx, ry) == SYM_FLOOR) {
+                    addHealItem(rx, ry, 5); // Восстанавливает 5 здоровья
+                    break;
+                }
+            }
+        } else {
+            // Спавним один MaxHP предмет
+            for (int attempt = 0; attempt < 100; ++attempt) {
+                int rx = rng.below(width);
+                int ry = rng.below(height);
+                if (getCell(rx, ry) == SYM_FLOOR) {
+                    int bonus = rng.below(5) + 1; // Бонус от 1 до 5
+                    addMaxHealthItem(rx, ry, bonus);
+                    break;
+                }
+            }
+        }
+    } else {
+        // На остальных уровнях спавнятся обычные предметы
+    const int healItemsToSpawn = 3 * static_cast<int>(anchors.size()); // По 3 на сектор
+    for (int i = 0; i < healItemsToSpawn; ++i) {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            int rx = rng.below(width);
+            int ry = rng.below(height);
+            if (getCell(rx, ry) == SYM_FLOOR) {
+                addHealItem(rx, ry, 5); // Восстанавливает 5 здоровья
+                break;
+            }
+        }
+    }
+
+    // Добавим предметы, увеличивающие максимум здоровья.
+    const int maxHpItemsToSpawn = 2 * static_cast<int>(anchors.size());
+    for (int i = 0; i < maxHpItemsToSpawn; ++i) {
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            int rx = rng.below(width);
+            int ry = rng.below(height);
+            if (getCell(rx, ry) == SYM_FLOOR) {
+                // Бонус от 1 до 5
+                int bonus = rng.below(5) + 1;
+                addMaxHealthItem(rx, ry, bonus);
+                break;
+                }
+            }
+        }
+    }
+    
+    // Добавляем выход на случайную свободную клетку (далеко от начала)
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        int rx = rng.below(width);
+        int ry = rng.below(height);
+        
+        // Выход должен быть на свободной клетке и не слишком близко к началу
+        if (getCell(rx, ry) == SYM_FLOOR && 
+            (rx > width / 2 || ry > height / 2)) {
+            addExit(rx, ry);
+            break;
+        }
+    }
+    lastGenTimings.placement = takeStageMicros(stageStart, "generate.placement");
+}
 
-void Map::generate(int currentLevel)
+
+// Один сектор карты: комнаты, преграды, коридоры и разбитые участки.
+// Координаты внутри сектора локальные, (originX, originY) — его левый верхний угол.
+// Возвращает центр первой комнаты (для связи с соседними секторами).
+Position Map::generateSector(int originX, int originY, int sectorW, int sectorH, Rng& rng,
+                             std::chrono::steady_clock::time_point& stageStart)
 {
+    auto carve = [this, originX, originY](int x, int y, char symbol) {
+        putCell(originX + x, originY + y, symbol);
+    };
+
     // --- Новый генератор комнат и коридоров для более логичной карты ---
     struct Room {
         int x1, y1, x2, y2;
@@ -28,23 +587,17 @@ void Map::generate(int currentLevel)
         int center_y() const { return (y1 + y2) / 2; }
     };
     std::vector<Room> rooms;
-    // 0. Все клетки делаем стенами
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            cells[y][x] = SYM_WALL;
-        }
-    }
     // 1. Сначала размещаем большие основные комнаты
     const int minRoomW = 8, minRoomH = 6, maxRoomW = 14, maxRoomH = 10;
-    int numBigRooms = 5 + (std::rand() % 4); // 5-8 больших комнат
+    int numBigRooms = 5 + rng.below(4); // 5-8 больших комнат
     int maxAttempts = 200;
     for (int n = 0; n < numBigRooms; ++n) {
         bool placed = false;
         for (int attempt = 0; attempt < maxAttempts && !placed; ++attempt) {
-            int w = minRoomW + std::rand() % (maxRoomW - minRoomW + 1);
-            int h = minRoomH + std::rand() % (maxRoomH - minRoomH + 1);
-            int x = 2 + std::rand() % (WIDTH - w - 3);
-            int y = 2 + std::rand() % (HEIGHT - h - 3);
+            int w = minRoomW + rng.below(maxRoomW - minRoomW + 1);
+            int h = minRoomH + rng.below(maxRoomH - minRoomH + 1);
+            int x = 2 + rng.below(sectorW - w - 3);
+            int y = 2 + rng.below(sectorH - h - 3);
             Room new_room {x, y, x + w - 1, y + h - 1};
             bool failed = false;
             for (const Room& other : rooms) {
@@ -58,7 +611,7 @@ void Map::generate(int currentLevel)
                 // Рисуем комнату: внутри всё пол
                 for (int yy = new_room.y1; yy <= new_room.y2; ++yy)
                     for (int xx = new_room.x1; xx <= new_room.x2; ++xx)
-                        cells[yy][xx] = SYM_FLOOR;
+                        carve(xx, yy, SYM_FLOOR);
                 rooms.push_back(new_room);
                 placed = true;
             }
@@ -66,14 +619,14 @@ void Map::generate(int currentLevel)
     }
     // 2. Добавляем много маленьких комнат (3-5x3-5) для разнообразия
     const int minSmallW = 3, minSmallH = 3, maxSmallW = 5, maxSmallH = 5;
-    int numSmallRooms = 10 + (std::rand() % 10); // 10-19 маленьких комнат
+    int numSmallRooms = 10 + rng.below(10); // 10-19 маленьких комнат
     for (int n = 0; n < numSmallRooms; ++n) {
         bool placed = false;
         for (int attempt = 0; attempt < 100 && !placed; ++attempt) {
-            int w = minSmallW + std::rand() % (maxSmallW - minSmallW + 1);
-            int h = minSmallH + std::rand() % (maxSmallH - minSmallH + 1);
-            int x = 1 + std::rand() % (WIDTH - w - 2);
-            int y = 1 + std::rand() % (HEIGHT - h - 2);
+            int w = minSmallW + rng.below(maxSmallW - minSmallW + 1);
+            int h = minSmallH + rng.below(maxSmallH - minSmallH + 1);
+            int x = 1 + rng.below(sectorW - w - 2);
+            int y = 1 + rng.below(sectorH - h - 2);
             Room new_room {x, y, x + w - 1, y + h - 1};
             bool failed = false;
             for (const Room& other : rooms) {
@@ -87,12 +640,14 @@ void Map::generate(int currentLevel)
                 // Рисуем маленькую комнату
                 for (int yy = new_room.y1; yy <= new_room.y2; ++yy)
                     for (int xx = new_room.x1; xx <= new_room.x2; ++xx)
-                        cells[yy][xx] = SYM_FLOOR;
+                        carve(xx, yy, SYM_FLOOR);
                 rooms.push_back(new_room);
                 placed = true;
             }
         }
     }
+    lastGenTimings.rooms += takeStageMicros(stageStart, "generate.rooms");
+
     // 3. Добавляем преграды и разрушенные участки внутри больших комнат
     for (const Room& room : rooms) {
         int roomW = room.x2 - room.x1 + 1;
@@ -100,19 +655,19 @@ void Map::generate(int currentLevel)
         // Только в больших комнатах (ширина или высота >= 8)
         if (roomW >= 8 || roomH >= 8) {
             // 30% шанс добавить преграды (столбы/разрушенные участки)
-            if (std::rand() % 100 < 30) {
-                int numObstacles = 2 + (std::rand() % 4); // 2-5 преград
+            if (rng.below(100) < 30) {
+                int numObstacles = 2 + rng.below(4); // 2-5 преград
                 for (int o = 0; o < numObstacles; ++o) {
-                    int ox = room.x1 + 2 + std::rand() % (roomW - 4);
-                    int oy = room.y1 + 2 + std::rand() % (roomH - 4);
+                    int ox = room.x1 + 2 + rng.below(roomW - 4);
+                    int oy = room.y1 + 2 + rng.below(roomH - 4);
                     // Создаём маленькую преграду (1x1 или 2x2)
-                    int obsW = 1 + (std::rand() % 2);
-                    int obsH = 1 + (std::rand() % 2);
+                    int obsW = 1 + rng.below(2);
+                    int obsH = 1 + rng.below(2);
                     for (int yy = oy; yy < oy + obsH && yy <= room.y2; ++yy) {
                         for (int xx = ox; xx < ox + obsW && xx <= room.x2; ++xx) {
                             // 50% шанс стена, 50% шанс пол (разрушенный участок остаётся проходимым)
-                            if (std::rand() % 2 == 0) {
-                                cells[yy][xx] = SYM_WALL;
+                            if (rng.below(2) == 0) {
+                                carve(xx, yy, SYM_WALL);
                             }
                         }
                     }
@@ -120,6 +675,7 @@ void Map::generate(int currentLevel)
             }
         }
     }
+    lastGenTimings.obstacles += takeStageMicros(stageStart, "generate.obstacles");
     
     // 4. Соединяем ВСЕ комнаты коридорами (короткие сегменты с препятствиями, не длинные!)
     // Сначала соединяем каждую комнату с предыдущей
@@ -131,53 +687,53 @@ void Map::generate(int currentLevel)
         int sx = prev_cx, sy = prev_cy;
         while (sx != curr_cx || sy != curr_cy) {
             // 1. Двигаем к цели по одной клетке (случайно меняем приоритет X/Y)
-            bool stepX = (sx != curr_cx) && (sy == curr_cy || std::rand() % 2 == 0);
+            bool stepX = (sx != curr_cx) && (sy == curr_cy || rng.below(2) == 0);
             if (stepX) sx += (curr_cx > sx ? 1 : -1);
             else if (sy != curr_cy) sy += (curr_cy > sy ? 1 : -1);
-            cells[sy][sx] = SYM_FLOOR;
+            carve(sx, sy, SYM_FLOOR);
             // --- Разруха/карман/боковой разлом ---
             // 70% шанс разбить коридор (боковые дыры или стенки)
-            if (std::rand() % 100 < 70) {
-                int wallOrHole = std::rand() % 4; // 0-1: дырка, 2-3: боковая стенка
-                int dx = (std::rand() % 2 == 0 ? 1 : -1), dy = 0;
-                if (std::rand() % 2) std::swap(dx, dy);
+            if (rng.below(100) < 70) {
+                int wallOrHole = rng.below(4); // 0-1: дырка, 2-3: боковая стенка
+                int dx = (rng.below(2) == 0 ? 1 : -1), dy = 0;
+                if (rng.below(2)) std::swap(dx, dy);
                 int rx = sx + dx, ry = sy + dy;
-                if (rx > 1 && rx < WIDTH-2 && ry > 1 && ry < HEIGHT-2) {
+                if (rx > 1 && rx < sectorW-2 && ry > 1 && ry < sectorH-2) {
                     if (wallOrHole < 2)
-                        cells[ry][rx] = SYM_FLOOR; // боковая дырка
+                        carve(rx, ry, SYM_FLOOR); // боковая дырка
                     else
-                        cells[ry][rx] = SYM_WALL;  // нависающая стена
+                        carve(rx, ry, SYM_WALL);  // нависающая стена
                 }
             }
             // 50% шанс добавить сбоку дополнительную мини-комнату
-            if (std::rand() % 100 < 50) {
-                int bx = sx + ((std::rand()%2) ? 2 : -2); int by = sy + ((std::rand()%2) ? 2 : -2);
-                if (bx > 2 && bx < WIDTH-2 && by > 2 && by < HEIGHT-2 && std::rand() % 3 == 0) {
-                    int bsize = 1 + std::rand() % 2;
+            if (rng.below(100) < 50) {
+                int bx = sx + (rng.below(2) ? 2 : -2); int by = sy + (rng.below(2) ? 2 : -2);
+                if (bx > 2 && bx < sectorW-2 && by > 2 && by < sectorH-2 && rng.below(3) == 0) {
+                    int bsize = 1 + rng.below(2);
                     for (int xx = bx; xx < bx+bsize; ++xx)
                         for (int yy = by; yy < by+bsize; ++yy)
-                            if (xx > 0 && xx < WIDTH && yy > 0 && yy < HEIGHT)
-                                cells[yy][xx] = SYM_FLOOR;
+                            if (xx > 0 && xx < sectorW && yy > 0 && yy < sectorH)
+                                carve(xx, yy, SYM_FLOOR);
                 }
             }
             // 20% шанс: зигзаг или поворот (делаем короткий кракозябристый поворот)
-            if (std::rand() % 100 < 20) {
-                for (int j = 0; j < 2 + std::rand() % 2; ++j) {
-                    int zigX = sx + ((std::rand()%2) ? 0 : (std::rand()%2 ? 1 : -1));
-                    int zigY = sy + ((std::rand()%2) ? 0 : (std::rand()%2 ? 1 : -1));
-                    if (zigX > 1 && zigX < WIDTH-2 && zigY > 1 && zigY < HEIGHT-2)
-                        cells[zigY][zigX] = SYM_FLOOR;
+            if (rng.below(100) < 20) {
+                for (int j = 0; j < 2 + rng.below(2); ++j) {
+                    int zigX = sx + (rng.below(2) ? 0 : (rng.below(2) ? 1 : -1));
+                    int zigY = sy + (rng.below(2) ? 0 : (rng.below(2) ? 1 : -1));
+                    if (zigX > 1 && zigX < sectorW-2 && zigY > 1 && zigY < sectorH-2)
+                        carve(zigX, zigY, SYM_FLOOR);
                 }
             }
             // 15% шанс добавить сбоку тупиковую комнату-ответвление
-            if (std::rand() % 100 < 15) {
-                int tx = sx + ((std::rand()%2) ? 1 : -1)*2;
-                int ty = sy + ((std::rand()%2) ? 1 : -1)*2;
-                if (tx > 2 && tx < WIDTH-2 && ty > 2 && ty < HEIGHT-2) {
+            if (rng.below(100) < 15) {
+                int tx = sx + (rng.below(2) ? 1 : -1)*2;
+                int ty = sy + (rng.below(2) ? 1 : -1)*2;
+                if (tx > 2 && tx < sectorW-2 && ty > 2 && ty < sectorH-2) {
                     for (int xx = tx-1; xx <= tx+1; ++xx)
                         for (int yy = ty-1; yy <= ty+1; ++yy)
-                            if (xx > 0 && xx < WIDTH && yy > 0 && yy < HEIGHT)
-                                cells[yy][xx] = SYM_FLOOR;
+                            if (xx > 0 && xx < sectorW && yy > 0 && yy < sectorH)
+                                carve(xx, yy, SYM_FLOOR);
                 }
             }
         }
@@ -187,57 +743,59 @@ void Map::generate(int currentLevel)
     }
     // Дополнительно: соединяем некоторые комнаты случайными связями для лучшей проходимости
     for (size_t i = 0; i < rooms.size() && i < 8; ++i) {
-        size_t j = std::rand() % rooms.size();
+        size_t j = rng.below(static_cast<int>(rooms.size()));
         if (i != j) {
             int cx1 = rooms[i].center_x(), cy1 = rooms[i].center_y();
             int cx2 = rooms[j].center_x(), cy2 = rooms[j].center_y();
-            if (std::rand() % 2) {
+            if (rng.below(2)) {
                 for (int x = std::min(cx1, cx2); x <= std::max(cx1, cx2); ++x)
-                    cells[cy1][x] = SYM_FLOOR;
+                    carve(x, cy1, SYM_FLOOR);
                 for (int y = std::min(cy1, cy2); y <= std::max(cy1, cy2); ++y)
-                    cells[y][cx2] = SYM_FLOOR;
+                    carve(cx2, y, SYM_FLOOR);
             } else {
                 for (int y = std::min(cy1, cy2); y <= std::max(cy1, cy2); ++y)
-                    cells[y][cx1] = SYM_FLOOR;
+                    carve(cx1, y, SYM_FLOOR);
                 for (int x = std::min(cx1, cx2); x <= std::max(cx1, cx2); ++x)
-                    cells[cy2][x] = SYM_FLOOR;
+                    carve(x, cy2, SYM_FLOOR);
             }
         }
     }
+    lastGenTimings.corridors += takeStageMicros(stageStart, "generate.corridors");
     
     // 5. Добавляем "внешнюю среду" - разбитые участки карты (как выходы наружу)
-    int numBrokenAreas = 3 + (std::rand() % 4); // 3-6 разбитых участков
+    int numBrokenAreas = 3 + rng.below(4); // 3-6 разбитых участков
     for (int b = 0; b < numBrokenAreas; ++b) {
-        int bx = 3 + std::rand() % (WIDTH - 6);
-        int by = 3 + std::rand() % (HEIGHT - 6);
-        int bw = 4 + std::rand() % 6; // 4-9 ширины
-        int bh = 4 + std::rand() % 6; // 4-9 высоты
+        int bx = 3 + rng.below(sectorW - 6);
+        int by = 3 + rng.below(sectorH - 6);
+        int bw = 4 + rng.below(6); // 4-9 ширины
+        int bh = 4 + rng.below(6); // 4-9 высоты
         
         // Создаём разбитую область с препятствиями
-        for (int yy = by; yy < by + bh && yy < HEIGHT - 1; ++yy) {
-            for (int xx = bx; xx < bx + bw && xx < WIDTH - 1; ++xx) {
+        for (int yy = by; yy < by + bh && yy < sectorH - 1; ++yy) {
+            for (int xx = bx; xx < bx + bw && xx < sectorW - 1; ++xx) {
                 // 60% пол, 40% стена (разрушенная область)
-                if (std::rand() % 100 < 60) {
-                    cells[yy][xx] = SYM_FLOOR;
+                if (rng.below(100) < 60) {
+                    carve(xx, yy, SYM_FLOOR);
                 } else {
-                    cells[yy][xx] = SYM_WALL;
+                    carve(xx, yy, SYM_WALL);
                 }
             }
         }
         // Соединяем разбитую область с ближайшей комнатой
         if (!rooms.empty()) {
-            Room nearest = rooms[std::rand() % rooms.size()];
+            Room nearest = rooms[rng.below(static_cast<int>(rooms.size()))];
             int nx = nearest.center_x();
             int ny = nearest.center_y();
             int broken_cx = bx + bw / 2;
             int broken_cy = by + bh / 2;
             // Простой коридор к разбитой области
             for (int x = std::min(nx, broken_cx); x <= std::max(nx, broken_cx); ++x)
-                cells[ny][x] = SYM_FLOOR;
+                carve(x, ny, SYM_FLOOR);
             for (int y = std::min(ny, broken_cy); y <= std::max(ny, broken_cy); ++y)
-                cells[y][broken_cx] = SYM_FLOOR;
+                carve(broken_cx, y, SYM_FLOOR);
         }
     }
+    lastGenTimings.brokenAreas += takeStageMicros(stageStart, "generate.brokenAreas");
     
     // 6. Добавляем МНОГО препятствий и разрухи в комнатах (чтобы пустые комнаты были редкостью)
     for (const Room& room : rooms) {
@@ -245,161 +803,70 @@ void Map::generate(int currentLevel)
         int roomH = room.y2 - room.y1 + 1;
         // В ВСЕХ комнатах добавляем препятствия (даже маленьких)
         // 90% шанс добавить препятствия (раньше было 70%)
-        if (std::rand() % 100 < 90) {
+        if (rng.below(100) < 90) {
             // Больше препятствий в больших комнатах
-            int numObstacles = (roomW >= 8 || roomH >= 8) ? (5 + std::rand() % 6) : (3 + std::rand() % 4); // 5-10 или 3-6
+            int numObstacles = (roomW >= 8 || roomH >= 8) ? (5 + rng.below(6)) : (3 + rng.below(4)); // 5-10 или 3-6
             for (int o = 0; o < numObstacles; ++o) {
-                int ox = room.x1 + 1 + std::rand() % (roomW - 2);
-                int oy = room.y1 + 1 + std::rand() % (roomH - 2);
+                int ox = room.x1 + 1 + rng.below(roomW - 2);
+                int oy = room.y1 + 1 + rng.below(roomH - 2);
                 // Создаём препятствие (1x1, 2x2, 3x3 или даже 4x4 для больших комнат)
                 int maxSize = (roomW >= 8 || roomH >= 8) ? 4 : 3;
-                int obsW = 1 + (std::rand() % maxSize);
-                int obsH = 1 + (std::rand() % maxSize);
+                int obsW = 1 + rng.below(maxSize);
+                int obsH = 1 + rng.below(maxSize);
                 for (int yy = oy; yy < oy + obsH && yy <= room.y2; ++yy) {
                     for (int xx = ox; xx < ox + obsW && xx <= room.x2; ++xx) {
                         // 75% шанс стена, 25% шанс пол (разрушенный участок - видно что тут была комната)
-                        if (std::rand() % 100 < 75) {
-                            cells[yy][xx] = SYM_WALL;
+                        if (rng.below(100) < 75) {
+                            carve(xx, yy, SYM_WALL);
                         }
                     }
                 }
             }
             // Дополнительно: добавляем разрушенные участки по краям комнат (как обвалившиеся стены)
-            if (std::rand() % 100 < 40) {
-                int numRubble = 2 + (std::rand() % 4);
+            if (rng.below(100) < 40) {
+                int numRubble = 2 + rng.below(4);
                 for (int r = 0; r < numRubble; ++r) {
                     // Разрушенные участки по краям
-                    int edge = std::rand() % 4; // 0=верх, 1=низ, 2=лево, 3=право
+                    int edge = rng.below(4); // 0=верх, 1=низ, 2=лево, 3=право
                     int rx, ry;
-                    if (edge == 0) { rx = room.x1 + 1 + std::rand() % (roomW - 2); ry = room.y1; }
-                    else if (edge == 1) { rx = room.x1 + 1 + std::rand() % (roomW - 2); ry = room.y2; }
-                    else if (edge == 2) { rx = room.x1; ry = room.y1 + 1 + std::rand() % (roomH - 2); }
-                    else { rx = room.x2; ry = room.y1 + 1 + std::rand() % (roomH - 2); }
-                    if (rx > 0 && rx < WIDTH - 1 && ry > 0 && ry < HEIGHT - 1) {
+                    if (edge == 0) { rx = room.x1 + 1 + rng.below(roomW - 2); ry = room.y1; }
+                    else if (edge == 1) { rx = room.x1 + 1 + rng.below(roomW - 2); ry = room.y2; }
+                    else if (edge == 2) { rx = room.x1; ry = room.y1 + 1 + rng.below(roomH - 2); }
+                    else { rx = room.x2; ry = room.y1 + 1 + rng.below(roomH - 2); }
+                    if (rx > 0 && rx < sectorW - 1 && ry > 0 && ry < sectorH - 1) {
                         // 50% шанс стена (обвалившаяся), 50% пол (разрушенный проход)
-                        cells[ry][rx] = (std::rand() % 2 == 0) ? SYM_WALL : SYM_FLOOR;
+                        carve(rx, ry, (rng.below(2) == 0) ? SYM_WALL : SYM_FLOOR);
                     }
                 }
             }
         }
     }
-    // Сбрасываем FOV массивы при генерации новой карты
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            explored[y][x] = false;
-            visible[y][x] = false;
-        }
-    }
-    
-    // Границы карты — стены (если они ещё не стены)
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            if (y == 0 || y == HEIGHT - 1 || x == 0 || x == WIDTH - 1) {
-                cells[y][x] = SYM_WALL;
-            }
-        }
-    }
-    
-    // Обновляем FOV карту на основе стен
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            bool isTransparent = !isWall(x, y);
-            bool isWalkable = !isWall(x, y);
-            fovMap.setProperties(x, y, isTransparent, isWalkable);
-        }
-    }
+    lastGenTimings.obstacles += takeStageMicros(stageStart, "generate.obstacles");
 
-    // Добавим несколько предметов на случайные свободные клетки.
-    // На первом уровне спавнится только один случайный предмет (Medkit или MaxHP).
-    if (currentLevel == 1) {
-        // Выбираем случайный тип предмета: 0 = Medkit, 1 = MaxHP
-        int itemType = std::rand() % 2;
-        if (itemType == 0) {
-            // Спавним одну аптечку
-            for (int attempt = 0; attempt < 100; ++attempt) {
-                int rx = std::rand() % WIDTH;
-                int ry = std::rand() % HEIGHT;
-                if (cells[ry][rx] == SYM_FLOOR) {
-                    addHealItem(rx, ry, 5); // Восстанавливает 5 здоровья
-                    break;
-                }
-            }
-        } else {
-            // Спавним один MaxHP предмет
-            for (int attempt = 0; attempt < 100; ++attempt) {
-                int rx = std::rand() % WIDTH;
-                int ry = std::rand() % HEIGHT;
-                if (cells[ry][rx] == SYM_FLOOR) {
-                    int bonus = (std::rand() % 5) + 1; // Бонус от 1 до 5
-                    addMaxHealthItem(rx, ry, bonus);
-                    break;
-                }
-            }
-        }
-    } else {
-        // На остальных уровнях спавнятся обычные предметы
-    const int healItemsToSpawn = 3;
-    for (int i = 0; i < healItemsToSpawn; ++i) {
-        for (int attempt = 0; attempt < 100; ++attempt) {
-            int rx = std::rand() % WIDTH;
-            int ry = std::rand() % HEIGHT;
-            if (cells[ry][rx] == SYM_FLOOR) {
-                addHealItem(rx, ry, 5); // Восстанавливает 5 здоровья
-                break;
-            }
-        }
-    }
 
-    // Добавим предметы, увеличивающие максимум здоровья.
-    const int maxHpItemsToSpawn = 2;
-    for (int i = 0; i < maxHpItemsToSpawn; ++i) {
-        for (int attempt = 0; attempt < 100; ++attempt) {
-            int rx = std::rand() % WIDTH;
-            int ry = std::rand() % HEIGHT;
-            if (cells[ry][rx] == SYM_FLOOR) {
-                // Бонус от 1 до 5
-                int bonus = (std::rand() % 5) + 1;
-                addMaxHealthItem(rx, ry, bonus);
-                break;
-                }
-            }
-        }
-    }
-    
-    // Добавляем выход на случайную свободную клетку (далеко от начала)
-    for (int attempt = 0; attempt < 200; ++attempt) {
-        int rx = std::rand() % WIDTH;
-        int ry = std::rand() % HEIGHT;
-        
-        // Выход должен быть на свободной клетке и не слишком близко к началу
-        if (cells[ry][rx] == SYM_FLOOR && 
-            (rx > WIDTH / 2 || ry > HEIGHT / 2)) {
-            addExit(rx, ry);
-            break;
-        }
+    if (rooms.empty()) {
+        return Position(originX + sectorW / 2, originY + sectorH / 2);
     }
+    return Position(originX + rooms[0].center_x(), originY + rooms[0].center_y());
 }
 
 char Map::getCell(int x, int y) const
 {
-    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
         // За пределами карты считаем стеной.
         return SYM_WALL;
     }
-    return cells[y][x];
+    const Chunk* chunk = chunkAt(x, y);
+    return chunk ? chunk->cell(x & CHUNK_MASK, y & CHUNK_MASK) : static_cast<char>(SYM_WALL);
 }
 
 void Map::setCell(int x, int y, char symbol)
 {
-    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
         return;
     }
-    cells[y][x] = symbol;
-    
-    // Обновляем FOV карту
-    bool isTransparent = !isWall(x, y);
-    bool isWalkable = !isWall(x, y);
-    fovMap.setProperties(x, y, isTransparent, isWalkable);
+    putCell(x, y, symbol);
+    ++mutationCount;
 }
 
 bool Map::isWall(int x, int y) const
@@ -415,98 +882,239 @@ bool Map::isWalkable(int x, int y) const
 
 bool Map::inBounds(int x, int y) const
 {
-    return x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT;
+    return x >= 0 && x < width && y >= 0 && y < height;
 }
 
-// FOV с использованием TCODMap (как в samples_cpp.cpp)
-void Map::computeFOV(int playerX, int playerY, int radius, bool lightWalls)
+void Map::collectFloorCells(std::vector<Position>& out) const
 {
-    // Сначала все клетки невидимы
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            visible[y][x] = false;
+    out.resize(static_cast<size_t>(getAllocatedChunkCount()) * CHUNK_SIZE * CHUNK_SIZE);
+    size_t count = 0;
+    for (int cy = 0; cy < chunksY; ++cy) {
+        for (int cx = 0; cx < chunksX; ++cx) {
+            const Chunk* chunk = chunks[static_cast<size_t>(cy) * chunksX + cx].get();
+            if (!chunk) {
+                continue; // Сплошная скала
+            }
+            const int baseX = cx * CHUNK_SIZE;
+            const int baseY = cy * CHUNK_SIZE;
+            const int rows = std::min(CHUNK_SIZE, height - baseY);
+            const int cols = std::min(CHUNK_SIZE, width - baseX);
+            const CellBlock& block = *chunk->cells;
+            for (int y = 0; y < rows; ++y) {
+                for (int x = 0; x < cols; ++x) {
+                    // Без ветвления: пол и стена перемешаны случайно, переход плохо предсказывается
+                    out[count] = Position(baseX + x, baseY + y);
+                    count += block.rows[y][x] == SYM_FLOOR ? 1 : 0;
+                }
+            }
         }
     }
+    out.resize(count);
+}
+
+bool Map::updateFOV(int playerX, int playerY, int radius, const std::vector<FovLight>& lights, bool lightWalls)
+{
+    if (fovCacheValid &&
+        fovCacheX == playerX && fovCacheY == playerY && fovCacheRadius == radius &&
+        fovCacheLightWalls == lightWalls && fovCacheMutation == mutationCount &&
+        fovCacheLights == lights) {
+        ++fovStats.cacheHits;
+        return false;
+    }
 
-    // Вычисляем FOV с помощью алгоритма libtcod
-    fovMap.computeFov(playerX, playerY, radius, lightWalls, FOV_RESTRICTIVE);
-    
-    // Отмечаем видимые клетки
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            if (fovMap.isInFov(x, y)) {
-                visible[y][x] = true;
-                explored[y][x] = true; // Если видим, то и исследовали
-            }
-        }
+    ASC11_TRACE_SCOPE("Map::updateFOV");
+    computeFOV(playerX, playerY, radius, lightWalls);
+    for (const FovLight& light : lights) {
+        addFOV(light.x, light.y, light.radius, lightWalls);
     }
+    ++fovStats.computes;
+
+    fovCacheValid = true;
+    fovCacheX = playerX;
+    fovCacheY = playerY;
+    fovCacheRadius = radius;
+    fovCacheLightWalls = lightWalls;
+    fovCacheMutation = mutationCount;
+    fovCacheLights = lights;
+    return true;
+}
+
+// Поле зрения с нуля: видимость очищается и считается от одного источника
+void Map::computeFOV(int playerX, int playerY, int radius, bool lightWalls)
+{
+    ASC11_TRACE_SCOPE("Map::computeFOV");
+    // Сначала все клетки невидимы
+    clearVisible();
+    addFOV(playerX, playerY, radius, lightWalls);
 }
 
 // Добавляет FOV от дополнительного источника света (не перезаписывает существующий FOV)
 void Map::addFOV(int sourceX, int sourceY, int radius, bool lightWalls)
 {
-    // Вычисляем FOV с помощью алгоритма libtcod (не очищаем существующий массив visible)
-    fovMap.computeFov(sourceX, sourceY, radius, lightWalls, FOV_RESTRICTIVE);
-    
-    // Добавляем видимые клетки к существующим (не перезаписываем)
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            if (fovMap.isInFov(x, y)) {
-                visible[y][x] = true; // Добавляем видимость, не перезаписываем
-                explored[y][x] = true; // Если видим, то и исследовали
+    ASC11_TRACE_SCOPE("Map::addFOV");
+    fovCacheValid = false; // Видимость меняется в обход updateFOV
+    ++visibilityVersion;
+    if (!inBounds(sourceX, sourceY)) {
+        return;
+    }
+    addFOVShadowcast(sourceX, sourceY, radius, lightWalls);
+}
+
+// Симметричный shadowcasting (как у Albert Ford, "Symmetric Shadowcasting").
+// Четыре четверти (север, восток, юг, запад), каждая — два октанта; строки идут от источника наружу,
+// пока не кончится радиус. Читает стены прямо из кусков и ставит биты visible по одной клетке,
+// поэтому работа — O(r^2) клеток внутри круга, без промежуточной карты и копирования.
+// Пол виден, только если центр клетки лежит в видимом секторе (отсюда симметрия:
+// если A видит B, то и B видит A). Стены, на которые падает сектор, видны всегда (если lightWalls).
+void Map::addFOVShadowcast(int sourceX, int sourceY, int radius, bool lightWalls)
+{
+    // Радиус 0 — без ограничения, как в libtcod
+    const bool unlimited = radius <= 0;
+    if (unlimited) {
+        radius = width + height;
+    }
+    const int r2 = radius * radius;
+
+    ensureChunk(sourceX, sourceY).visible[sourceY & CHUNK_MASK] |= uint64_t(1) << (sourceX & CHUNK_MASK);
+
+    // Четверти: клетка (depth, col) -> (x, y) = source + depth * (depthX, depthY) + col * (colX, colY)
+    static const int quadrants[4][4] = {
+        {0, -1, 1, 0}, // север
+        {1, 0, 0, 1},  // восток
+        {0, 1, 1, 0},  // юг
+        {-1, 0, 0, 1}  // запад
+    };
+    for (const auto& quadrant : quadrants) {
+        const int depthX = quadrant[0], depthY = quadrant[1];
+        const int colX = quadrant[2], colY = quadrant[3];
+        shadowRows.clear();
+        shadowRows.push_back(ShadowRow{1, -1, 1, 1, 1});
+        while (!shadowRows.empty()) {
+            ShadowRow row = shadowRows.back();
+            shadowRows.pop_back();
+            const bool lastRow = row.depth == radius; // Следующие строки уже за радиусом
+            // Крайние клетки строки: округление depth * slope к ближайшему (половинки — наружу от центра)
+            const int minCol = floorDiv(2 * row.depth * row.startNum + row.startDen, 2 * row.startDen);
+            const int maxCol = ceilDiv(2 * row.depth * row.endNum - row.endDen, 2 * row.endDen);
+            int prev = -1; // -1 — ещё ничего, 0 — пол, 1 — стена
+            for (int col = minCol; col <= maxCol; ++col) {
+                const int x = sourceX + row.depth * depthX + col * colX;
+                const int y = sourceY + row.depth * depthY + col * colY;
+                // Кусок берём один раз: и для стены, и для бита видимости. За краем карты — стена.
+                const bool inside = inBounds(x, y);
+                Chunk* chunk = inside ? chunkAt(x, y) : nullptr;
+                const bool wall = !chunk || chunk->cell(x & CHUNK_MASK, y & CHUNK_MASK) == SYM_WALL;
+                if (inside && (unlimited || col * col + row.depth * row.depth <= r2)) {
+                    const bool symmetric = col * row.startDen >= row.depth * row.startNum &&
+                                           col * row.endDen <= row.depth * row.endNum;
+                    if (wall ? lightWalls : symmetric) {
+                        if (!chunk) {
+                            chunk = &ensureChunk(x, y);
+                        }
+                        chunk->visible[y & CHUNK_MASK] |= uint64_t(1) << (x & CHUNK_MASK);
+                    }
+                }
+                // Склон через левый край клетки: (2*col - 1) / (2*depth)
+                if (prev == 1 && !wall) {
+                    // Вышли из-за стены — сектор начинается заново
+                    row.startNum = 2 * col - 1;
+                    row.startDen = 2 * row.depth;
+                }
+                if (prev == 0 && wall && !lastRow) {
+                    // Упёрлись в стену — видимая часть до неё уходит в следующую строку
+                    ShadowRow next = row;
+                    ++next.depth;
+                    next.endNum = 2 * col - 1;
+                    next.endDen = 2 * row.depth;
+                    shadowRows.push_back(next);
+                }
+                prev = wall ? 1 : 0;
+            }
+            if (prev == 0 && !lastRow) {
+                ShadowRow next = row;
+                ++next.depth;
+                shadowRows.push_back(next);
             }
         }
     }
+
+    includeInVisibleArea(std::max(0, sourceX - radius), std::max(0, sourceY - radius),
+                         std::min(width - 1, sourceX + radius), std::min(height - 1, sourceY + radius));
 }
 
 void Map::revealAll()
 {
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int x = 0; x < WIDTH; ++x) {
-            visible[y][x] = true;
-            explored[y][x] = true;
+    fovCacheValid = false;
+    ++visibilityVersion;
+    // Выделяет все куски: на огромной карте это дорого, но эффект редкий и на один ход.
+    for (int cy = 0; cy < chunksY; ++cy) {
+        for (int cx = 0; cx < chunksX; ++cx) {
+            // Исследованность догонит видимость при следующей очистке
+            fillWords(ensureChunk(cx * CHUNK_SIZE, cy * CHUNK_SIZE).visible, ~uint64_t(0), CHUNK_SIZE);
         }
     }
+    includeInVisibleArea(0, 0, width - 1, height - 1);
 }
 
 bool Map::isVisible(int x, int y) const
 {
-    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
         return false;
     }
-    return visible[y][x];
+    const Chunk* chunk = chunkAt(x, y);
+    return chunk && ((chunk->visible[y & CHUNK_MASK] >> (x & CHUNK_MASK)) & 1u);
 }
 
 bool Map::isExplored(int x, int y) const
 {
-    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+        return false;
+    }
+    const Chunk* chunk = chunkAt(x, y);
+    if (!chunk) {
         return false;
     }
-    return explored[y][x];
+    // Видимая сейчас клетка тоже исследована (см. Chunk)
+    const uint64_t row = chunk->explored[y & CHUNK_MASK] | chunk->visible[y & CHUNK_MASK];
+    return (row >> (x & CHUNK_MASK)) & 1u;
 }
 
 // Отмечаем все клетки в радиусе как \"исследованные\" (explored = true).
+// Круг заполняем по строкам: на каждой строке это один отрезок, который ставится словами.
 void Map::revealCircle(int cx, int cy, int radius)
 {
+    if (radius < 0) {
+        return;
+    }
+    fovCacheValid = false;
+    ++visibilityVersion;
     int r2 = radius * radius;
     for (int y = cy - radius; y <= cy + radius; ++y) {
-        if (y < 0 || y >= HEIGHT) continue;
-        for (int x = cx - radius; x <= cx + radius; ++x) {
-            if (x < 0 || x >= WIDTH) continue;
-            int dx = x - cx;
-            int dy = y - cy;
-            if (dx * dx + dy * dy <= r2) {
-                explored[y][x] = true;
-                visible[y][x] = true; // Также делаем видимыми (для светлячков)
-            }
+        if (y < 0 || y >= height) continue;
+        const int dy = y - cy;
+        const int rest = r2 - dy * dy;
+        // Полуширина строки: наибольшее dx, при котором dx*dx + dy*dy <= r2
+        int half = static_cast<int>(std::sqrt(static_cast<double>(rest)));
+        while (half * half > rest) --half;
+        while ((half + 1) * (half + 1) <= rest) ++half;
+        const int x0 = std::max(0, cx - half);
+        const int x1 = std::min(width - 1, cx + half);
+        if (x0 <= x1) {
+            markVisibleSpan(y, x0, x1); // Также делаем видимыми (для светлячков)
         }
     }
+    includeInVisibleArea(std::max(0, cx - radius), std::max(0, cy - radius),
+                         std::min(width - 1, cx + radius), std::min(height - 1, cy + radius));
 }
 
-void Map::addItem(int x, int y, int healAmount, int maxHealthBoost, char symbol)
+ItemHandle Map::addItem(int x, int y, int healAmount, int maxHealthBoost, char symbol)
 {
-    items.push_back(Item(x, y, healAmount, maxHealthBoost, symbol));
-    cells[y][x] = symbol;
+    removeItem(getItemAt(x, y)); // Один предмет на клетку
+    const ItemHandle handle = items.insert(Item(x, y, healAmount, maxHealthBoost, symbol));
+    itemCells[cellKey(x, y)] = handle;
+    putCell(x, y, symbol);
+    ++mutationCount;
+    return handle;
 }
 
 void Map::addHealItem(int x, int y, int healAmount)
@@ -538,30 +1146,30 @@ void Map::addQuestItem(int x, int y)
     addItem(x, y, 0, 0, SYM_QUEST);
 }
 
-Item* Map::getItemAt(int x, int y)
+ItemHandle Map::getItemAt(int x, int y) const
 {
-    for (size_t i = 0; i < items.size(); ++i) {
-        if (items[i].pos.x == x && items[i].pos.y == y) {
-            return &items[i];
-        }
+    if (!inBounds(x, y)) {
+        return ItemHandle{};
     }
-    return nullptr;
+    const auto it = itemCells.find(cellKey(x, y));
+    return it == itemCells.end() ? ItemHandle{} : it->second;
 }
 
-void Map::removeItem(int index)
+void Map::removeItem(ItemHandle handle)
 {
-    if (index >= 0 && index < static_cast<int>(items.size())) {
-        int x = items[index].pos.x;
-        int y = items[index].pos.y;
-        cells[y][x] = SYM_FLOOR; // Убираем символ предмета
-        items.erase(items.begin() + index);
+    const Item* item = items.get(handle);
+    if (item != nullptr) {
+        putCell(item->pos.x, item->pos.y, SYM_FLOOR); // Убираем символ предмета
+        itemCells.erase(cellKey(item->pos.x, item->pos.y));
+        ++mutationCount;
+        items.erase(handle);
     }
 }
 
 void Map::addExit(int x, int y)
 {
     // Лестница ставится ТОЛЬКО на пол (SYM_FLOOR), никогда на стену!
-    if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT && cells[y][x] == SYM_FLOOR) {
+    if (inBounds(x, y) && getCell(x, y) == SYM_FLOOR) {
         exitPos = Position(x, y);
         setCell(x, y, SYM_EXIT);
     }
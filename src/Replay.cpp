@@ -0,0 +1,172 @@
+#include "Replay.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace {
+const char REPLAY_MAGIC[4] = {'A', '1', '1', 'R'};
+} // namespace
+
+void Replay::startRecording(GameState& state)
+{
+    seed = state.seed;
+    mapWidth = state.map.getWidth();
+    mapHeight = state.map.getHeight();
+    actions.clear();
+    keyframes.clear();
+    finalHash = 0;
+    lastKeyframeAction = 0;
+    lastKeyframeLevel = state.levelSerial; // Начало записи восстанавливает makeGame — кадр не нужен
+    state.recording = this;
+}
+
+void Replay::record(const GameState& state, Action action)
+{
+    // Кадр — на новом этаже (в том числе после смерти) и через keyframeInterval действий.
+    // На экране выбора перка в фоне строится следующая карта — такой момент не снимаем.
+    const bool newLevel = state.levelSerial != lastKeyframeLevel;
+    const bool due = keyframeInterval > 0 && actions.size() - lastKeyframeAction >= keyframeInterval;
+    if ((newLevel || due) && !state.isPerkChoiceActive) {
+        Keyframe keyframe{static_cast<uint32_t>(actions.size()), state.level, {}};
+        ByteWriter out(keyframe.snapshot);
+        state.writeSnapshot(out);
+        keyframes.push_back(std::move(keyframe));
+        lastKeyframeAction = actions.size();
+        lastKeyframeLevel = state.levelSerial;
+    }
+    actions.push_back(action);
+}
+
+void Replay::stopRecording(GameState& state)
+{
+    if (state.recording == this) {
+        state.recording = nullptr;
+    }
+    finalHash = state.stateHash();
+}
+
+std::unique_ptr<GameState> Replay::makeGame() const
+{
+    return std::make_unique<GameState>(seed, mapWidth, mapHeight);
+}
+
+std::unique_ptr<GameState> Replay::seek(size_t actionIndex) const
+{
+    actionIndex = std::min(actionIndex, actions.size());
+    std::unique_ptr<GameState> game = makeGame();
+    size_t from = 0;
+    // Последний кадр с actionIndex <= искомого
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), actionIndex,
+                               [](size_t index, const Keyframe& keyframe) { return index < keyframe.actionIndex; });
+    if (it != keyframes.begin()) {
+        const Keyframe& keyframe = *(it - 1);
+        ByteReader in(keyframe.snapshot);
+        if (!game->readSnapshot(in)) {
+            return nullptr;
+        }
+        from = keyframe.actionIndex;
+    }
+    for (size_t i = from; i < actionIndex; ++i) {
+        step(*game, actions[i]);
+    }
+    return game;
+}
+
+bool saveReplay(const std::string& path, const Replay& replay)
+{
+    std::vector<uint8_t> data;
+    data.reserve(40 + replay.actions.size());
+    ByteWriter out(data);
+    out.bytes(REPLAY_MAGIC, 4);
+    out.u32(Replay::VERSION);
+    out.u64(replay.seed);
+    out.u32(static_cast<uint32_t>(replay.mapWidth));
+    out.u32(static_cast<uint32_t>(replay.mapHeight));
+    out.u32(static_cast<uint32_t>(replay.actions.size()));
+    for (Action action : replay.actions) {
+        out.u8(static_cast<uint8_t>(action));
+    }
+    out.u64(replay.finalHash);
+    out.u32(static_cast<uint32_t>(replay.keyframes.size()));
+    for (const Replay::Keyframe& keyframe : replay.keyframes) {
+        out.u32(keyframe.actionIndex);
+        out.i32(keyframe.level);
+        out.u32(static_cast<uint32_t>(keyframe.snapshot.size()));
+        out.bytes(keyframe.snapshot.data(), keyframe.snapshot.size());
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    return std::fclose(file) == 0 && written;
+}
+
+bool loadReplay(const std::string& path, Replay& replay)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    std::fclose(file);
+
+    if (data.size() < 4 || std::memcmp(data.data(), REPLAY_MAGIC, 4) != 0) {
+        return false;
+    }
+    ByteReader in(data.data() + 4, data.size() - 4);
+    const uint32_t version = in.u32();
+    if (version < 1 || version > Replay::VERSION) {
+        return false;
+    }
+    Replay loaded;
+    loaded.seed = in.u64();
+    const uint32_t mapWidth = in.u32();
+    const uint32_t mapHeight = in.u32();
+    if (mapWidth < 1 || mapHeight < 1 || mapWidth > Replay::MAX_MAP_SIDE || mapHeight > Replay::MAX_MAP_SIDE) {
+        return false;
+    }
+    loaded.mapWidth = static_cast<int>(mapWidth);
+    loaded.mapHeight = static_cast<int>(mapHeight);
+    const uint32_t actionCount = in.u32();
+    if (!in.ok() || in.remaining() < actionCount) {
+        return false;
+    }
+    loaded.actions.resize(actionCount);
+    for (uint32_t i = 0; i < actionCount; ++i) {
+        const uint8_t code = in.u8();
+        if (code > static_cast<uint8_t>(Action::Restart)) {
+            return false;
+        }
+        loaded.actions[i] = static_cast<Action>(code);
+    }
+    loaded.finalHash = in.u64();
+    // Версия 1 — без ключевых кадров: seek проигрывает с начала
+    const uint32_t keyframeCount = version >= 2 ? in.u32() : 0;
+    for (uint32_t n = 0; n < keyframeCount && in.ok(); ++n) {
+        Replay::Keyframe keyframe;
+        keyframe.actionIndex = in.u32();
+        keyframe.level = in.i32();
+        const uint32_t size = in.u32();
+        if (!in.ok() || in.remaining() < size || keyframe.actionIndex > actionCount ||
+            (!loaded.keyframes.empty() && keyframe.actionIndex < loaded.keyframes.back().actionIndex)) {
+            return false;
+        }
+        keyframe.snapshot.resize(size);
+        in.bytes(keyframe.snapshot.data(), size);
+        loaded.keyframes.push_back(std::move(keyframe));
+    }
+    if (!in.ok()) {
+        return false;
+    }
+    replay = std::move(loaded);
+    return true;
+}
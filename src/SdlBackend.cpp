@@ -0,0 +1,174 @@
+#include "RenderBackend.h"
+
+#include <SDL2/SDL.h>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+SdlBackend::SdlBackend(std::string windowTitle)
+    : title(std::move(windowTitle))
+{
+}
+
+void SdlBackend::open(tcod::Console& console)
+{
+    // Создаем контекст окна (как в samples_cpp.cpp)
+    TCOD_ContextParams params{};
+    params.tcod_version = TCOD_COMPILEDVERSION;
+    params.console = console.get();
+    params.window_title = title.c_str();
+    params.vsync = true;
+    params.argc = 0;
+    params.argv = nullptr;
+    // Используем SDL2 рендерер по умолчанию (как в samples)
+    params.renderer_type = TCOD_RENDERER_SDL2;
+    
+    // ПОЛНОСТЬЮ ОТКЛЮЧАЕМ кастомный tileset - используем только стандартный встроенный libtcod
+    // Кастомный PNG tileset (terminal12x12_gs_ro.png) не соответствует стандартному CP437 порядку
+    // и вызывает "кракозябры" при отображении символов
+    // Стандартный tileset libtcod гарантированно работает правильно с CP437 символами
+    // Без установки params.tileset libtcod использует стандартный встроенный tileset
+
+    context = tcod::new_context(params);
+    
+    if (!context) {
+        throw std::runtime_error("Failed to create context");
+    }
+
+    // Включаем полноэкранный режим. Масштабирование и отрисовку оставляем libtcod/SDL,
+    // чтобы клетки оставались квадратными и интерфейс выглядел так же, как в оконном режиме.
+    if (auto sdl_window = context->get_sdl_window()) {
+        SDL_SetWindowFullscreen(sdl_window, SDL_WINDOW_FULLSCREEN_DESKTOP);
+    }
+}
+
+void SdlBackend::present(tcod::Console& console)
+{
+    context->present(console);
+}
+
+bool SdlBackend::pollKey(int& key)
+{
+    // Обрабатываем все события SDL (включая закрытие окна) - НЕБЛОКИРУЮЩИЙ ввод!
+    SDL_Event ev;
+    while (SDL_PollEvent(&ev)) {
+        if (ev.type == SDL_QUIT) {
+            key = TCODK_ESCAPE;
+            return true;
+        }
+        // Обрабатываем нажатия клавиш через SDL
+        if (ev.type == SDL_KEYDOWN) {
+            SDL_Keycode sym = ev.key.keysym.sym;
+            SDL_Keymod mod = static_cast<SDL_Keymod>(ev.key.keysym.mod);
+            
+            // F11 для полноэкранного режима
+            if (sym == SDLK_F11) {
+                key = TCODK_F11;
+                return true;
+            }
+            // F3 — оверлей профайлера, F9 — сброс трассы в файл
+            if (sym == SDLK_F3) {
+                key = TCODK_F3;
+                return true;
+            }
+            if (sym == SDLK_F9) {
+                key = TCODK_F9;
+                return true;
+            }
+            
+            // ESC
+            if (sym == SDLK_ESCAPE) {
+                key = TCODK_ESCAPE;
+                return true;
+            }
+            
+            // Стрелки
+            if (sym == SDLK_UP) {
+                key = TCODK_UP;
+                return true;
+            }
+            if (sym == SDLK_DOWN) {
+                key = TCODK_DOWN;
+                return true;
+            }
+            if (sym == SDLK_LEFT) {
+                key = TCODK_LEFT;
+                return true;
+            }
+            if (sym == SDLK_RIGHT) {
+                key = TCODK_RIGHT;
+                return true;
+            }
+            
+            // Буквы и цифры (только если не зажаты модификаторы)
+            if ((mod & (KMOD_CTRL | KMOD_ALT | KMOD_GUI)) == 0) {
+                if (sym >= SDLK_a && sym <= SDLK_z) {
+                    // SDL использует только строчные коды для букв
+                    // Если зажат Shift, преобразуем в заглавную букву
+                    if (mod & KMOD_SHIFT) {
+                        key = 'A' + (sym - SDLK_a); // Преобразуем в заглавную ('A'-'Z')
+                    } else {
+                        key = static_cast<int>(sym); // SDLK_a = 97 = 'a', SDLK_b = 98 = 'b' и т.д.
+                    }
+                    return true;
+                }
+                // Обрабатываем цифры 0-9 (явно преобразуем в символы для надёжности)
+                if (sym >= SDLK_0 && sym <= SDLK_9) {
+                    key = '0' + (sym - SDLK_0); // Гарантируем символ '0'-'9'
+                    return true;
+                }
+            }
+        }
+    }
+    
+    // Также проверяем через libtcod (на случай если SDL не поймал)
+    TCOD_key_t k = TCOD_console_check_for_keypress(TCOD_KEY_PRESSED);
+    if (k.vk != TCODK_NONE) {
+    if (k.vk == TCODK_F11) {
+        key = TCODK_F11;
+        return true;
+    }
+    if (k.c != 0) {
+            // Преобразуем символ в нижний регистр для единообразия ('F' -> 'f')
+            key = (k.c >= 'A' && k.c <= 'Z') ? (k.c + 32) : k.c;
+        return true;
+    }
+    key = k.vk;
+        return true;
+    }
+    
+    return false; // Ничего не нажато - НЕ БЛОКИРУЕМ, просто возвращаем false
+}
+
+bool SdlBackend::mouseTile(int& consoleX, int& consoleY)
+{
+    int mouseX, mouseY;
+    SDL_GetMouseState(&mouseX, &mouseY);
+    
+    // Конвертируем координаты мыши в координаты консоли через context
+    // Используем явное указание типа для устранения неоднозначности
+    std::array<double, 2> pixelPos = {static_cast<double>(mouseX), static_cast<double>(mouseY)};
+    auto mouseTile = context->pixel_to_tile_coordinates(pixelPos);
+    consoleX = static_cast<int>(mouseTile[0]);
+    consoleY = static_cast<int>(mouseTile[1]);
+    return true;
+}
+
+uint32_t SdlBackend::ticks()
+{
+    // SDL_GetTicks() для надежного измерения времени (работает каждый кадр!)
+    return SDL_GetTicks();
+}
+
+// Переключение полноэкранного режима
+void SdlBackend::toggleFullscreen()
+{
+    // Получаем SDL окно через libtcod API
+    auto sdl_window = context->get_sdl_window();
+    if (sdl_window) {
+        // Используем SDL2 функции для переключения полноэкранного режима
+        const auto flags = SDL_GetWindowFlags(sdl_window);
+        const bool is_fullscreen = (flags & SDL_WINDOW_FULLSCREEN) != 0;
+        SDL_SetWindowFullscreen(sdl_window, is_fullscreen ? 0 : SDL_WINDOW_FULLSCREEN_DESKTOP);
+    }
+}
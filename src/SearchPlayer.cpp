@@ -0,0 +1,208 @@
+#include "SearchPlayer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+// Ходы дерева: ожидание и восемь шагов (шаг на моба — удар). Перки и рестарт поиск не выбирает.
+const int SEARCH_ACTION_COUNT = 9;
+constexpr Action SEARCH_ACTIONS[SEARCH_ACTION_COUNT] = {Action::Wait,      MOVE_ACTIONS[0], MOVE_ACTIONS[1],
+                                                        MOVE_ACTIONS[2],   MOVE_ACTIONS[3], MOVE_ACTIONS[4],
+                                                        MOVE_ACTIONS[5],   MOVE_ACTIONS[6], MOVE_ACTIONS[7]};
+
+const double EXPLORATION = 1.41421356; // Константа UCB1 (sqrt(2) для оценок от 0 до 1)
+const int ROLLOUT_RANDOM_PERCENT = 20; // Доля случайных ходов в откате, иначе откаты одного узла одинаковы
+const double ALIVE_VALUE = 0.8;        // Оценка живого игрока с полным здоровьем (лестница — 1)
+const double GUIDE_MARGIN = 0.05;      // Насколько лучший ход должен обогнать ход guide, чтобы его заменить
+
+// Сдвиги шагов SEARCH_ACTIONS[1..8] — в порядке MOVE_ACTIONS.
+const int STEP_DIRS[8][2] = {{0, -1}, {-1, 0}, {0, 1}, {1, 0}, {-1, -1}, {1, -1}, {-1, 1}, {1, 1}};
+
+// Шаг в стену или за край карты без моба на пути. step его принимает и играет как ход на месте
+// (мобы ходят, щит тратится), поэтому отдельной вершиной он только делил бы посещения с Wait.
+bool isWallBump(const GameState& state, int action)
+{
+    if (action == 0) {
+        return false;
+    }
+    int dx = STEP_DIRS[action - 1][0];
+    int dy = STEP_DIRS[action - 1][1];
+    if (state.isPlayerControlsInverted) {
+        dx = -dx;
+        dy = -dy;
+    }
+    const int x = state.player.pos.x + dx;
+    const int y = state.player.pos.y + dy;
+    if (!state.map.inBounds(x, y)) {
+        return true;
+    }
+    return state.enemyAt(x, y) < 0 && !state.map.isWalkable(x, y) && !state.map.isExit(x, y);
+}
+
+// Откат кончается смертью или экраном перка (игрок дошёл до лестницы).
+bool isFinished(const GameState& state)
+{
+    return state.isDeathScreenActive || state.isPerkChoiceActive;
+}
+} // namespace
+
+SearchPlayer::SearchPlayer(uint64_t seed, int iterations_, int rolloutDepth_, int perkChoice_)
+    : iterations(iterations_),
+      rolloutDepth(rolloutDepth_),
+      rng(seed, 78),
+      guide(seed, perkChoice_),
+      rolloutBot(seed, perkChoice_)
+{
+}
+
+bool SearchPlayer::enemyNear(const GameState& state) const
+{
+    const EnemyStore& enemies = state.enemies;
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        if (enemies.isAlive(i) && std::abs(enemies.x[i] - state.player.pos.x) <= SEARCH_RADIUS &&
+            std::abs(enemies.y[i] - state.player.pos.y) <= SEARCH_RADIUS) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double SearchPlayer::evaluate() const
+{
+    const GameState& state = *scratch;
+    if (state.isDeathScreenActive) {
+        return 0.0;
+    }
+    if (state.isPerkChoiceActive) {
+        return 1.0;
+    }
+    return ALIVE_VALUE * state.player.health / static_cast<double>(std::max(1, state.player.maxHealth));
+}
+
+double SearchPlayer::rollout()
+{
+    ++rolloutCount;
+    // Бот отката начинает с того, что guide знает об этаже
+    rolloutBot = guide;
+    GameState& state = *scratch;
+    for (int turn = 0; turn < rolloutDepth && !isFinished(state); ++turn) {
+        Action action = rolloutBot.next(state);
+        if (rng.below(100) < ROLLOUT_RANDOM_PERCENT) {
+            action = SEARCH_ACTIONS[rng.below(SEARCH_ACTION_COUNT)];
+        }
+        step(state, action);
+    }
+    return evaluate();
+}
+
+int32_t SearchPlayer::expand(int32_t node)
+{
+    while (nodes[static_cast<size_t>(node)].tried < SEARCH_ACTION_COUNT) {
+        const int action = nodes[static_cast<size_t>(node)].tried++;
+        // Проверяем до step: после него scratch уже не состояние вершины
+        if (isWallBump(*scratch, action)) {
+            nodes[static_cast<size_t>(node)].children[action] = Node::ILLEGAL;
+            continue;
+        }
+        step(*scratch, SEARCH_ACTIONS[action]);
+        const int32_t child = static_cast<int32_t>(nodes.size());
+        nodes.emplace_back();
+        nodes[static_cast<size_t>(node)].children[action] = child;
+        return child;
+    }
+    return -1;
+}
+
+int SearchPlayer::selectAction(int32_t node) const
+{
+    const Node& parent = nodes[static_cast<size_t>(node)];
+    const double logVisits = std::log(static_cast<double>(std::max(1, parent.visits)));
+    int best = -1;
+    double bestScore = 0.0;
+    for (int action = 0; action < SEARCH_ACTION_COUNT; ++action) {
+        const int32_t child = parent.children[action];
+        if (child < 0) {
+            continue;
+        }
+        const Node& candidate = nodes[static_cast<size_t>(child)];
+        const double visits = static_cast<double>(std::max(1, candidate.visits));
+        const double score = candidate.valueSum / visits + EXPLORATION * std::sqrt(logVisits / visits);
+        if (best < 0 || score > bestScore) {
+            best = action;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+Action SearchPlayer::next(const GameState& state)
+{
+    // guide видит каждый ход, чтобы помнить, где бот уже был
+    const Action guided = guide.next(state);
+    if (state.isDeathScreenActive || state.isPerkChoiceActive || state.isPlayerControlsInverted || !enemyNear(state)) {
+        return guided;
+    }
+
+    ++searchCount;
+    if (!scratch) {
+        scratch = std::make_unique<GameState>(state);
+        ++cloneCount;
+    }
+    nodes.clear();
+    nodes.emplace_back();
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        // Ходы детерминированы (все случайности — потоки Rng в состоянии), поэтому путь по дереву
+        // из копии корня приводит ровно в те состояния, в которых вершины заводились
+        *scratch = state;
+        ++cloneCount;
+        path.clear();
+        path.push_back(0);
+        int32_t node = 0;
+        while (!isFinished(*scratch)) {
+            const int32_t child = expand(node);
+            if (child >= 0) {
+                path.push_back(child);
+                break;
+            }
+            const int action = selectAction(node);
+            if (action < 0) {
+                break;
+            }
+            step(*scratch, SEARCH_ACTIONS[action]);
+            node = nodes[static_cast<size_t>(node)].children[action];
+            path.push_back(node);
+        }
+        const double value = rollout();
+        for (int32_t visited : path) {
+            ++nodes[static_cast<size_t>(visited)].visits;
+            nodes[static_cast<size_t>(visited)].valueSum += value;
+        }
+    }
+
+    int best = -1;
+    int bestVisits = 0;
+    for (int action = 0; action < SEARCH_ACTION_COUNT; ++action) {
+        const int32_t child = nodes[0].children[action];
+        if (child >= 0 && nodes[static_cast<size_t>(child)].visits > bestVisits) {
+            best = action;
+            bestVisits = nodes[static_cast<size_t>(child)].visits;
+        }
+    }
+    if (best < 0) {
+        return guided;
+    }
+    // Оценка не знает, насколько игрок продвинулся по этажу, поэтому ход guide (он ведёт к лестнице)
+    // уступает только заметно лучшему: иначе бот топчется у мобов, которые ему не опасны
+    for (int action = 0; action < SEARCH_ACTION_COUNT; ++action) {
+        const int32_t child = nodes[0].children[action];
+        if (SEARCH_ACTIONS[action] == guided && child >= 0 && nodes[static_cast<size_t>(child)].visits > 0) {
+            const Node& guidedNode = nodes[static_cast<size_t>(child)];
+            const Node& bestNode = nodes[static_cast<size_t>(nodes[0].children[best])];
+            if (guidedNode.valueSum / guidedNode.visits >= bestNode.valueSum / bestNode.visits - GUIDE_MARGIN) {
+                return guided;
+            }
+        }
+    }
+    return SEARCH_ACTIONS[best];
+}
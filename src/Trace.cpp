@@ -0,0 +1,109 @@
+#include "Trace.h"
+
+#if defined(ASC11_ENABLE_TRACE)
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace {
+// Степень двойки: слот — младшие биты номера события
+const uint64_t TRACE_CAPACITY = uint64_t(1) << 16;
+
+// Слот кольца. sequence = номер события + 1, когда слот дописан; 0 — пишется прямо сейчас.
+// Читатель сверяет sequence до и после копирования полей (как seqlock), поэтому
+// событие, которое перезаписали во время flush, просто пропускается.
+// Поля атомарные (relaxed), чтобы одновременная запись и чтение не были гонкой данных.
+struct TraceSlot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint32_t> thread{0};
+    std::atomic<int64_t> startNs{0};
+    std::atomic<int64_t> endNs{0};
+};
+
+struct TraceEvent {
+    const char* name;
+    uint32_t thread;
+    int64_t startNs;
+    int64_t endNs;
+};
+
+TraceSlot ring[TRACE_CAPACITY];
+std::atomic<uint64_t> head{0};
+std::atomic<uint32_t> threadCount{0};
+const trace::Clock::time_point traceEpoch = trace::Clock::now();
+
+// Номер дорожки потока в трассе: 1, 2, ... в порядке первого события
+uint32_t currentThread()
+{
+    thread_local const uint32_t id = threadCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    return id;
+}
+
+int64_t sinceEpochNs(trace::Clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - traceEpoch).count();
+}
+} // namespace
+
+namespace trace {
+
+void record(const char* name, Clock::time_point start, Clock::time_point end)
+{
+    const uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    TraceSlot& slot = ring[index & (TRACE_CAPACITY - 1)];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.thread.store(currentThread(), std::memory_order_relaxed);
+    slot.startNs.store(sinceEpochNs(start), std::memory_order_relaxed);
+    slot.endNs.store(sinceEpochNs(end), std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+bool flush(const char* path)
+{
+    std::vector<TraceEvent> events;
+    events.reserve(static_cast<size_t>(std::min(head.load(std::memory_order_acquire), TRACE_CAPACITY)));
+    for (TraceSlot& slot : ring) {
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before == 0) {
+            continue;
+        }
+        TraceEvent event;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.thread = slot.thread.load(std::memory_order_relaxed);
+        event.startNs = slot.startNs.load(std::memory_order_relaxed);
+        event.endNs = slot.endNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before && event.name) {
+            events.push_back(event);
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+        return a.startNs < b.startNs;
+    });
+
+    std::FILE* file = std::fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    // Полные события ("ph":"X"): начало и длительность в микросекундах
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent& event = events[i];
+        std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                     event.name, event.thread, static_cast<double>(event.startNs) / 1000.0,
+                     static_cast<double>(event.endNs - event.startNs) / 1000.0,
+                     i + 1 < events.size() ? "," : "");
+    }
+    std::fprintf(file, "]}\n");
+    return std::fclose(file) == 0;
+}
+
+} // namespace trace
+
+#endif